@@ -0,0 +1,119 @@
+#ifndef ACTIVATION_KERNELS_H
+#define ACTIVATION_KERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "fast_math.h"
+
+/**
+ * @brief 内置逐元素激活函数内核（MLP / CNN / Attention 共用）
+ *
+ * 每个内核提供:
+ *   f(x)           前向激活
+ *   df(x)          对预激活值 x 的导数
+ *   dfFromOutput(y) 仅由输出 y 求导（仅 hasOutputDerivative 为 true 的内核提供，
+ *                   GELU 等没有此函数，误用时编译失败）
+ *
+ * 内核均为静态内联函数，通过模板参数传给 activationForward/activationBackward，
+ * 循环中没有间接调用，编译器可以内联并向量化。含 exp/tanh 的内核按
+ * MathPrecision 模板化（见 fast_math.h），默认别名使用 libm 精确版本。
+ */
+
+struct IdentityKernel {
+    static constexpr bool hasOutputDerivative = true;
+    static double f(double x) { return x; }
+    static double df(double /*x*/) { return 1.0; }
+    static double dfFromOutput(double /*y*/) { return 1.0; }
+};
+
+struct ReLUKernel {
+    static constexpr bool hasOutputDerivative = true;
+    static double f(double x) { return x > 0.0 ? x : 0.0; }
+    static double df(double x) { return x > 0.0 ? 1.0 : 0.0; }
+    static double dfFromOutput(double y) { return y > 0.0 ? 1.0 : 0.0; }
+};
+
+struct LeakyReLUKernel {
+    static constexpr bool hasOutputDerivative = true;
+    static constexpr double slope = 0.01;
+    static double f(double x) { return x > 0.0 ? x : slope * x; }
+    static double df(double x) { return x > 0.0 ? 1.0 : slope; }
+    static double dfFromOutput(double y) { return y > 0.0 ? 1.0 : slope; }
+};
+
+template <MathPrecision P>
+struct SigmoidKernelT {
+    static constexpr bool hasOutputDerivative = true;
+    static double f(double x) { return sigmoidApprox<P>(x); }
+    static double df(double x) {
+        const double s = f(x);
+        return s * (1.0 - s);
+    }
+    static double dfFromOutput(double y) { return y * (1.0 - y); }
+};
+
+template <MathPrecision P>
+struct TanhKernelT {
+    static constexpr bool hasOutputDerivative = true;
+    static double f(double x) { return tanhApprox<P>(x); }
+    static double df(double x) {
+        const double t = tanhApprox<P>(x);
+        return 1.0 - t * t;
+    }
+    static double dfFromOutput(double y) { return 1.0 - y * y; }
+};
+
+// GELU（tanh 近似）: 0.5 x (1 + tanh(sqrt(2/pi) (x + 0.044715 x^3)))
+template <MathPrecision P>
+struct GELUKernelT {
+    static constexpr bool hasOutputDerivative = false;
+    static constexpr double kAlpha = 0.7978845608028654;  // sqrt(2/pi)
+    static constexpr double kBeta = 0.044715;
+    static double f(double x) {
+        return 0.5 * x * (1.0 + tanhApprox<P>(kAlpha * (x + kBeta * x * x * x)));
+    }
+    static double df(double x) {
+        const double t = tanhApprox<P>(kAlpha * (x + kBeta * x * x * x));
+        return 0.5 * (1.0 + t) + 0.5 * x * (1.0 - t * t) * kAlpha * (1.0 + 3.0 * kBeta * x * x);
+    }
+};
+
+using SigmoidKernel = SigmoidKernelT<MathPrecision::Exact>;
+using TanhKernel = TanhKernelT<MathPrecision::Exact>;
+using GELUKernel = GELUKernelT<MathPrecision::Exact>;
+
+// ========== 批量内核 ==========
+
+/**
+ * @brief y[i] = f(x[i])，x 与 y 可以是同一缓冲区
+ */
+template <typename Kernel>
+inline void activationForward(const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = Kernel::f(x[i]);
+    }
+}
+
+/**
+ * @brief dx[i] = dy[i] * f'(x[i])，x 为预激活值
+ */
+template <typename Kernel>
+inline void activationBackward(const double* x, const double* dy, double* dx, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dx[i] = dy[i] * Kernel::df(x[i]);
+    }
+}
+
+/**
+ * @brief dx[i] = dy[i] * f'(y[i])，y 为激活后的输出
+ */
+template <typename Kernel>
+inline void activationBackwardFromOutput(const double* y, const double* dy, double* dx, size_t n) {
+    static_assert(Kernel::hasOutputDerivative, "Activation derivative requires pre-activation values");
+    for (size_t i = 0; i < n; ++i) {
+        dx[i] = dy[i] * Kernel::dfFromOutput(y[i]);
+    }
+}
+
+#endif // ACTIVATION_KERNELS_H
@@ -1,34 +1,95 @@
 #ifndef ATTENTION_LAYER_H
 #define ATTENTION_LAYER_H
 
-#include "cnn/tensor.h"
+#include "attention/attention_layer_base.h"
 #include <cmath>
+#include <vector>
 
-class AttentionLayer {
+/**
+ * Multi-head scaled dot-product self-attention.
+ *
+ * d_k is the total projection width; it is split evenly into num_heads heads of
+ * d_k / num_heads columns each (see AttentionLayerBase). Q, K and V come from one packed projection
+ * W_QKV (d_model x 3*d_k), laid out as [Q | K | V] with heads contiguous inside
+ * each block, so the projection is a single GEMM. Heads run in parallel on the
+ * global thread pool when the work is large enough to pay for the dispatch.
+ *
+ * Attention itself is tiled (flash-style): each query row streams K/V in blocks
+ * of kTile rows with an online softmax, so the L x L score matrix is never
+ * stored. Only the per-row log-sum-exp is kept; backward recomputes the
+ * probabilities block by block from it. The full weight matrix is built lazily
+ * on the first getWeights()/getHeadWeights() call after a forward pass.
+ *
+ * For incremental decoding, forwardIncremental() projects only the new rows,
+ * appends their keys/values to a growing KV cache and attends causally over
+ * everything cached, so appending one token costs O(L) instead of O(L^2).
+ * Its outputs match forward() on the full sequence when causal masking is on.
+ * With a cache window the KV cache becomes a fixed-size ring buffer, so a stream
+ * of any length runs in bounded memory.
+ *
+ * An AttentionPattern restricts each query row to a sparse set of keys; the
+ * kernels walk only those keys, so a fixed window costs O(L) per head.
+ */
+class AttentionLayer : public AttentionLayerBase {
 public:
-    AttentionLayer(size_t d_model, size_t d_k);
+    // Number of key/value rows streamed per tile
+    static constexpr size_t kTile = 32;
 
-    Tensor forward(const Tensor& input); // Input: (1, SeqLen, D_model)
-    Tensor backward(const Tensor& gradOutput, double learningRate);
+    AttentionLayer(size_t d_model, size_t d_k, size_t num_heads = 1);
 
-    // Visualization getters
-    const Tensor& getQ() const { return Q_; }
-    const Tensor& getK() const { return K_; }
-    const Tensor& getV() const { return V_; }
-    const Tensor& getWeights() const { return attentionWeights_; }
+    AttentionType type() const override { return AttentionType::Softmax; }
 
-private:
-    size_t d_model_;
-    size_t d_k_;
+    Tensor forward(const Tensor& input, const std::vector<size_t>& lengths = {}) override;
+    Tensor backward(const Tensor& gradOutput, double learningRate) override;
+
+    // Projects only the new rows and attends over the KV cache
+    Tensor forwardIncremental(const Tensor& newRows) override;
+    void resetCache() override { cacheLen_ = 0; }
+    size_t cachedLength() const override { return cacheLen_; }
+
+    // Sparse pattern for forward()/backward()/forwardIncremental(); throws if dilation is 0
+    void setPattern(const AttentionPattern& pattern) override;
 
+    TensorView getQ() const override { return projection(0); }
+    TensorView getK() const override { return projection(1); }
+    TensorView getV() const override { return projection(2); }
+    const Tensor& getWeights() const override;
+
+private:
     // Weights
-    Tensor W_Q_, W_K_, W_V_, W_O_;
+    Tensor W_QKV_; // (1, D_model, 3 * D_k)
+    Tensor W_O_;   // (1, D_k, D_model)
+
+    // Cache for backward/viz; the batch is folded into rows (row = b * L + i)
+    Tensor input_;   // (1, B * L, D_model)
+    Tensor QKV_;     // (1, B * L, 3 * D_k)
+    Tensor context_; // (1, B * L, D_k), heads concatenated
+    Tensor lse_;     // (NumHeads, B * L, 1), log-sum-exp of each score row
+
+    // Visualization only, rebuilt from QKV_ and lse_ when stale
+    mutable Tensor attentionWeights_;
+    mutable bool weightsStale_ = true;
+
+    // KV cache for incremental decoding: rows [K | V], (1, capacity, 2 * D_k).
+    // With a cache window it is a ring buffer of cacheWindow_ rows, slot = position % window.
+    Tensor kvCache_;
+    size_t cacheLen_ = 0;
+    void reserveCache(size_t rows);
+
+    // Rotates the Q and K blocks of one packed row by its position's angles, a row of the
+    // sinusoidal table (inverse = R^T, for gradients)
+    void rotateQK(double* row, const double* angles, bool inverse) const;
+
+    // Columns [block * D_k, (block + 1) * D_k) of QKV_, optionally narrowed to one head
+    TensorView projection(size_t block) const;
+    TensorView headProjection(size_t block, size_t head) const;
+
+    // Multiply-adds of one forward over the cached batch, for the parallel cutoff
+    size_t headWork() const;
 
-    // Cache for backward/viz
-    Tensor input_;
-    Tensor Q_, K_, V_;
-    Tensor scores_;     // Before softmax
-    Tensor attentionWeights_; // After softmax
+    // Tiled kernels for one (sequence, head) unit
+    void forwardHead(size_t unit);
+    void backwardHead(size_t unit, const Tensor& dContext, Tensor& dQKV) const;
 };
 
 #endif // ATTENTION_LAYER_H
@@ -0,0 +1,129 @@
+#ifndef ATTENTION_LAYER_BASE_H
+#define ATTENTION_LAYER_BASE_H
+
+#include "cnn/tensor.h"
+#include "cnn/tensor_view.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum class AttentionType {
+    Softmax, // Scaled dot-product attention, O(L^2 d) (AttentionLayer)
+    Linear   // Kernelized attention with an elu + 1 feature map, O(L d^2) (LinearAttentionLayer)
+};
+
+/**
+ * Sparse attention pattern, applied on top of the causal and padding masks.
+ *
+ * Query i sees the local keys i + m * dilation for |m| <= window (window 0 means
+ * unbounded, so dilation alone gives a strided pattern over the whole sequence).
+ * The first globalTokens positions attend to every key and every query attends
+ * to them. The default pattern is dense.
+ */
+struct AttentionPattern {
+    size_t window = 0;
+    size_t dilation = 1;
+    size_t globalTokens = 0;
+
+    static AttentionPattern dense() { return {}; }
+    static AttentionPattern slidingWindow(size_t window) { return {window, 1, 0}; }
+    static AttentionPattern dilated(size_t window, size_t dilation) { return {window, dilation, 0}; }
+    static AttentionPattern windowWithGlobal(size_t window, size_t globalTokens) { return {window, 1, globalTokens}; }
+
+    bool isDense() const { return window == 0 && dilation == 1; }
+    // Whether query i may attend key j under this pattern alone
+    bool allows(size_t i, size_t j) const;
+};
+
+/**
+ * Common interface of the multi-head self-attention variants used by TransformerBlock.
+ *
+ * d_k is the total projection width, split evenly into num_heads heads. Inputs are
+ * (B, SeqLen, D_model) with the batch folded into rows (row = b * L + i); lengths[b]
+ * gives the valid prefix of each sequence, the rest is padding (masked as keys, zero
+ * output). The visualization getters describe the first sequence of the last batch.
+ */
+class AttentionLayerBase {
+public:
+    AttentionLayerBase(size_t d_model, size_t d_k, size_t num_heads);
+    virtual ~AttentionLayerBase() = default;
+
+    virtual AttentionType type() const = 0;
+
+    // Input: (B, SeqLen, D_model); lengths empty = all full length
+    virtual Tensor forward(const Tensor& input, const std::vector<size_t>& lengths = {}) = 0;
+    virtual Tensor backward(const Tensor& gradOutput, double learningRate) = 0;
+
+    // Incremental decoding: newRows (1, T, D_model) continue the cached sequence (always causal)
+    virtual Tensor forwardIncremental(const Tensor& newRows) = 0;
+    virtual void resetCache() = 0;
+    // Positions consumed by forwardIncremental() since the last reset
+    virtual size_t cachedLength() const = 0;
+
+    // Bounded incremental context for unbounded streams: with window > 0 only the last
+    // window positions stay cached (a ring buffer), so memory no longer grows with the
+    // stream. 0 (default) keeps everything. Resets the cache. Linear attention's running
+    // sums are already constant-size and cover the whole stream, so it ignores the window.
+    void setCacheWindow(size_t window) {
+        cacheWindow_ = window;
+        resetCache();
+    }
+    size_t cacheWindow() const { return cacheWindow_; }
+
+    // Causal masking for forward()/backward(): position i attends to j <= i only
+    void setCausal(bool causal) { causal_ = causal; }
+    bool isCausal() const { return causal_; }
+
+    // Rotary positional encoding (RoPE) and sparse patterns; variants that cannot
+    // honour them throw std::invalid_argument
+    virtual void setRotary(bool rotary);
+    bool isRotary() const { return rotary_; }
+    virtual void setPattern(const AttentionPattern& pattern);
+    const AttentionPattern& pattern() const { return pattern_; }
+    // Whether query i attends key j under the pattern and causal mask (padding not included)
+    bool attends(size_t i, size_t j) const { return (!causal_ || j <= i) && pattern_.allows(i, j); }
+
+    // exp 的计算精度（见 fast_math.h）
+    void setMathPrecision(MathPrecision precision) { precision_ = precision; }
+
+    size_t numHeads() const { return num_heads_; }
+    size_t headDim() const { return d_head_; }
+
+    // Views into the packed projection cache, (1, SeqLen, D_k)
+    virtual TensorView getQ() const = 0;
+    virtual TensorView getK() const = 0;
+    virtual TensorView getV() const = 0;
+    // Attention weights of all heads, (NumHeads, SeqLen, SeqLen); materialized on demand.
+    // Not thread-safe against a concurrent forward (callers hold the network mutex).
+    virtual const Tensor& getWeights() const = 0;
+    TensorView getHeadWeights(size_t head) const { return TensorView(getWeights()).channel(head); }
+
+protected:
+    size_t d_model_;
+    size_t d_k_;
+    size_t num_heads_;
+    size_t d_head_;
+    MathPrecision precision_ = MathPrecision::Exact;
+    bool causal_ = false;
+    bool rotary_ = false;
+    AttentionPattern pattern_;
+    size_t cacheWindow_ = 0;
+
+    // Shape of the last forward batch
+    size_t batch_ = 1;
+    size_t seqLen_ = 0;
+    std::vector<size_t> lengths_;
+
+    // Records batch_, seqLen_ and lengths_ for input, validating lengths
+    void setBatchShape(const Tensor& input, const std::vector<size_t>& lengths);
+
+    // Runs fn(unit) for every (sequence, head) pair, unit = b * NumHeads + head, on the
+    // global thread pool when the total multiply-add count makes it worthwhile
+    void forEachSequenceHead(size_t totalWork, const std::function<void(size_t)>& fn) const;
+};
+
+// Creates the attention variant for type
+std::unique_ptr<AttentionLayerBase> makeAttentionLayer(AttentionType type, size_t d_model, size_t d_k,
+                                                       size_t num_heads);
+
+#endif // ATTENTION_LAYER_BASE_H
@@ -2,16 +2,74 @@
 #define ATTENTION_NETWORK_H
 
 #include "attention/transformer_block.h"
+#include "attention/positional_encoding.h"
+#include "snapshot_publisher.h"
 #include <vector>
 #include <mutex>
 
+// Immutable copy of what the visualizer shows: the last forward's input/output and the
+// first block's projections and attention weights (first sequence of the batch).
+struct AttentionSnapshot {
+    AttentionType type = AttentionType::Softmax;
+    bool causal = false;
+    AttentionPattern pattern;
+    size_t numHeads = 0;
+    Tensor input;   // (B, L, 1)
+    Tensor output;  // (B, L, 1)
+    Tensor Q, K, V; // (1, L, D_k); empty before the first forward
+    Tensor weights; // (NumHeads, L, L)
+
+    // Same rule as AttentionLayerBase::attends()
+    bool attends(size_t i, size_t j) const { return (!causal || j <= i) && pattern.allows(i, j); }
+};
+
 class AttentionNetwork {
 public:
-    AttentionNetwork(size_t seqLen, size_t d_model, size_t d_k, size_t d_ff, size_t num_layers);
+    // d_k is the total attention width, split evenly across num_heads heads. Linear
+    // attention does not support Rotary encoding (throws std::invalid_argument).
+    AttentionNetwork(size_t seqLen, size_t d_model, size_t d_k, size_t d_ff, size_t num_layers,
+                     size_t num_heads = 1,
+                     PositionalEncodingType posEncoding = PositionalEncodingType::Sinusoidal,
+                     AttentionType attentionType = AttentionType::Softmax);
 
     Tensor forward(const Tensor& input); // Input (1, L, 1)
     double backward(const Tensor& target, double learningRate); // Returns loss
 
+    // Batched variable-length sequences, each (1, L_b, 1). They are packed into one
+    // zero-padded (B, Lmax, 1) batch with per-sequence padding masks, so every block
+    // runs once per batch. Returns one (1, L_b, 1) output per sequence.
+    std::vector<Tensor> forwardBatch(const std::vector<Tensor>& sequences);
+    // Targets for the sequences of the last forwardBatch; loss is the mean over real tokens
+    double backwardBatch(const std::vector<Tensor>& targets, double learningRate);
+
+    // Groups sequence indices into batches of at most maxBatchSize with similar lengths
+    static std::vector<std::vector<size_t>> bucketByLength(const std::vector<Tensor>& sequences,
+                                                           size_t maxBatchSize);
+    // forwardBatch over length buckets; outputs are returned in the input order
+    std::vector<Tensor> forwardBucketed(const std::vector<Tensor>& sequences, size_t maxBatchSize);
+
+    // Incremental decoding: tokens (1, T, 1) continue the current stream, returns (1, T, 1).
+    // Each block keeps a KV cache, so appending a token costs O(L) per layer.
+    Tensor forwardIncremental(const Tensor& tokens);
+    void resetIncremental();
+    size_t incrementalLength() const;
+
+    // Bounded rolling context for forwardIncremental() over unbounded streams: each block
+    // keeps only the last `window` positions (0 = unlimited, the default). Positional
+    // encodings are then computed per position instead of from growing tables; learned
+    // encodings reuse their last row past the trained length. Resets the stream.
+    void setContextWindow(size_t window);
+    size_t contextWindow() const;
+
+    // Causal masking in forward()/backward(); with it on, forward() on a sequence
+    // matches forwardIncremental() fed the same tokens
+    void setCausal(bool causal);
+    bool isCausal() const;
+
+    // Sparse attention pattern for every block (default dense)
+    void setAttentionPattern(const AttentionPattern& pattern);
+    AttentionPattern attentionPattern() const;
+
     const std::vector<TransformerBlock>& getBlocks() const { return blocks_; }
     const Tensor& getInput() const { return input_; }
     const Tensor& getOutput() const { return output_; }
@@ -19,19 +77,46 @@ public:
     size_t getSeqLen() const { return seqLen_; }
     size_t getDModel() const { return d_model_; }
     size_t getNumLayers() const { return blocks_.size(); }
+    size_t getNumHeads() const { return numHeads_; }
+    PositionalEncodingType getPositionalEncoding() const { return posEncodingType_; }
+    AttentionType getAttentionType() const { return attentionType_; }
+
+    // 注意力 softmax 与 FFN 激活的计算精度（默认 Exact，见 fast_math.h）
+    void setMathPrecision(MathPrecision precision);
+    MathPrecision mathPrecision() const;
+
+    // FFN 隐层激活函数（默认 ReLU）
+    void setFeedForwardActivation(FFNActivation activation);
+    FFNActivation feedForwardActivation() const;
+
+    // Copies the current visualization state into a new snapshot (the trainer calls this
+    // before signalling the view). Readers take latestSnapshot() without the mutex, so
+    // painting never stalls a training step. One snapshot is published on construction.
+    void publishSnapshot();
+    std::shared_ptr<const AttentionSnapshot> latestSnapshot() const { return snapshots_.latest(); }
 
     std::mutex& getMutex() const { return mutex_; }
 
 private:
     mutable std::mutex mutex_;
+    SnapshotPublisher<AttentionSnapshot> snapshots_; // Writers serialized by mutex_
     size_t seqLen_;
     size_t d_model_;
+    size_t numHeads_;
+    PositionalEncodingType posEncodingType_;
+    AttentionType attentionType_;
+    MathPrecision precision_ = MathPrecision::Exact;
+    FFNActivation ffnActivation_ = FFNActivation::ReLU;
+    bool causal_ = false;
+    AttentionPattern pattern_;
+    size_t streamLen_ = 0; // Tokens consumed by forwardIncremental since the last reset
+    size_t contextWindow_ = 0;
 
     // Embedding: Linear (1 -> d_model)
     Tensor W_embed_; // (1, 1, d_model)
     Tensor b_embed_; // (1, 1, d_model)
 
-    Tensor posEncoding_; // (1, L, d_model)
+    Tensor learnedPosEncoding_; // (1, >= L, d_model), Learned only, grown on demand
 
     std::vector<TransformerBlock> blocks_;
 
@@ -39,14 +124,18 @@ private:
     Tensor W_out_; // (1, d_model, 1)
     Tensor b_out_; // (1, 1, 1)
 
-    // Cache
-    Tensor input_;
-    Tensor embedded_;
-    Tensor blocksInput_; // embedded + pos
+    // Cache (B = 1 for forward())
+    Tensor input_;             // (B, L, 1)
+    std::vector<size_t> batchLengths_;
+    Tensor blocksInput_;       // embedded + bias + pos, (B, L, D)
     Tensor finalBlockOutput_;
-    Tensor output_;
+    Tensor output_;            // (B, L, 1), zero at padded positions
 
-    void initPosEncoding();
+    void ensureLearnedEncoding(size_t length);
+    // Rows [0, length) of the encoding added to the embedding; empty for Rotary
+    TensorView additiveEncoding(size_t length);
+    void forwardPacked(const Tensor& packed, const std::vector<size_t>& lengths);
+    void backwardPacked(const Tensor& gradOutput, double learningRate);
 };
 
 #endif // ATTENTION_NETWORK_H
@@ -2,9 +2,9 @@
 #define ATTENTION_TRAINING_THREAD_H
 
 #include <QThread>
-#include <QMutex>
-#include <QWaitCondition>
 #include "attention/attention_network.h"
+#include "progress_metatype.h"
+#include "training_control.h"
 
 class AttentionTrainingThread : public QThread {
     Q_OBJECT
@@ -15,16 +15,19 @@ public:
 
     void setNetwork(AttentionNetwork* network);
     void setParameters(int epochs, double learningRate, int seqLen);
+    // UI refresh rate for progress (default 30 Hz, <= 0 = every epoch); training runs unthrottled
+    void setUpdateRate(double rateHz);
 
     void startTraining();
     void stopTraining();
     void pauseTraining();
     void resumeTraining();
 
-    bool isPaused() const { return paused_; }
+    bool isPaused() const { return control_.isPaused(); }
 
 signals:
-    void epochCompleted(int epoch, double loss);
+    // Loss points coalesced over one UI frame, in epoch order, newest last
+    void progressUpdated(const std::vector<LossPoint>& points);
     void trainingCompleted();
     void weightsUpdated();
 
@@ -32,15 +35,19 @@ protected:
     void run() override;
 
 private:
+    // One generator keeps up with training: a sort sample is far cheaper than forward + backward
+    static constexpr size_t kDataWorkers = 1;
+
     AttentionNetwork* network_;
     int epochs_;
     double learningRate_;
     int seqLen_;
+    double updateRateHz_ = ProgressThrottle::kDefaultRateHz;
+
+    TrainingControl control_;
 
-    bool running_;
-    bool paused_;
-    QMutex mutex_;
-    QWaitCondition pauseCondition_;
+    // Publishes a network snapshot and sends the coalesced progress to the UI
+    void flushProgress(ProgressThrottle& throttle);
 };
 
 #endif // ATTENTION_TRAINING_THREAD_H
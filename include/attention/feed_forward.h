@@ -0,0 +1,54 @@
+#ifndef FEED_FORWARD_H
+#define FEED_FORWARD_H
+
+#include "cnn/tensor.h"
+
+enum class FFNActivation {
+    ReLU,
+    GELU
+};
+
+/**
+ * Position-wise feed-forward network: act(x W1 + b1) W2 + b2.
+ *
+ * Both dense layers are fused row-by-row GEMM kernels: bias and activation are
+ * applied in the epilogue while the output row is still in cache, so there are
+ * no separate bias or activation passes. The backward pass visits each row once
+ * and produces dW2/db2, the activation derivative, dW1/db1 and dx together,
+ * reading W1 and W2 in their stored row-major layout (no transposed copies).
+ */
+class FeedForward {
+public:
+    FeedForward(size_t d_model, size_t d_ff, FFNActivation activation = FFNActivation::ReLU);
+
+    // x: (C, H, D_model), treated as C*H rows; returns (1, C*H, D_model)
+    Tensor forward(const Tensor& x);
+    // Same result without touching the backward caches (incremental decoding)
+    Tensor infer(const Tensor& x) const;
+    // Adds dLoss/dx into dInput (same element count as x), then applies the SGD update
+    void backward(const Tensor& gradOutput, double learningRate, Tensor& dInput);
+
+    void setActivation(FFNActivation activation) { activation_ = activation; }
+    FFNActivation activation() const { return activation_; }
+    void setMathPrecision(MathPrecision precision) { precision_ = precision; }
+
+private:
+    size_t d_model_;
+    size_t d_ff_;
+    FFNActivation activation_;
+    MathPrecision precision_ = MathPrecision::Exact;
+
+    Tensor W1_, b1_; // (1, D, FF), (1, 1, FF)
+    Tensor W2_, b2_; // (1, FF, D), (1, 1, D)
+
+    // Cache for backward
+    Tensor input_;     // (1, R, D)
+    Tensor hiddenPre_; // (1, R, FF), before activation
+    Tensor hidden_;    // (1, R, FF), after activation
+
+    // Dispatches the activation/precision pair to an inlined kernel: fn(Kernel{})
+    template <typename Fn>
+    void visitKernel(Fn&& fn) const;
+};
+
+#endif // FEED_FORWARD_H
@@ -0,0 +1,72 @@
+#ifndef LINEAR_ATTENTION_LAYER_H
+#define LINEAR_ATTENTION_LAYER_H
+
+#include "attention/attention_layer_base.h"
+#include <vector>
+
+/**
+ * Multi-head linear (kernelized) self-attention.
+ *
+ * Softmax similarity is replaced by phi(q) . phi(k) with the positive feature map
+ * phi(x) = elu(x) + 1, so by associativity
+ *     out_i = phi(q_i)^T S / (phi(q_i) . z),  S = sum_j phi(k_j) v_j^T,  z = sum_j phi(k_j)
+ * and each head costs O(L * d_head^2) instead of O(L^2 * d_head). With causal masking
+ * S and z are prefix sums; backward walks the rows in reverse and peels keys off the
+ * running sums, so no per-position state is stored. Only the per-row normalizer is
+ * cached. The same running state makes incremental decoding O(d_head^2) per token.
+ *
+ * Projections and initialization match AttentionLayer (packed W_QKV, W_O). RoPE and
+ * sparse patterns are not supported.
+ */
+class LinearAttentionLayer : public AttentionLayerBase {
+public:
+    LinearAttentionLayer(size_t d_model, size_t d_k, size_t num_heads = 1);
+
+    AttentionType type() const override { return AttentionType::Linear; }
+
+    Tensor forward(const Tensor& input, const std::vector<size_t>& lengths = {}) override;
+    Tensor backward(const Tensor& gradOutput, double learningRate) override;
+
+    // Updates the running S / z state with the new rows and reads it out
+    Tensor forwardIncremental(const Tensor& newRows) override;
+    void resetCache() override;
+    size_t cachedLength() const override { return streamLen_; }
+
+    // Throw std::invalid_argument for RoPE and non-dense patterns
+    void setRotary(bool rotary) override;
+    void setPattern(const AttentionPattern& pattern) override;
+
+    TensorView getQ() const override { return projection(0); }
+    TensorView getK() const override { return projection(1); }
+    TensorView getV() const override { return projection(2); }
+    // Implied weights phi(q_i) . phi(k_j) / normalizer_i (for visualization)
+    const Tensor& getWeights() const override;
+
+private:
+    // Weights
+    Tensor W_QKV_; // (1, D_model, 3 * D_k)
+    Tensor W_O_;   // (1, D_k, D_model)
+
+    // Cache for backward/viz; the batch is folded into rows (row = b * L + i)
+    Tensor input_;   // (1, B * L, D_model)
+    Tensor QKV_;     // (1, B * L, 3 * D_k), before the feature map
+    Tensor context_; // (1, B * L, D_k), heads concatenated
+    Tensor denom_;   // (NumHeads, B * L, 1), phi(q_i) . z_i
+
+    // Visualization only, rebuilt from QKV_ and denom_ when stale
+    mutable Tensor attentionWeights_;
+    mutable bool weightsStale_ = true;
+
+    // Running state for incremental decoding
+    Tensor kvState_; // (NumHeads, D_head, D_head), S
+    Tensor keySum_;  // (NumHeads, 1, D_head), z
+    size_t streamLen_ = 0;
+
+    TensorView projection(size_t block) const;
+
+    // Kernels for one (sequence, head) unit
+    void forwardHead(size_t unit);
+    void backwardHead(size_t unit, const Tensor& dContext, Tensor& dQKV) const;
+};
+
+#endif // LINEAR_ATTENTION_LAYER_H
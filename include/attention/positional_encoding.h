@@ -0,0 +1,43 @@
+#ifndef POSITIONAL_ENCODING_H
+#define POSITIONAL_ENCODING_H
+
+#include "cnn/tensor.h"
+#include "cnn/tensor_view.h"
+#include <map>
+#include <mutex>
+#include <vector>
+
+enum class PositionalEncodingType {
+    Sinusoidal, // Fixed sin/cos table added to the embedding
+    Learned,    // Trainable table added to the embedding, initialized from the sinusoidal one
+    Rotary      // RoPE: Q and K rotated by position right after the QKV projection
+};
+
+/**
+ * Process-wide cache of sinusoidal positional-encoding tables, keyed by d_model.
+ *
+ * Row pos of the table for dimension d holds sin(pos * w_m) at column 2m and
+ * cos(pos * w_m) at column 2m + 1, with w_m = 10000^(-2m / d). Tables grow
+ * geometrically and only the new rows are computed; any length is served as a
+ * zero-copy prefix view. Outgrown tables are retained rather than freed, so a
+ * view stays valid for the life of the process (geometric growth keeps the
+ * retired tables smaller than the live one).
+ *
+ * RoPE reuses the same table with d = head dimension: column 2m is sin and
+ * column 2m + 1 is cos of the rotation angle of pair m.
+ */
+class PositionalEncodingCache {
+public:
+    // Rows [0, length) of the table for d_model, (1, length, d_model). Thread-safe.
+    static TensorView sinusoidal(size_t d_model, size_t length);
+    // Row pos computed directly into out[0, d_model), bit-identical to the table row and
+    // without caching, for unbounded streams whose positions would grow the table forever
+    static void sinusoidalRow(size_t d_model, size_t pos, double* out);
+
+private:
+    static std::mutex mutex_;
+    // Every table ever built per d_model; back() is the largest
+    static std::map<size_t, std::vector<Tensor>> tables_;
+};
+
+#endif // POSITIONAL_ENCODING_H
@@ -0,0 +1,76 @@
+#ifndef STREAMING_ENGINE_H
+#define STREAMING_ENGINE_H
+
+#include "attention/attention_network.h"
+#include <chrono>
+#include <vector>
+
+// Per-token latency summary, in microseconds. Latency runs from push() of a value to
+// the return of its output, so it includes waiting for the micro-chunk to fill.
+struct StreamingLatencyStats {
+    size_t tokens = 0;      // Outputs emitted since the last reset
+    size_t chunks = 0;      // Micro-chunks run
+    double meanMicros = 0.0;
+    double p50Micros = 0.0; // Percentiles over the most recent kLatencyWindow tokens
+    double p99Micros = 0.0;
+    double maxMicros = 0.0;
+    double computeMicrosPerToken = 0.0; // Network time only, averaged over all tokens
+};
+
+/**
+ * Causal inference over an unbounded stream of scalar values.
+ *
+ * Values are buffered into micro-chunks of chunkSize and run through
+ * AttentionNetwork::forwardIncremental(); each chunk's outputs are returned as soon
+ * as it completes. The network keeps a rolling context of contextWindow positions
+ * per block (ring-buffer KV caches), and latency statistics use a fixed-size sample
+ * window, so memory stays bounded however long the stream runs.
+ *
+ * The engine owns the network's incremental state while in use: it sets the context
+ * window and resets the stream on construction and on reset().
+ */
+class StreamingEngine {
+public:
+    // Recent per-token latencies kept for the percentiles
+    static constexpr size_t kLatencyWindow = 4096;
+
+    StreamingEngine(AttentionNetwork& network, size_t contextWindow, size_t chunkSize = 1);
+
+    // Queues one value; returns the outputs of the chunk it completes (empty otherwise)
+    std::vector<double> push(double value);
+    // Runs the pending partial chunk, if any, and returns its outputs
+    std::vector<double> flush();
+    // Drops pending values, the rolling context and the statistics
+    void reset();
+
+    size_t chunkSize() const { return chunkSize_; }
+    size_t contextWindow() const { return contextWindow_; }
+    size_t pendingCount() const { return pending_.size(); }
+    size_t tokensProcessed() const { return tokens_; }
+
+    StreamingLatencyStats latencyStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    AttentionNetwork& network_;
+    size_t contextWindow_;
+    size_t chunkSize_;
+
+    // Values waiting for the current micro-chunk and their arrival times
+    std::vector<double> pending_;
+    std::vector<Clock::time_point> arrivals_;
+
+    // Statistics
+    size_t tokens_ = 0;
+    size_t chunks_ = 0;
+    double totalLatency_ = 0.0;
+    double maxLatency_ = 0.0;
+    double totalCompute_ = 0.0;
+    std::vector<double> recentLatency_; // Ring of the last kLatencyWindow latencies
+    size_t recentNext_ = 0;
+
+    std::vector<double> runChunk();
+};
+
+#endif // STREAMING_ENGINE_H
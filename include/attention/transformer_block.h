@@ -1,25 +1,49 @@
 #ifndef TRANSFORMER_BLOCK_H
 #define TRANSFORMER_BLOCK_H
 
-#include "attention/attention_layer.h"
+#include "attention/attention_layer_base.h"
+#include "attention/feed_forward.h"
+#include <memory>
+#include <vector>
+
+// Saved by the fused residual-add + LayerNorm forward for its backward pass
+struct LayerNormCache {
+    Tensor input;               // a + b, the LayerNorm input
+    std::vector<double> mean;   // per row
+    std::vector<double> invStd; // per row, 1 / sqrt(var + eps)
+};
 
 class TransformerBlock {
 public:
-    TransformerBlock(size_t d_model, size_t d_k, size_t d_ff);
+    TransformerBlock(size_t d_model, size_t d_k, size_t d_ff, size_t num_heads = 1,
+                     AttentionType attentionType = AttentionType::Softmax);
 
-    Tensor forward(const Tensor& input);
+    // Input (B, L, D); lengths as in AttentionLayer::forward
+    Tensor forward(const Tensor& input, const std::vector<size_t>& lengths = {});
     Tensor backward(const Tensor& gradOutput, double learningRate);
 
-    const AttentionLayer& getAttention() const { return attention_; }
+    // Inference on new rows only, using the attention KV cache (no backward caches)
+    Tensor forwardIncremental(const Tensor& newRows);
+    void resetCache() { attention_->resetCache(); }
+    void setCacheWindow(size_t window) { attention_->setCacheWindow(window); }
+    void setCausal(bool causal) { attention_->setCausal(causal); }
+    void setRotary(bool rotary) { attention_->setRotary(rotary); }
+    void setAttentionPattern(const AttentionPattern& pattern) { attention_->setPattern(pattern); }
+
+    const AttentionLayerBase& getAttention() const { return *attention_; }
+
+    void setFeedForwardActivation(FFNActivation activation) { ffn_.setActivation(activation); }
+
+    void setMathPrecision(MathPrecision precision) {
+        attention_->setMathPrecision(precision);
+        ffn_.setMathPrecision(precision);
+    }
 
 private:
     size_t d_model_;
 
-    AttentionLayer attention_;
-
-    // Feed Forward Weights
-    Tensor W1_, b1_; // D -> FF
-    Tensor W2_, b2_; // FF -> D
+    std::unique_ptr<AttentionLayerBase> attention_;
+    FeedForward ffn_; // Declared after attention_: weights are drawn in that order
 
     // Layer Norm Weights
     Tensor gamma1_, beta1_;
@@ -28,18 +52,18 @@ private:
     // Cache for backward
     Tensor input_;
     Tensor attnOutput_; // Post attention, pre-add
-    Tensor norm1Input_; // input + attnOutput
+    LayerNormCache norm1_; // input + attnOutput and its row statistics
     Tensor norm1Output_; // After first norm
 
-    Tensor ffHidden_;   // After W1, before ReLU
-    Tensor ffRelu_;     // After ReLU
-    Tensor ffOutput_;   // After W2
-    Tensor norm2Input_; // norm1Output + ffOutput
+    LayerNormCache norm2_; // norm1Output + ffOutput and its row statistics
 
-    // Helper to apply LayerNorm forward
-    Tensor forwardLayerNorm(const Tensor& x, const Tensor& gamma, const Tensor& beta);
-    // Helper for LayerNorm backward
-    Tensor backwardLayerNorm(const Tensor& dY, const Tensor& x, const Tensor& gamma, Tensor& dGamma, Tensor& dBeta);
+    // Fused residual add + LayerNorm: returns LayerNorm(a + b) with the shape of a,
+    // saving a + b and the per-row mean / inverse std in cache
+    static Tensor addLayerNorm(const Tensor& a, const Tensor& b, const Tensor& gamma, const Tensor& beta,
+                               LayerNormCache& cache);
+    // LayerNorm backward from the saved statistics; accumulates into dGamma / dBeta
+    static Tensor backwardLayerNorm(const Tensor& dY, const LayerNormCache& cache, const Tensor& gamma,
+                                    Tensor& dGamma, Tensor& dBeta);
 };
 
 #endif // TRANSFORMER_BLOCK_H
@@ -3,6 +3,7 @@
 
 #include <QMainWindow>
 #include <QSpinBox>
+#include <QComboBox>
 #include <QDoubleSpinBox>
 #include <QPushButton>
 #include <QTextEdit>
@@ -27,14 +28,16 @@ private slots:
     void onStopTraining();
     void onPauseResumeTraining();
     void onResetNetwork();
+    void onPatternChanged(int index);
 
-    void onEpochCompleted(int epoch, double loss);
+    void onProgressUpdated(const std::vector<LossPoint>& points);
     void onTrainingCompleted();
     void onWeightsUpdated();
 
 private:
     void setupUI();
-    void createNetwork();
+    // Builds the network from the controls; reports the error and returns false if that fails
+    bool createNetwork();
     void updateStatus(const QString& message);
     void log(const QString& message);
 
@@ -48,6 +51,10 @@ private:
     QSpinBox* seqLenSpinBox_;
     QSpinBox* dModelSpinBox_;
     QSpinBox* layersSpinBox_;
+    QComboBox* headsComboBox_;
+    QComboBox* posEncodingComboBox_;
+    QComboBox* patternComboBox_;
+    QComboBox* attentionTypeComboBox_;
 
     QPushButton* startButton_;
     QPushButton* stopButton_;
@@ -63,6 +70,7 @@ private:
     LossChart* lossChart_;
 
     int totalEpochs_;
+    int currentEpoch_ = 0;
 };
 
 #endif // ATTENTION_MAINWINDOW_H
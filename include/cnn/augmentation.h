@@ -0,0 +1,83 @@
+#ifndef AUGMENTATION_H
+#define AUGMENTATION_H
+
+#include "cnn/random.h"
+#include "cnn/tensor.h"
+#include "cnn/tensor_view.h"
+#include "data_pipeline.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 图像数据增强：按添加顺序对 CHW 样本依次施加随机变换
+ *
+ * 每次 apply() 为各步骤重新抽取随机参数（翻转与否、平移量、裁剪区域等），
+ * 随机数全部来自调用方传入的随机流，结果只由输入与流决定，在 DataPipeline 的生成线程中使用时
+ * 各线程互不干扰，且与生成线程数无关。
+ * 变换按整行处理（行拷贝、行内反转、连续缓冲上的逐元素运算），中间结果在线程局部的
+ * 缓冲区之间交替，不为每个步骤分配内存。ImageAugmenter 本身只读，可被多个线程共享。
+ *
+ * 也可由配置字符串构造（见 fromSpec），如 "flip_h,shift=2,crop=0.8,rot90,noise=0.05"。
+ */
+class ImageAugmenter {
+public:
+    // 以 probability 的概率左右 / 上下翻转
+    ImageAugmenter& flipHorizontal(double probability = 0.5);
+    ImageAugmenter& flipVertical(double probability = 0.5);
+    // 随机旋转 0/90/180/270 度（要求图像为正方形）
+    ImageAugmenter& rotate90();
+    // 在 [-maxShift, maxShift] 内随机平移，移出的区域补零
+    ImageAugmenter& shift(size_t maxShift);
+    // 随机裁剪边长为原图 [minScale, 1] 倍的区域，再双线性缩放回原尺寸
+    ImageAugmenter& crop(double minScale);
+    // 加上标准差为 stddev 的高斯噪声
+    ImageAugmenter& noise(double stddev);
+
+    /**
+     * @brief 由逗号分隔的配置构造
+     *
+     * 可用步骤：flip_h[=p]、flip_v[=p]、rot90、shift[=n]、crop[=scale]、noise[=stddev]；
+     * 省略值时依次为 0.5、0.5、-、2、0.8、0.05。空字符串或 "none" 表示不增强。
+     * 名称或取值无效时抛出 std::invalid_argument。
+     */
+    static ImageAugmenter fromSpec(const std::string& spec);
+    // 与 fromSpec 对应的配置字符串
+    std::string spec() const;
+
+    bool empty() const { return steps_.empty(); }
+    size_t size() const { return steps_.size(); }
+
+    // 对 input 施加全部步骤，结果写入 output（尺寸与 input 相同）
+    void apply(const TensorView& input, Tensor& output, PhiloxRng& gen) const;
+    Tensor apply(const TensorView& input, PhiloxRng& gen) const;
+
+private:
+    enum class Kind { FlipHorizontal, FlipVertical, Rotate90, Shift, Crop, Noise };
+    struct Step {
+        Kind kind;
+        double value;
+    };
+
+    ImageAugmenter& add(Kind kind, double value);
+
+    std::vector<Step> steps_;
+};
+
+// 按编号取原始样本；生成线程会并发调用，须为只读访问
+using AugmentationSource = std::function<TensorView(size_t index)>;
+
+/**
+ * @brief 在生成线程中即时增强的样本流
+ *
+ * 第 k 个样本为 source(k % datasetSize) 的一次随机增强，按编号循环遍历数据集，
+ * total 为样本总数（通常为轮数 × datasetSize）。next() 返回的 index 对 datasetSize 取模
+ * 即为原始样本编号，可据此取标签。增强与训练线程的网络计算并行进行，数据集本身不被复制或扩充。
+ */
+std::unique_ptr<DataPipeline<Tensor>> makeAugmentationPipeline(
+    const ImageAugmenter& augmenter, AugmentationSource source, size_t datasetSize,
+    size_t numWorkers, size_t prefetchDepth, uint64_t seed,
+    size_t total = DataPipeline<Tensor>::kUnbounded);
+
+#endif // AUGMENTATION_H
@@ -2,9 +2,11 @@
 #define CNN_LAYER_BASE_H
 
 #include "cnn/tensor.h"
+#include "activation_kernels.h"
 #include <string>
 #include <memory>
 #include <vector>
+#include <utility>
 
 /**
  * @brief CNN层类型枚举
@@ -28,9 +30,34 @@ enum class CNNActivationType {
     LeakyReLU,
     Sigmoid,
     Tanh,
-    Softmax
+    Softmax,
+    GELU
 };
 
+// 按激活类型与数学精度分派到对应的内联内核；Softmax 非逐元素运算，按恒等处理
+template <typename Fn>
+inline void visitActivation(CNNActivationType type, MathPrecision precision, Fn&& fn) {
+    visitPrecision(precision, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        switch (type) {
+            case CNNActivationType::ReLU: fn(ReLUKernel{}); return;
+            case CNNActivationType::LeakyReLU: fn(LeakyReLUKernel{}); return;
+            case CNNActivationType::Sigmoid: fn(SigmoidKernelT<P>{}); return;
+            case CNNActivationType::Tanh: fn(TanhKernelT<P>{}); return;
+            case CNNActivationType::GELU: fn(GELUKernelT<P>{}); return;
+            case CNNActivationType::None:
+            case CNNActivationType::Softmax:
+                break;
+        }
+        fn(IdentityKernel{});
+    });
+}
+
+template <typename Fn>
+inline void visitActivation(CNNActivationType type, Fn&& fn) {
+    visitActivation(type, MathPrecision::Exact, std::forward<Fn>(fn));
+}
+
 /**
  * @brief CNN层基类 - 定义CNN的公共接口
  */
@@ -54,12 +81,29 @@ public:
      */
     virtual Tensor backward(const Tensor& gradOutput) = 0;
 
+    /**
+     * @brief 输入由调用方交出所有权时的前向传播
+     *
+     * 默认转调 forward()；展平层借此直接复用输入的存储，不做复制
+     */
+    virtual Tensor forwardOwned(Tensor&& input) { return forward(input); }
+
+    /**
+     * @brief 输出梯度由调用方交出所有权时的反向传播，默认转调 backward()
+     */
+    virtual Tensor backwardOwned(Tensor&& gradOutput) { return backward(gradOutput); }
+
     /**
      * @brief 更新权重，如果有可训练参数
      * @param learningRate 学习率
      */
     virtual void updateWeights(double learningRate) = 0;
 
+    /**
+     * @brief 设置激活函数的数学精度，无激活函数的层忽略
+     */
+    virtual void setMathPrecision(MathPrecision /*precision*/) {}
+
     // ========== 属性访问 ==========
 
     virtual CNNLayerType type() const = 0;
@@ -5,12 +5,32 @@
 #include "cnn/conv_layer.h"
 #include "cnn/pooling_layer.h"
 #include "cnn/flatten_layer.h"
+#include "cnn/tensor_view.h"
 #include "../neural_network.h"
 #include <vector>
 #include <memory>
 #include <string>
 #include <mutex>
 
+// 卷积部分单层的可视化快照
+struct CNNLayerSnapshot {
+    CNNLayerType type = CNNLayerType::Convolutional;
+    std::string name;
+    size_t outputChannels = 0;
+    size_t outputHeight = 0;
+    size_t outputWidth = 0;
+    Tensor output; // 最近一次前向的特征图 (C, H, W)
+};
+
+// CNN 在某一时刻的不可变快照，由 CNNNetwork::publishSnapshot() 发布
+struct CNNSnapshot {
+    size_t inputChannels = 0;
+    size_t inputHeight = 0;
+    size_t inputWidth = 0;
+    std::vector<CNNLayerSnapshot> cnnLayers;
+    std::vector<LayerSnapshot> denseLayers;
+};
+
 /**
  * @brief CNN网络类
  *
@@ -37,6 +57,14 @@ public:
 
     void build();
 
+    // 网络的随机种子：决定卷积核与全连接层的初始权重以及打乱顺序。
+    // 卷积层在 addConvLayer() 时即初始化，因此需在添加任何层之前设置
+    void setSeed(uint64_t seed);
+    // 开启后每次 train() 按新的随机顺序遍历样本（trainBatch 的顺序由调用方决定，
+    // 可配合 ShuffledBatchSampler 使用）
+    void setShuffle(bool shuffle);
+    bool shuffle() const;
+
     // 预设架构
     void buildSimpleCNN(size_t inputChannels, size_t inputHeight, size_t inputWidth,
                         size_t numClasses);
@@ -46,9 +74,22 @@ public:
     void backward(const std::vector<double>& target);
     void updateWeights(double learningRate);
 
+    // 训练一轮；control 非空时在样本之间检查取消，提前结束时返回已训练样本的平均损失
     double train(const std::vector<Tensor>& inputs,
                  const std::vector<std::vector<double>>& targets,
-                 double learningRate);
+                 double learningRate,
+                 const TrainingControl* control = nullptr);
+
+    /**
+     * @brief 训练一个零拷贝小批量（例如 MappedDataset 给出的视图），逐样本更新权重
+     *
+     * targets[i] 指向与网络输出等长的连续标签。每个视图只复制一次到网络内部的输入缓冲区，
+     * 调用方无需先物化为 std::vector<Tensor>。返回本批已训练样本的平均损失。
+     */
+    double trainBatch(const std::vector<TensorView>& inputs,
+                      const std::vector<const double*>& targets,
+                      double learningRate,
+                      const TrainingControl* control = nullptr);
 
     double calculateLoss(const std::vector<double>& output,
                          const std::vector<double>& target);
@@ -72,6 +113,15 @@ public:
     std::vector<std::vector<Tensor>> getAllKernels() const;
     std::vector<std::string> getLayerDescriptions() const;
 
+    // 激活函数 exp/tanh 的计算精度（默认 Exact，见 fast_math.h），作用于卷积层与全连接层
+    void setMathPrecision(MathPrecision precision);
+    MathPrecision mathPrecision() const;
+
+    // 发布特征图与全连接层权重/激活的快照（build() 后自动发布一次，训练线程每轮之后调用）。
+    // 可视化组件用 latestSnapshot() 无锁读取，绘制期间不会阻塞训练
+    void publishSnapshot();
+    std::shared_ptr<const CNNSnapshot> latestSnapshot() const { return snapshots_.latest(); }
+
     std::mutex& getMutex() { return mutex_; }
 
 private:
@@ -82,6 +132,11 @@ private:
                                  const std::vector<double>& target);
 
     void validateInputShape(const Tensor& input) const;
+    // 第 l 个全连接层的输入：首层为展平输出的视图，其余为上一层的输出
+    const double* denseInput(size_t l) const;
+    // 单个样本的前向、反向与权重更新，返回损失（调用方持有 mutex_）
+    double trainSampleInternal(const Tensor& input, const std::vector<double>& target,
+                               double learningRate);
 
     // 输入尺寸
     size_t inputChannels_;
@@ -103,12 +158,24 @@ private:
 
     bool isBuilt_ = false;
     bool hasFlatten_ = false;
+    MathPrecision precision_ = MathPrecision::Exact;
     size_t flattenedSize_ = 0;
 
-    std::vector<double> flattenedOutput_;
+    // 展平层输出的非拥有视图，存储由 FlattenLayer 持有；首个全连接层的前向与权重更新都直接读取它
+    TensorView flattenedOutput_;
     std::vector<double> lastOutput_;
 
+    // trainBatch 的输入/标签缓冲区，跨样本复用
+    Tensor batchInput_;
+    std::vector<double> batchTarget_;
+
+    PhiloxRng rng_;
+    bool shuffle_ = false;
+    uint64_t epoch_ = 0;
+    std::vector<size_t> order_;
+
     mutable std::mutex mutex_;
+    SnapshotPublisher<CNNSnapshot> snapshots_; // 写端由 mutex_ 串行化
 };
 
 #endif // CNN_NETWORK_H
@@ -5,8 +5,10 @@
 #include <QMutex>
 #include <atomic>
 #include <vector>
+#include "cnn/augmentation.h"
 #include "cnn/cnn_network.h"
 #include "cnn/tensor.h"
+#include "progress_metatype.h"
 
 /**
  * @brief CNN训练线程类
@@ -22,20 +24,31 @@ public:
 
     // 设置训练参数
     void setNetwork(CNNNetwork* network);
-    void setTrainingData(const std::vector<Tensor>& inputs,
-                         const std::vector<std::vector<double>>& targets);
+    // 按值接收：调用方可 std::move 交出数据，避免再复制一份
+    void setTrainingData(std::vector<Tensor> inputs,
+                         std::vector<std::vector<double>> targets);
+    // 改用合成形状数据集：首次训练时由后台生成线程并行合成（不占用 GUI 线程），之后复用
+    void setShapeDataset(int imageSize, int numClasses, int samplesPerClass);
+    // 训练时的即时数据增强（默认不增强）；增强在后台生成线程中进行，训练集本身保持不变
+    void setAugmentation(ImageAugmenter augmenter);
     void setParameters(int epochs, double learningRate);
+    // 界面进度刷新频率（默认 30 Hz，<= 0 为每轮刷新），训练本身全速运行
+    void setUpdateRate(double rateHz);
 
-    // 控制
+    // 控制（先清除上次的停止/暂停请求再启动线程，之后发出的请求不会被覆盖）
+    void startTraining();
     void stopTraining();
     void pauseTraining();
     void resumeTraining();
 
-    bool isPaused() const { return paused_; }
+    bool isPaused() const { return control_.isPaused(); }
     bool isRunning() const { return running_; }
 
 signals:
-    void epochCompleted(int epoch, double loss);
+    // 一帧内累积的损失点（按轮次递增，末尾为最新轮次）
+    void progressUpdated(const std::vector<LossPoint>& points);
+    // 合成数据集生成完毕
+    void datasetReady(int samples, double seconds);
     void trainingCompleted();
     void weightsUpdated();
 
@@ -43,18 +56,37 @@ protected:
     void run() override;
 
 private:
+    // 增强比一次前向 + 反向便宜得多，两个生成线程即可跟上训练
+    static constexpr size_t kAugmentWorkers = 2;
+    // 增强样本按此大小成批交给 CNNNetwork::trainBatch
+    static constexpr size_t kAugmentBatch = 32;
+
     CNNNetwork* network_;
     std::vector<Tensor> inputs_;
     std::vector<std::vector<double>> targets_;
 
+    // 待生成的形状数据集（samplesPerClass 为 0 表示使用 setTrainingData 的数据）
+    int shapeImageSize_ = 0;
+    int shapeClasses_ = 0;
+    int shapeSamplesPerClass_ = 0;
+
+    ImageAugmenter augmenter_;
+
     int epochs_;
     double learningRate_;
+    double updateRateHz_ = ProgressThrottle::kDefaultRateHz;
 
     std::atomic<bool> running_;
-    std::atomic<bool> paused_;
-    std::atomic<bool> stopRequested_;
+    TrainingControl control_;
 
     QMutex mutex_;
+
+    // 发布网络快照并把累积的进度一次性发给界面
+    void flushProgress(ProgressThrottle& throttle);
+    // 按 shape* 参数并行生成数据集；被取消时返回 false
+    bool buildShapeDataset();
+    // 从增强管线取一轮样本（inputs_.size() 个）训练，返回平均损失
+    double trainAugmentedEpoch(DataPipeline<Tensor>& pipeline);
 };
 
 #endif // CNN_TRAINING_THREAD_H
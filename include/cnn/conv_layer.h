@@ -2,22 +2,27 @@
 #define CONV_LAYER_H
 
 #include "cnn/cnn_layer_base.h"
+#include "cnn/random.h"
 #include <vector>
 
 /**
  * @brief 2D卷积层实现
+ *
+ * 第 oc 个卷积核由 rng.stream(oc) 初始化，各卷积核并行初始化，结果与线程数无关。
  */
 class ConvolutionalLayer : public CNNLayerBase {
 public:
     ConvolutionalLayer(size_t inputChannels, size_t inputHeight, size_t inputWidth,
                        size_t outputChannels, size_t kernelSize,
                        size_t stride = 1, size_t padding = 0,
-                       CNNActivationType activation = CNNActivationType::ReLU);
+                       CNNActivationType activation = CNNActivationType::ReLU,
+                       PhiloxRng rng = nextRandomStream());
 
     // CNNLayerBase 接口实现
     Tensor forward(const Tensor& input) override;
     Tensor backward(const Tensor& gradOutput) override;
     void updateWeights(double learningRate) override;
+    void setMathPrecision(MathPrecision precision) override { precision_ = precision; }
 
     CNNLayerType type() const override { return CNNLayerType::Convolutional; }
     std::string name() const override { return "Conv2D"; }
@@ -46,12 +51,9 @@ public:
     Tensor getKernel(size_t outputChannel) const;
 
 private:
-    void initializeWeights();
+    void initializeWeights(PhiloxRng rng);
     void computeOutputSize();
 
-    double activate(double x) const;
-    double activateDerivative(double x) const;
-
     size_t inputChannels_;
     size_t inputHeight_;
     size_t inputWidth_;
@@ -60,6 +62,7 @@ private:
     size_t stride_;
     size_t padding_;
     CNNActivationType activation_;
+    MathPrecision precision_ = MathPrecision::Exact;
 
     size_t outputHeight_;
     size_t outputWidth_;
@@ -6,7 +6,9 @@
 /**
  * @brief 展平层 - 将3D张量展平为1D向量
  *
- * 用于连接卷积层与全连接层
+ * 用于连接卷积层与全连接层。CHW 行主序数据本身已是展平顺序：forwardOwned/backwardOwned
+ * 接管调用方交出的张量，返回共享同一存储的新形状（O(1)，不复制）。const 引用版本不与调用者
+ * 共享可写存储，先复制一份再转调。反向传播不需要输入，因此不保存 lastInput_。
  */
 class FlattenLayer : public CNNLayerBase {
 public:
@@ -15,6 +17,8 @@ public:
     // CNNLayerBase 接口实现
     Tensor forward(const Tensor& input) override;
     Tensor backward(const Tensor& gradOutput) override;
+    Tensor forwardOwned(Tensor&& input) override;
+    Tensor backwardOwned(Tensor&& gradOutput) override;
     void updateWeights(double /*learningRate*/) override { /* no-op */ }
 
     CNNLayerType type() const override { return CNNLayerType::Flatten; }
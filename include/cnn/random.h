@@ -1,8 +1,120 @@
 #ifndef CNN_RANDOM_H
 #define CNN_RANDOM_H
 
-#include <random>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
-std::mt19937& getRng();
+/**
+ * @brief 基于计数器的随机数流（Philox4x32-10）
+ *
+ * 第 k 个输出只由 (seed, stream, k) 决定，没有需要顺序推进的内部状态：
+ * seek() 可以 O(1) 跳到任意位置，stream(id) 派生互相独立的子流
+ * （如按线程、按层、按轮次：base.stream(layer).stream(epoch)）。
+ * 复制一个流得到的是独立的副本，不同线程各持一份即可安全并发使用。
+ *
+ * 满足 UniformRandomBitGenerator，可以配合 <random> 的分布使用；但标准库分布的算法
+ * 由实现决定，需要跨平台逐位一致时使用这里自带的 uniform()/uniformIndex()/normal()。
+ */
+class PhiloxRng {
+public:
+    using result_type = uint64_t;
+
+    explicit PhiloxRng(uint64_t seed = 0, uint64_t stream = 0) : seed_(seed), stream_(stream) {}
+
+    // 由当前流与 id 派生的子流，从位置 0 开始
+    PhiloxRng stream(uint64_t id) const;
+
+    uint64_t seed() const { return seed_; }
+    uint64_t streamId() const { return stream_; }
+
+    // 已产生的 64 位输出个数；seek/discard 不需要计算中间输出
+    uint64_t position() const { return position_; }
+    void seek(uint64_t position) { position_ = position; }
+    void discard(uint64_t count) { position_ += count; }
+
+    result_type operator()();
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    // [0, 1) 内的均匀分布（53 位精度）
+    double uniform();
+    double uniform(double low, double high) { return low + (high - low) * uniform(); }
+    // [0, n) 内的均匀整数（拒绝采样，无取模偏差）；n 必须大于 0
+    uint64_t uniformIndex(uint64_t n);
+    // 正态分布（Box-Muller，每次消耗两个输出）
+    double normal(double mean = 0.0, double stddev = 1.0);
+
+    // Philox4x32-10 分组函数：counter 与 key 映射为 4 个 32 位输出
+    static std::array<uint32_t, 4> block(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+private:
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t position_ = 0;
+
+    // 每个分组产生两个 64 位输出，缓存最近计算的分组
+    uint64_t cachedBlock_ = ~uint64_t(0);
+    uint64_t cached_[2] = {0, 0};
+};
+
+/**
+ * @brief 进程级随机种子
+ *
+ * 启动时取自 std::random_device；setGlobalSeed() 之后，下面的默认随机流
+ * （权重初始化、getRng()）全部由该种子决定，重复运行逐位一致。
+ */
+void setGlobalSeed(uint64_t seed);
+uint64_t globalSeed();
+
+/**
+ * @brief 分配一个新的独立随机流（线程安全）
+ *
+ * 第 n 次调用返回由 (全局种子, n) 确定的流，setGlobalSeed() 会把 n 归零。
+ * 单线程按相同顺序构建网络时结果可复现；并行初始化时应由调用方先取一个流，
+ * 再按任务编号用 stream(i) 派生，而不是在各线程中分别调用本函数。
+ */
+PhiloxRng nextRandomStream();
+
+// 调用线程专属的随机流（由全局种子与线程登记顺序派生），不同线程之间互不干扰
+PhiloxRng& getRng();
+
+// 将 order 置为 0..n-1 的随机排列（Fisher-Yates），排列只由 rng 的种子、流与位置决定
+void shufflePermutation(std::vector<size_t>& order, size_t n, PhiloxRng rng);
+
+/**
+ * @brief 打乱的小批量采样器
+ *
+ * 第 e 轮的样本顺序由 rng.stream(e) 生成，与之前各轮无关：setEpoch(e) 可以直接
+ * 跳到任意一轮并得到与连续训练时相同的顺序（如从检查点恢复）。shuffle 为 false 时按原顺序。
+ */
+class ShuffledBatchSampler {
+public:
+    ShuffledBatchSampler(size_t size, size_t batchSize, PhiloxRng rng, bool shuffle = true);
+
+    // 生成第 epoch 轮的顺序并回到该轮开头；构造后处于第 0 轮
+    void setEpoch(uint64_t epoch);
+    // 进入下一轮
+    void nextEpoch() { setEpoch(epoch_ + 1); }
+    // 本轮下一批的样本编号；本轮已遍历完时返回 false
+    bool next(std::vector<size_t>& batch);
+
+    uint64_t epoch() const { return epoch_; }
+    size_t size() const { return order_.size(); }
+    size_t batchSize() const { return batchSize_; }
+    size_t batchesPerEpoch() const { return (order_.size() + batchSize_ - 1) / batchSize_; }
+    // 本轮的完整顺序与已给出的样本数
+    const std::vector<size_t>& order() const { return order_; }
+    size_t position() const { return position_; }
+
+private:
+    size_t batchSize_;
+    PhiloxRng rng_;
+    bool shuffle_;
+    std::vector<size_t> order_;
+    size_t position_ = 0;
+    uint64_t epoch_ = 0;
+};
 
 #endif // CNN_RANDOM_H
@@ -6,32 +6,56 @@
 #include <stdexcept>
 #include <algorithm>
 #include <random>
-#include <functional>
 #include <cmath>
 #include <numeric>
+#include <memory>
+#include "fast_math.h"
+
+class PhiloxRng;
+class TensorView;
+
+/**
+ * @brief 逐元素表达式的CRTP基类（见 cnn/tensor_expr.h）
+ */
+template <typename E>
+class TensorExpr {
+public:
+    const E& self() const { return static_cast<const E&>(*this); }
+};
 
 /**
  * @brief 3D张量类，用于表示CNN中的特征图
  *
  * 存储格式: [channels][height][width] (CHW格式)
+ *
+ * 拷贝构造/拷贝赋值始终为深拷贝；reshape() 返回与原张量共享存储的视图，
+ * 只改变形状而不复制数据（写入视图对原张量可见）。const 张量的 reshape() 返回只读的
+ * TensorView，不能借此得到可写入原存储的 Tensor。
+ * 加减与数乘为惰性表达式，赋值时融合为单次循环（见 cnn/tensor_expr.h）。
  */
-class Tensor {
+class Tensor : public TensorExpr<Tensor> {
 public:
     Tensor();
     Tensor(size_t channels, size_t height, size_t width);
     Tensor(size_t channels, size_t height, size_t width, double initValue);
 
-    Tensor(const Tensor& other) = default;
-    Tensor(Tensor&& other) noexcept = default;
-    Tensor& operator=(const Tensor& other) = default;
-    Tensor& operator=(Tensor&& other) noexcept = default;
+    Tensor(const Tensor& other);
+    Tensor(Tensor&& other) noexcept;
+    Tensor& operator=(const Tensor& other);
+    Tensor& operator=(Tensor&& other) noexcept;
+
+    // 从逐元素表达式求值
+    template <typename E>
+    Tensor(const TensorExpr<E>& expr);
+    template <typename E>
+    Tensor& operator=(const TensorExpr<E>& expr);
 
     // 维度访问
     size_t channels() const { return channels_; }
     size_t height() const { return height_; }
     size_t width() const { return width_; }
-    size_t size() const { return data_.size(); }
-    bool empty() const { return data_.empty(); }
+    size_t size() const { return data_ ? data_->size() : 0; }
+    bool empty() const { return size() == 0; }
 
     // 元素访问 (CHW索引)
     double& at(size_t c, size_t h, size_t w);
@@ -41,37 +65,73 @@ public:
     double& operator()(size_t c, size_t h, size_t w);
     const double& operator()(size_t c, size_t h, size_t w) const;
 
+    // 扁平索引访问（表达式求值使用）
+    double operator[](size_t i) const { return (*data_)[i]; }
+
     // 获取单个通道
     std::vector<double> getChannel(size_t c) const;
     void setChannel(size_t c, const std::vector<double>& data);
 
     // 数据访问
-    std::vector<double>& data() { return data_; }
-    const std::vector<double>& data() const { return data_; }
-    double* rawData() { return data_.data(); }
-    const double* rawData() const { return data_.data(); }
+    std::vector<double>& data();
+    const std::vector<double>& data() const;
+    double* rawData() { return data_ ? data_->data() : nullptr; }
+    const double* rawData() const { return data_ ? data_->data() : nullptr; }
 
     // 形状操作
     void resize(size_t channels, size_t height, size_t width);
+
+    /**
+     * @brief 返回共享存储的新形状视图，O(1)，元素总数必须一致
+     */
+    Tensor reshape(size_t channels, size_t height, size_t width);
+    // const 版本：只读视图（需包含 cnn/tensor_view.h）
+    TensorView reshape(size_t channels, size_t height, size_t width) const;
+    // 视为 (1, C*H, W) 的行矩阵（共享存储），用于把批次维折叠进矩阵乘法
+    Tensor asRows() { return reshape(1, channels_ * height_, width_); }
+    TensorView asRows() const;
+    bool sharesStorageWith(const Tensor& other) const {
+        return data_ && data_ == other.data_;
+    }
     void fill(double value);
     void zero() { fill(0.0); }
 
-    // 初始化方法
+    // 初始化方法：不传随机流时各取一个新的 nextRandomStream()（见 cnn/random.h）
     void randomInit(double min = -1.0, double max = 1.0);
     void xavierInit(size_t fanIn, size_t fanOut);
     void heInit(size_t fanIn);
-
-    // 数学运算
-    Tensor operator+(const Tensor& other) const;
-    Tensor operator-(const Tensor& other) const;
-    Tensor operator*(double scalar) const;
-    Tensor& operator+=(const Tensor& other);
-    Tensor& operator-=(const Tensor& other);
+    void randomInit(PhiloxRng& rng, double min = -1.0, double max = 1.0);
+    void xavierInit(PhiloxRng& rng, size_t fanIn, size_t fanOut);
+    void heInit(PhiloxRng& rng, size_t fanIn);
+
+    // 数学运算（+、-、* 标量见 cnn/tensor_expr.h）
+    template <typename E>
+    Tensor& operator+=(const TensorExpr<E>& expr);
+    template <typename E>
+    Tensor& operator-=(const TensorExpr<E>& expr);
     Tensor& operator*=(double scalar);
 
-    // 逐元素运算
-    void apply(const std::function<double(double)>& func);
-    Tensor map(const std::function<double(double)>& func) const;
+    // 逐元素运算（模板函数对象可内联；内置激活函数见 activation_kernels.h）
+    template <typename Func>
+    void apply(Func&& func) {
+        double* p = rawData();
+        const size_t n = size();
+        for (size_t i = 0; i < n; ++i) {
+            p[i] = func(p[i]);
+        }
+    }
+
+    template <typename Func>
+    Tensor map(Func&& func) const {
+        Tensor result(channels_, height_, width_);
+        const double* src = rawData();
+        double* dst = result.rawData();
+        const size_t n = size();
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = func(src[i]);
+        }
+        return result;
+    }
 
     // 统计函数
     double sum() const;
@@ -91,18 +151,21 @@ public:
     // 矩阵运算 (Added for Attention)
     Tensor matmul(const Tensor& other) const;
     Tensor transpose() const;
-    void softmax();
+    void softmax(MathPrecision precision = MathPrecision::Exact);  // 按行 (W 维)
     static Tensor randn(size_t c, size_t h, size_t w);
+    static Tensor randn(size_t c, size_t h, size_t w, PhiloxRng& rng);
 
 private:
     size_t channels_;
     size_t height_;
     size_t width_;
-    std::vector<double> data_;
+    std::shared_ptr<std::vector<double>> data_;
 
     size_t index(size_t c, size_t h, size_t w) const {
         return c * height_ * width_ + h * width_ + w;
     }
 };
 
+#include "cnn/tensor_expr.h"
+
 #endif // TENSOR_H
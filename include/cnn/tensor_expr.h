@@ -0,0 +1,176 @@
+#ifndef TENSOR_EXPR_H
+#define TENSOR_EXPR_H
+
+#include "cnn/tensor.h"
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @brief Tensor 逐元素运算的表达式模板
+ *
+ * `a + b`、`a - b`、`a * s`、`-a`、hadamard(a, b) 不立即计算，而是构建轻量的
+ * 表达式节点；在赋值给 Tensor（构造、=、+=、-=）时才在一个循环内逐元素求值，
+ * 不产生中间缓冲区。例如 `W -= dW * lr` 与 `x = a + b + c` 均只遍历一次内存。
+ *
+ * 表达式按值保存子表达式、按引用保存 Tensor 叶子节点，因此必须在同一完整
+ * 表达式内求值；不要用 auto 保存表达式（被引用的临时 Tensor 会先被销毁）。
+ */
+
+// ========== 运算符 ==========
+
+struct TensorAddOp {
+    static double apply(double a, double b) { return a + b; }
+};
+
+struct TensorSubOp {
+    static double apply(double a, double b) { return a - b; }
+};
+
+struct TensorMulOp {
+    static double apply(double a, double b) { return a * b; }
+};
+
+// Tensor 叶子按引用保存，中间表达式按值保存
+template <typename E>
+struct TensorExprOperand {
+    using type = const E;
+};
+
+template <>
+struct TensorExprOperand<Tensor> {
+    using type = const Tensor&;
+};
+
+// ========== 表达式节点 ==========
+
+template <typename L, typename R, typename Op>
+class BinaryTensorExpr : public TensorExpr<BinaryTensorExpr<L, R, Op>> {
+public:
+    BinaryTensorExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+        if (lhs.size() != rhs.size()) {
+            throw std::invalid_argument("Tensor size mismatch in element-wise operation");
+        }
+    }
+
+    double operator[](size_t i) const { return Op::apply(lhs_[i], rhs_[i]); }
+
+    size_t channels() const { return lhs_.channels(); }
+    size_t height() const { return lhs_.height(); }
+    size_t width() const { return lhs_.width(); }
+    size_t size() const { return lhs_.size(); }
+
+private:
+    typename TensorExprOperand<L>::type lhs_;
+    typename TensorExprOperand<R>::type rhs_;
+};
+
+template <typename E>
+class ScaledTensorExpr : public TensorExpr<ScaledTensorExpr<E>> {
+public:
+    ScaledTensorExpr(const E& expr, double scalar) : expr_(expr), scalar_(scalar) {}
+
+    double operator[](size_t i) const { return expr_[i] * scalar_; }
+
+    size_t channels() const { return expr_.channels(); }
+    size_t height() const { return expr_.height(); }
+    size_t width() const { return expr_.width(); }
+    size_t size() const { return expr_.size(); }
+
+private:
+    typename TensorExprOperand<E>::type expr_;
+    double scalar_;
+};
+
+// ========== 表达式构建 ==========
+
+template <typename L, typename R>
+BinaryTensorExpr<L, R, TensorAddOp> operator+(const TensorExpr<L>& lhs, const TensorExpr<R>& rhs) {
+    return BinaryTensorExpr<L, R, TensorAddOp>(lhs.self(), rhs.self());
+}
+
+template <typename L, typename R>
+BinaryTensorExpr<L, R, TensorSubOp> operator-(const TensorExpr<L>& lhs, const TensorExpr<R>& rhs) {
+    return BinaryTensorExpr<L, R, TensorSubOp>(lhs.self(), rhs.self());
+}
+
+// 逐元素乘积 (Hadamard)
+template <typename L, typename R>
+BinaryTensorExpr<L, R, TensorMulOp> hadamard(const TensorExpr<L>& lhs, const TensorExpr<R>& rhs) {
+    return BinaryTensorExpr<L, R, TensorMulOp>(lhs.self(), rhs.self());
+}
+
+template <typename E>
+ScaledTensorExpr<E> operator*(const TensorExpr<E>& expr, double scalar) {
+    return ScaledTensorExpr<E>(expr.self(), scalar);
+}
+
+template <typename E>
+ScaledTensorExpr<E> operator*(double scalar, const TensorExpr<E>& expr) {
+    return ScaledTensorExpr<E>(expr.self(), scalar);
+}
+
+template <typename E>
+ScaledTensorExpr<E> operator-(const TensorExpr<E>& expr) {
+    return ScaledTensorExpr<E>(expr.self(), -1.0);
+}
+
+// ========== Tensor 求值 ==========
+
+template <typename E>
+Tensor::Tensor(const TensorExpr<E>& expr)
+    : Tensor(expr.self().channels(), expr.self().height(), expr.self().width()) {
+    const E& e = expr.self();
+    double* dst = rawData();
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = e[i];
+    }
+}
+
+template <typename E>
+Tensor& Tensor::operator=(const TensorExpr<E>& expr) {
+    const E& e = expr.self();
+    if (channels_ != e.channels() || height_ != e.height() || width_ != e.width() ||
+        !data_ || data_.use_count() != 1) {
+        // 形状变化或存储被共享时先求值到新缓冲区，避免改写其他张量或读到已释放的数据
+        *this = Tensor(expr);
+        return *this;
+    }
+    double* dst = rawData();
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = e[i];
+    }
+    return *this;
+}
+
+template <typename E>
+Tensor& Tensor::operator+=(const TensorExpr<E>& expr) {
+    const E& e = expr.self();
+    if (e.size() != size()) {
+        throw std::invalid_argument("Tensor size mismatch in element-wise operation");
+    }
+    double* dst = rawData();
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] += e[i];
+    }
+    return *this;
+}
+
+template <typename E>
+Tensor& Tensor::operator-=(const TensorExpr<E>& expr) {
+    const E& e = expr.self();
+    if (e.size() != size()) {
+        throw std::invalid_argument("Tensor size mismatch in element-wise operation");
+    }
+    double* dst = rawData();
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] -= e[i];
+    }
+    return *this;
+}
+
+#endif // TENSOR_EXPR_H
@@ -0,0 +1,92 @@
+#ifndef TENSOR_VIEW_H
+#define TENSOR_VIEW_H
+
+#include "cnn/tensor.h"
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * @brief 只读、非拥有的跨步张量视图
+ *
+ * 由数据指针、偏移、形状 (C, H, W) 与各维步长描述，可在不复制数据的情况下
+ * 表示通道切片、转置 (交换步长) 与子窗口。视图不延长底层存储的生命周期，
+ * 调用者需保证被引用的 Tensor 在视图使用期间有效且不被重新分配。
+ */
+class TensorView {
+public:
+    TensorView() = default;
+
+    // 连续 CHW 数据
+    TensorView(const double* data, size_t channels, size_t height, size_t width)
+        : data_(data), channels_(channels), height_(height), width_(width),
+          strideC_(height * width), strideH_(width), strideW_(1) {}
+
+    TensorView(const double* data, size_t offset,
+               size_t channels, size_t height, size_t width,
+               size_t strideC, size_t strideH, size_t strideW)
+        : data_(data), offset_(offset), channels_(channels), height_(height), width_(width),
+          strideC_(strideC), strideH_(strideH), strideW_(strideW) {}
+
+    // 隐式转换：允许在接受视图的接口中直接传入 Tensor
+    TensorView(const Tensor& tensor)
+        : TensorView(tensor.rawData(), tensor.channels(), tensor.height(), tensor.width()) {}
+
+    // 维度访问
+    size_t channels() const { return channels_; }
+    size_t height() const { return height_; }
+    size_t width() const { return width_; }
+    size_t size() const { return channels_ * height_ * width_; }
+    bool empty() const { return size() == 0; }
+
+    size_t offset() const { return offset_; }
+    size_t strideC() const { return strideC_; }
+    size_t strideH() const { return strideH_; }
+    size_t strideW() const { return strideW_; }
+    bool isContiguous() const {
+        return strideW_ == 1 && strideH_ == width_ && strideC_ == height_ * width_;
+    }
+
+    // 快速访问（无边界检查）
+    const double& operator()(size_t c, size_t h, size_t w) const {
+        return data_[offset_ + c * strideC_ + h * strideH_ + w * strideW_];
+    }
+
+    const double& at(size_t c, size_t h, size_t w) const {
+        if (c >= channels_ || h >= height_ || w >= width_) {
+            throw std::out_of_range("TensorView index out of range");
+        }
+        return (*this)(c, h, w);
+    }
+
+    // 切片与重排（均为 O(1)）
+    TensorView channel(size_t c) const;
+    TensorView channelRange(size_t first, size_t count) const;
+    TensorView transposed() const;
+    TensorView window(size_t h0, size_t w0, size_t height, size_t width) const;
+
+    // 统计函数
+    double min() const;
+    double max() const;
+
+    // 物化为连续的 Tensor
+    Tensor toTensor() const;
+
+private:
+    const double* data_ = nullptr;
+    size_t offset_ = 0;
+    size_t channels_ = 0;
+    size_t height_ = 0;
+    size_t width_ = 0;
+    size_t strideC_ = 0;
+    size_t strideH_ = 0;
+    size_t strideW_ = 0;
+};
+
+/**
+ * @brief 基于视图的批量矩阵乘法，(C, M, K) x (C, K, N) -> (C, M, N)
+ *
+ * 转置操作数可直接以 transposed() 视图传入，无需复制。
+ */
+Tensor matmul(const TensorView& a, const TensorView& b);
+
+#endif // TENSOR_VIEW_H
@@ -12,6 +12,7 @@
 #include <QHBoxLayout>
 #include <QGroupBox>
 #include <QComboBox>
+#include <QLineEdit>
 #include <QTextEdit>
 #include <QTabWidget>
 #include <QScrollArea>
@@ -40,7 +41,8 @@ private slots:
     void onResetNetwork();
     void onBuildNetwork();
     void onLayerClicked(int layerIndex);
-    void onEpochCompleted(int epoch, double loss);
+    void onDatasetReady(int samples, double seconds);
+    void onProgressUpdated(const std::vector<LossPoint>& points);
     void onTrainingCompleted();
     void onWeightsUpdated();
 
@@ -54,10 +56,6 @@ private:
     // CNN网络
     std::unique_ptr<CNNNetwork> cnnNetwork_;
 
-    // 训练数据
-    std::vector<Tensor> trainImages_;
-    std::vector<std::vector<double>> trainLabels_;
-
     // UI组件
     CNNView* cnnView_;
     FeatureMapView* featureMapView_;
@@ -75,6 +73,7 @@ private:
     QSpinBox* epochsSpinBox_;
     QDoubleSpinBox* learningRateSpinBox_;
     QSpinBox* samplesSpinBox_;
+    QLineEdit* augmentationEdit_;
 
     // 控制按钮
     QPushButton* buildButton_;
@@ -89,6 +88,7 @@ private:
 
     std::unique_ptr<CNNTrainingThread> trainingThread_;
     int totalEpochs_ = 100;
+    int currentEpoch_ = 0;
 };
 
 #endif // CNN_MAINWINDOW_H
@@ -0,0 +1,243 @@
+#ifndef DATA_PIPELINE_H
+#define DATA_PIPELINE_H
+
+#include "bounded_queue.h"
+#include "cnn/random.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 数据管线运行统计
+struct DataPipelineStats {
+    size_t produced = 0;        // 已放入队列的样本数
+    size_t consumed = 0;        // 已被取走的样本数
+    size_t consumerStalls = 0;  // next() 遇到空队列、不得不等待生成的次数
+    size_t producerStalls = 0;  // 生成线程遇到满队列、等待消费的次数
+};
+
+/**
+ * @brief 生产者/消费者样本管线
+ *
+ * numWorkers 个生成线程调用 generator(index, gen) 即时合成样本，放入容量为
+ * prefetchDepth 的无锁有界队列；训练线程用 next() 取样本。生成与训练并行，
+ * 只要生成速度跟得上，next() 总能立即拿到预取好的样本（consumerStalls 保持为 0）。
+ * 队列满时生成线程在条件变量上休眠，不占用 CPU（训练暂停时也是如此）。
+ *
+ * 第 index 个样本的随机数来自 PhiloxRng(seed).stream(index)：样本内容只由 seed 与编号决定，
+ * 与生成线程数、由哪个线程生成无关，可逐位复现。index 为全局递增的样本编号，
+ * 可用来决定样本类别等。total 为样本总数，取完后 next() 返回 false；
+ * 默认无上限，作为无限数据流使用。多个生成线程时样本到达顺序不确定，
+ * 需要按编号排列时使用 next() 返回的 index，或用 nextInOrder() 按编号依次取出
+ * （训练顺序因此也与生成线程数无关，整个训练逐位可复现）。
+ *
+ * generator 抛出的异常会停止管线，并在 next() 中重新抛出。
+ * next() 可由多个线程调用；析构时停止并回收所有生成线程。
+ */
+template <typename Sample>
+class DataPipeline {
+public:
+    using Generator = std::function<Sample(size_t index, PhiloxRng& gen)>;
+
+    static constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+
+    DataPipeline(Generator generator, size_t numWorkers, size_t prefetchDepth, uint64_t seed,
+                 size_t total = kUnbounded)
+        : generator_(std::move(generator)), queue_(prefetchDepth), total_(total) {
+        if (!generator_) {
+            throw std::invalid_argument("DataPipeline needs a generator");
+        }
+        if (numWorkers == 0) {
+            throw std::invalid_argument("DataPipeline needs at least one worker");
+        }
+        workers_.reserve(numWorkers);
+        try {
+            for (size_t w = 0; w < numWorkers; ++w) {
+                workers_.emplace_back(&DataPipeline::workerLoop, this, PhiloxRng(seed));
+            }
+        } catch (...) {
+            stop(); // 析构函数不会运行，先回收已启动的线程
+            throw;
+        }
+    }
+
+    ~DataPipeline() { stop(); }
+
+    DataPipeline(const DataPipeline&) = delete;
+    DataPipeline& operator=(const DataPipeline&) = delete;
+
+    size_t numWorkers() const { return workers_.size(); }
+    size_t prefetchDepth() const { return queue_.capacity(); }
+
+    // 取下一个样本；队列空时等待生成。样本取完、管线已停止时返回 false
+    bool next(Sample& out, size_t* index = nullptr) {
+        if (stopping_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (error_) std::rethrow_exception(error_);
+            return false;
+        }
+        Item item;
+        if (!queue_.tryPop(item)) {
+            consumerStalls_.fetch_add(1, std::memory_order_relaxed);
+            if (!waitPop(item)) return false;
+        }
+        afterPop();
+        out = std::move(item.sample);
+        if (index) *index = item.index;
+        return true;
+    }
+
+    // 按编号依次取样本：提前到达的样本暂存（至多约 生成线程数 + 预取深度 个），直到轮到它们。
+    // 只能由一个线程调用，且不能与 next() 混用
+    bool nextInOrder(Sample& out, size_t* index = nullptr) {
+        auto it = reorder_.find(nextOrdered_);
+        while (it == reorder_.end()) {
+            Sample sample;
+            size_t arrived = 0;
+            if (!next(sample, &arrived)) return false;
+            it = reorder_.emplace(arrived, std::move(sample)).first;
+            if (arrived != nextOrdered_) it = reorder_.end();
+        }
+        out = std::move(it->second);
+        reorder_.erase(it);
+        if (index) *index = nextOrdered_;
+        ++nextOrdered_;
+        return true;
+    }
+
+    // 停止生成并回收线程；之后 next() 返回 false。可重复调用
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+        for (std::thread& worker : workers_) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    DataPipelineStats stats() const {
+        DataPipelineStats s;
+        s.produced = produced_.load(std::memory_order_relaxed);
+        s.consumed = consumed_.load(std::memory_order_relaxed);
+        s.consumerStalls = consumerStalls_.load(std::memory_order_relaxed);
+        s.producerStalls = producerStalls_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Item {
+        size_t index = 0;
+        Sample sample;
+    };
+
+    void workerLoop(PhiloxRng base) {
+        try {
+            for (;;) {
+                if (stopping_.load(std::memory_order_acquire)) break;
+                const size_t index = nextIndex_.fetch_add(1, std::memory_order_relaxed);
+                if (index >= total_) break;
+                Item item;
+                item.index = index;
+                PhiloxRng gen = base.stream(index);
+                item.sample = generator_(index, gen);
+                if (!push(std::move(item))) break;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+            stopping_ = true;
+            notFull_.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++finishedWorkers_;
+        notEmpty_.notify_all();
+    }
+
+    // 放入队列；满时休眠到有空位。管线停止时返回 false
+    bool push(Item&& item) {
+        if (!queue_.tryPush(std::move(item))) {
+            producerStalls_.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(mutex_);
+            producersWaiting_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            notFull_.wait(lock, [&]() { return stopping_.load() || queue_.tryPush(std::move(item)); });
+            producersWaiting_.fetch_sub(1, std::memory_order_relaxed);
+            if (stopping_) return false;
+        }
+        produced_.fetch_add(1, std::memory_order_relaxed);
+
+        // 与 waitPop 中的计数 + 屏障配对：要么消费者能看到新样本，要么这里能看到等待者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumersWaiting_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            notEmpty_.notify_one();
+        }
+        return true;
+    }
+
+    bool waitPop(Item& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        consumersWaiting_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = false;
+        notEmpty_.wait(lock, [&]() {
+            if (queue_.tryPop(item)) return popped = true;
+            if (finishedWorkers_ == workers_.size()) {
+                // 生成线程先入队再登记结束，这里再取一次以免漏掉最后的样本
+                popped = queue_.tryPop(item);
+                return true;
+            }
+            return stopping_.load();
+        });
+        consumersWaiting_.fetch_sub(1, std::memory_order_relaxed);
+        if (!popped && error_) std::rethrow_exception(error_);
+        return popped;
+    }
+
+    void afterPop() {
+        consumed_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producersWaiting_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            notFull_.notify_one();
+        }
+    }
+
+    Generator generator_;
+    BoundedQueue<Item> queue_;
+    const size_t total_;
+    std::atomic<size_t> nextIndex_{0};
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::atomic<bool> stopping_{false};  // 只在持有 mutex_ 时写入，条件变量的等待条件据此判断
+    size_t finishedWorkers_ = 0;
+    std::exception_ptr error_;
+
+    // nextInOrder() 的暂存区（仅消费线程访问）
+    std::map<size_t, Sample> reorder_;
+    size_t nextOrdered_ = 0;
+
+    std::atomic<size_t> producersWaiting_{0};
+    std::atomic<size_t> consumersWaiting_{0};
+
+    std::atomic<size_t> produced_{0};
+    std::atomic<size_t> consumed_{0};
+    std::atomic<size_t> consumerStalls_{0};
+    std::atomic<size_t> producerStalls_{0};
+};
+
+#endif // DATA_PIPELINE_H
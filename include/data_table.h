@@ -0,0 +1,84 @@
+#ifndef DATA_TABLE_H
+#define DATA_TABLE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 表格数据集：特征与目标各存为一块连续的行主序矩阵
+ *
+ * 第 i 行的特征为 features(i)[0 .. featureCount)，目标为 targets(i)[0 .. targetCount)。
+ * 整个数据集只有两次堆分配，训练时按行取指针即可，不再为每个样本分配 std::vector。
+ */
+class DataTable {
+public:
+    // 每列的均值与标准差，用于对训练集和测试集施加同一变换
+    struct Standardization {
+        std::vector<double> mean;
+        std::vector<double> stddev;
+    };
+
+    DataTable() = default;
+    // 全零的 rows 行表格
+    DataTable(size_t rows, size_t featureCount, size_t targetCount);
+
+    // 从逐行存储的数据构造（每行长度必须一致）
+    static DataTable fromRows(const std::vector<std::vector<double>>& inputs,
+                              const std::vector<std::vector<double>>& targets);
+
+    size_t rows() const { return rows_; }
+    size_t featureCount() const { return featureCount_; }
+    size_t targetCount() const { return targetCount_; }
+    bool empty() const { return rows_ == 0; }
+
+    const double* features(size_t row) const { return features_.data() + row * featureCount_; }
+    double* features(size_t row) { return features_.data() + row * featureCount_; }
+    const double* targets(size_t row) const { return targets_.data() + row * targetCount_; }
+    double* targets(size_t row) { return targets_.data() + row * targetCount_; }
+
+    // 整块矩阵（rows × featureCount / rows × targetCount，行主序）
+    const std::vector<double>& featureData() const { return features_; }
+    const std::vector<double>& targetData() const { return targets_; }
+
+    // 列名（来自 CSV 表头，没有表头时为空）
+    const std::vector<std::string>& featureNames() const { return featureNames_; }
+    const std::vector<std::string>& targetNames() const { return targetNames_; }
+    void setColumnNames(std::vector<std::string> featureNames, std::vector<std::string> targetNames);
+
+    // 计算各特征列的均值与标准差并原地标准化；常数列的标准差按 1 处理
+    Standardization standardize();
+    void applyStandardization(const Standardization& standardization);
+
+private:
+    size_t rows_ = 0;
+    size_t featureCount_ = 0;
+    size_t targetCount_ = 0;
+    std::vector<double> features_;
+    std::vector<double> targets_;
+    std::vector<std::string> featureNames_;
+    std::vector<std::string> targetNames_;
+};
+
+struct CsvOptions {
+    char delimiter = ',';
+    bool hasHeader = true;
+    // 目标列名（需要表头）；为空时取最后 targetCount 列
+    std::vector<std::string> targetColumns;
+    size_t targetCount = 1;
+    bool standardize = false; // 读取后对特征做标准化
+};
+
+/**
+ * @brief 多线程 CSV 解析
+ *
+ * 整个文件读入后按换行切成若干块，由全局线程池并行统计每块的行数，
+ * 再按前缀和确定每块在矩阵中的起始行，并行地直接解析到 DataTable 的连续存储中。
+ * 数值用 std::from_chars 解析，不受 locale 影响；支持 CRLF 与空行。字段首尾的双引号会被去掉，
+ * 但不支持引号内的分隔符、换行或转义引号。
+ * 字段缺失或不是数字时抛出 std::runtime_error，并指出行号与列号。
+ */
+DataTable parseCsv(const std::string& text, const CsvOptions& options = CsvOptions());
+DataTable loadCsv(const std::string& path, const CsvOptions& options = CsvOptions());
+
+#endif // DATA_TABLE_H
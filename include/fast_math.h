@@ -0,0 +1,138 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief 数学函数精度档位
+ *
+ * 误差预算（在 tests/functional_test.cpp 中对照 libm 验证）:
+ *
+ * | 档位   | exp 相对误差 | sigmoid / tanh 绝对误差 | 实现                         |
+ * |--------|--------------|-------------------------|------------------------------|
+ * | Exact  | libm         | libm                    | std::exp / std::tanh         |
+ * | High   | < 1e-7       | < 1e-7                  | 7 次多项式 + 指数位拼接      |
+ * | Fast   | < 1e-4       | < 1e-4                  | 4 次多项式 + 指数位拼接      |
+ *
+ * 近似 exp 的输入被限制在 [-708, 709]，超出范围时返回边界值而非 0/inf；
+ * sigmoid/tanh 在该范围外已经饱和，不受影响。近似函数不含分支与 libm 调用，
+ * 批量循环可被编译器自动向量化。
+ */
+enum class MathPrecision {
+    Exact,
+    High,
+    Fast
+};
+
+namespace fast_math_detail {
+
+constexpr double kLog2e = 1.4426950408889634;
+constexpr double kLn2Hi = 0.6931471803691238;     // ln2 高位
+constexpr double kLn2Lo = 1.9082149292705877e-10; // ln2 低位
+constexpr double kShift = 6755399441055744.0;     // 1.5 * 2^52，用于舍入取整
+constexpr double kExpMin = -708.0;
+constexpr double kExpMax = 709.0;
+
+// exp(r), |r| <= ln2/2，Horner 形式的截断 Taylor 多项式
+template <MathPrecision P>
+inline double expPoly(double r) {
+    if constexpr (P == MathPrecision::Fast) {
+        // 4 次：截断误差 <= (ln2/2)^5 / 5! ≈ 4.2e-5
+        return 1.0 + r * (1.0 + r * (1.0 / 2.0 + r * (1.0 / 6.0 + r * (1.0 / 24.0))));
+    } else {
+        // 7 次：截断误差 <= (ln2/2)^8 / 8! ≈ 5.2e-9
+        return 1.0 + r * (1.0 + r * (1.0 / 2.0 + r * (1.0 / 6.0 + r * (1.0 / 24.0 +
+               r * (1.0 / 120.0 + r * (1.0 / 720.0 + r * (1.0 / 5040.0)))))));
+    }
+}
+
+} // namespace fast_math_detail
+
+/**
+ * @brief exp(x) = 2^n * exp(r)，n = round(x / ln2)，2^n 直接写入 IEEE-754 指数位
+ */
+template <MathPrecision P>
+inline double expApprox(double x) {
+    if constexpr (P == MathPrecision::Exact) {
+        return std::exp(x);
+    } else {
+        using namespace fast_math_detail;
+        x = std::min(std::max(x, kExpMin), kExpMax);
+        const double kd = x * kLog2e + kShift;
+        const double n = kd - kShift;
+        const double r = (x - n * kLn2Hi) - n * kLn2Lo;
+
+        // kd 的尾数低位即为 n（补码），加上指数偏置后移入指数字段
+        std::uint64_t ki;
+        std::memcpy(&ki, &kd, sizeof(ki));
+        const std::uint64_t scaleBits = (ki + 1023u) << 52;
+        double scale;
+        std::memcpy(&scale, &scaleBits, sizeof(scale));
+
+        return scale * expPoly<P>(r);
+    }
+}
+
+template <MathPrecision P>
+inline double sigmoidApprox(double x) {
+    return 1.0 / (1.0 + expApprox<P>(-std::clamp(x, -500.0, 500.0)));
+}
+
+template <MathPrecision P>
+inline double tanhApprox(double x) {
+    if constexpr (P == MathPrecision::Exact) {
+        return std::tanh(x);
+    } else {
+        // tanh(x) = 1 - 2 / (exp(2x) + 1)，|x| > 20 时已饱和
+        const double e = expApprox<P>(2.0 * std::clamp(x, -20.0, 20.0));
+        return 1.0 - 2.0 / (e + 1.0);
+    }
+}
+
+// ========== 批量版本（可向量化） ==========
+
+template <MathPrecision P>
+inline void expApprox(const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = expApprox<P>(x[i]);
+    }
+}
+
+template <MathPrecision P>
+inline void sigmoidApprox(const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = sigmoidApprox<P>(x[i]);
+    }
+}
+
+template <MathPrecision P>
+inline void tanhApprox(const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = tanhApprox<P>(x[i]);
+    }
+}
+
+/**
+ * @brief 将运行时精度分派为编译期常量: fn(std::integral_constant<MathPrecision, P>{})
+ */
+template <typename Fn>
+inline void visitPrecision(MathPrecision precision, Fn&& fn) {
+    switch (precision) {
+        case MathPrecision::High:
+            fn(std::integral_constant<MathPrecision, MathPrecision::High>{});
+            return;
+        case MathPrecision::Fast:
+            fn(std::integral_constant<MathPrecision, MathPrecision::Fast>{});
+            return;
+        case MathPrecision::Exact:
+            break;
+    }
+    fn(std::integral_constant<MathPrecision, MathPrecision::Exact>{});
+}
+
+#endif // FAST_MATH_H
@@ -0,0 +1,66 @@
+#ifndef IDX_DATASET_H
+#define IDX_DATASET_H
+
+#include "cnn/tensor.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 像素归一化方式
+enum class IdxNormalization {
+    None,        // 保留 0..255
+    UnitRange,   // 缩放到 [0, 1]
+    Standardize  // 减去均值、除以标准差（默认按所加载文件自身的统计量）
+};
+
+// 归一化参数：像素 x 变为 (x - offset) * scale
+struct IdxStatistics {
+    double offset = 0.0;
+    double scale = 1.0;
+};
+
+IdxNormalization idxNormalizationFromName(const std::string& name);
+
+struct IdxLoadOptions {
+    IdxNormalization normalization = IdxNormalization::UnitRange;
+    size_t limit = 0;       // 只取前 limit 个样本，0 为全部
+    std::string cachePath;  // 非空时把解码结果缓存为二进制数据集（见 mapped_dataset.h）
+    // 为 true 时直接使用 statistics 而不按 normalization 统计，
+    // 如测试集沿用训练集的 IdxDataset::statistics，两者归一化一致
+    bool useStatistics = false;
+    IdxStatistics statistics;
+};
+
+// 解码后的数据集：图像 (1, rows, cols) 与 one-hot 标签
+struct IdxDataset {
+    std::vector<Tensor> images;
+    std::vector<std::vector<double>> labels;
+    size_t numClasses = 0;
+    IdxStatistics statistics; // 实际使用的归一化参数
+    bool fromCache = false;
+};
+
+/**
+ * @brief 读取 IDX 格式（MNIST / Fashion-MNIST）的图像与标签文件
+ *
+ * 只读取本地未压缩文件（.gz 需先解压）。文件整体顺序读入后，由全局线程池按块并行完成
+ * 解码、归一化与转换为 Tensor；Standardize 先并行统计均值与方差。类别数为最大标签值加一。
+ *
+ * 指定 cachePath 时：缓存存在、比源文件新且预处理方式与样本数一致则直接从缓存读取，
+ * 否则解码后写出缓存，下次启动跳过解码。从缓存读取 Standardize 数据集时，
+ * statistics 由源图像文件重新统计（只读原始字节，不解码）。
+ */
+IdxDataset loadIdxDataset(const std::string& imagesPath, const std::string& labelsPath,
+                          const IdxLoadOptions& options = IdxLoadOptions());
+
+/**
+ * @brief 确保 options.cachePath 处有与源文件一致的缓存，返回其路径
+ *
+ * 缓存可用 MappedDataset 直接映射训练，不必把整个数据集载入内存。
+ * statistics 非空时写入缓存所用的归一化参数（用于以相同参数加载测试集）。
+ */
+std::string buildIdxCache(const std::string& imagesPath, const std::string& labelsPath,
+                          const IdxLoadOptions& options, IdxStatistics* statistics = nullptr);
+
+#endif // IDX_DATASET_H
@@ -5,6 +5,7 @@
 #include <QPainter>
 #include <vector>
 #include <deque>
+#include "progress_throttle.h"
 
 class LossChart : public QWidget {
     Q_OBJECT
@@ -13,6 +14,8 @@ public:
     explicit LossChart(QWidget* parent = nullptr);
 
     void addDataPoint(int epoch, double loss);
+    // 批量添加（训练线程按帧合并的进度），只重算一次坐标范围
+    void addDataPoints(const std::vector<LossPoint>& points);
     void clear();
     void setMaxPoints(int maxPoints);
 
@@ -24,6 +27,7 @@ private:
     void drawAxes(QPainter& painter);
     void drawCurve(QPainter& painter);
     void drawLabels(QPainter& painter);
+    void updateRange();
 
     std::deque<std::pair<int, double>> dataPoints_;
     int maxPoints_ = 500;
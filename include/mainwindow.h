@@ -15,6 +15,7 @@
 #include <QTextEdit>
 #include <memory>
 
+#include "data_table.h"
 #include "neural_network.h"
 #include "network_view.h"
 #include "loss_chart.h"
@@ -32,7 +33,7 @@ private slots:
     void onStopTraining();
     void onPauseResumeTraining();
     void onResetNetwork();
-    void onEpochCompleted(int epoch, double loss);
+    void onProgressUpdated(const std::vector<LossPoint>& points);
     void onTrainingCompleted();
     void onWeightsUpdated();
     void onDatasetChanged(int index);
@@ -40,7 +41,9 @@ private slots:
 private:
     void setupUI();
     void createNetwork();
-    void loadDataset(int datasetIndex);
+    // 加载失败或取消时返回 false，保留原数据集
+    bool loadDataset(int datasetIndex);
+    bool loadCsvDataset();
     void updateStatus(const QString& message);
     void log(const QString& message);
 
@@ -48,9 +51,9 @@ private:
     std::unique_ptr<NeuralNetwork> network_;
     std::unique_ptr<TrainingThread> trainingThread_;
 
-    // 训练数据
-    std::vector<std::vector<double>> trainInputs_;
-    std::vector<std::vector<double>> trainTargets_;
+    // 训练数据（连续存储，输入层与输出层大小随数据集变化）
+    DataTable trainData_;
+    int datasetIndex_ = 0; // 当前生效的数据集，取消选择 CSV 文件时恢复
 
     // UI组件
     NetworkView* networkView_;
@@ -0,0 +1,150 @@
+#ifndef MAPPED_DATASET_H
+#define MAPPED_DATASET_H
+
+#include "cnn/random.h"
+#include "cnn/tensor_view.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 二进制数据集文件头（64 字节，小端序）
+ *
+ * 文件布局:
+ *   [头 64 字节][样本区: sampleCount 个 C*H*W 的 double，连续存放][对齐填充][标签区: sampleCount 个 labelSize 的 double]
+ * 样本区与标签区的起始偏移都按 64 字节对齐，映射后每个样本可直接作为 TensorView 使用。
+ */
+struct DatasetFileHeader {
+    char magic[8];           // "NNDSET\0\0"
+    uint32_t version;
+    uint32_t byteOrder;      // 写入 0x01020304，读取时用于检测字节序
+    uint32_t channels;
+    uint32_t height;
+    uint32_t width;
+    uint32_t labelSize;      // 每个样本的标签长度（如 one-hot 类别数）
+    uint64_t sampleCount;
+    uint64_t samplesOffset;
+    uint64_t labelsOffset;
+    uint32_t tag;            // 生成方自定义的标记（如预处理方式），读取端可据此判断缓存是否可用
+    uint8_t reserved[4];
+};
+static_assert(sizeof(DatasetFileHeader) == 64, "DatasetFileHeader must be 64 bytes");
+
+/**
+ * @brief 顺序写出二进制数据集
+ *
+ * 样本直接流式写入文件，标签暂存在内存中，finish() 时写在样本区之后并回填文件头。
+ * 析构时若尚未 finish() 会自动完成（忽略错误）；需要检查错误时显式调用 finish()。
+ */
+class DatasetWriter {
+public:
+    DatasetWriter(const std::string& path, size_t channels, size_t height, size_t width,
+                  size_t labelSize);
+    ~DatasetWriter();
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    void append(const TensorView& sample, const std::vector<double>& label);
+    void finish();
+
+    void setTag(uint32_t tag) { header_.tag = tag; }
+
+    size_t size() const { return count_; }
+
+private:
+    std::string path_;
+    std::ofstream file_;
+    DatasetFileHeader header_;
+    std::vector<double> labels_;
+    std::vector<double> buffer_; // 非连续视图的打包缓冲
+    size_t count_ = 0;
+    bool finished_ = false;
+};
+
+/**
+ * @brief 以内存映射方式只读打开的二进制数据集
+ *
+ * 文件不会整体读入内存：sample() 返回直接指向映射区的零拷贝 TensorView，
+ * 页面在首次访问时由操作系统按需读入，内存紧张时可被回收，因此数据集可以远大于物理内存。
+ * 视图在 MappedDataset 存活期间有效。只读，可被多个线程同时访问。
+ */
+class MappedDataset {
+public:
+    explicit MappedDataset(const std::string& path);
+    ~MappedDataset();
+
+    MappedDataset(const MappedDataset&) = delete;
+    MappedDataset& operator=(const MappedDataset&) = delete;
+
+    size_t size() const { return static_cast<size_t>(header_.sampleCount); }
+    bool empty() const { return size() == 0; }
+    size_t channels() const { return header_.channels; }
+    size_t height() const { return header_.height; }
+    size_t width() const { return header_.width; }
+    size_t sampleSize() const { return channels() * height() * width(); }
+    size_t labelSize() const { return header_.labelSize; }
+    uint32_t tag() const { return header_.tag; }
+
+    TensorView sample(size_t index) const;
+    // 指向 labelSize() 个连续 double
+    const double* label(size_t index) const;
+
+    // 提示操作系统预读该样本及其标签所在的页面（异步，不阻塞）
+    void prefetch(size_t index) const;
+    // 随机访问提示：打乱顺序读取时关闭内核的顺序预读
+    void adviseRandomAccess() const;
+
+private:
+    void checkIndex(size_t index) const;
+    void unmap();
+
+    DatasetFileHeader header_;
+    const unsigned char* base_ = nullptr;
+    size_t mappedBytes_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+// 一个小批量：样本编号、零拷贝输入视图与标签指针
+struct DatasetBatch {
+    std::vector<size_t> indices;
+    std::vector<TensorView> inputs;
+    std::vector<const double*> targets;
+
+    size_t size() const { return indices.size(); }
+};
+
+/**
+ * @brief 按（打乱的）小批量顺序遍历 MappedDataset
+ *
+ * 样本顺序由 ShuffledBatchSampler 给出：第 e 轮的顺序只由 (seed, e) 决定，
+ * startEpoch() 进入下一轮，next() 依次给出小批量（最后一批可能不满）。取出一批时会预读下一批的页面，使磁盘读取与本批计算重叠。
+ */
+class DatasetBatchReader {
+public:
+    DatasetBatchReader(const MappedDataset& dataset, size_t batchSize, uint64_t seed,
+                       bool shuffle = true);
+
+    // 进入下一轮并重新打乱；构造后即处于第 0 轮
+    void startEpoch();
+    // 本轮已遍历完时返回 false
+    bool next(DatasetBatch& batch);
+
+    size_t batchSize() const { return sampler_.batchSize(); }
+    size_t batchesPerEpoch() const { return sampler_.batchesPerEpoch(); }
+    size_t epoch() const { return static_cast<size_t>(sampler_.epoch()); }
+
+private:
+    // 预读本轮接下来一批的页面
+    void prefetchNext() const;
+
+    const MappedDataset& dataset_;
+    ShuffledBatchSampler sampler_;
+};
+
+#endif // MAPPED_DATASET_H
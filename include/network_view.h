@@ -25,7 +25,6 @@ private:
     QColor getActivationColor(double activation);
 
     NeuralNetwork* network_;
-    std::vector<int> layerSizes_;
     int neuronRadius_ = 20;
     int layerSpacing_ = 150;
     int neuronSpacing_ = 50;
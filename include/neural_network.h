@@ -7,6 +7,11 @@
 #include <cmath>
 #include <memory>
 #include <mutex>
+#include "activation_kernels.h"
+#include "cnn/random.h"
+#include "data_table.h"
+#include "snapshot_publisher.h"
+#include "training_control.h"
 
 // 激活函数类型
 enum class ActivationType {
@@ -15,6 +20,25 @@ enum class ActivationType {
     Tanh
 };
 
+// 按激活类型与数学精度分派到对应的内联内核: fn(SigmoidKernelT<P>{}) 等
+template <typename Fn>
+inline void visitActivation(ActivationType type, MathPrecision precision, Fn&& fn) {
+    visitPrecision(precision, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        switch (type) {
+            case ActivationType::Sigmoid: fn(SigmoidKernelT<P>{}); return;
+            case ActivationType::ReLU: fn(ReLUKernel{}); return;
+            case ActivationType::Tanh: fn(TanhKernelT<P>{}); return;
+        }
+        fn(IdentityKernel{});
+    });
+}
+
+template <typename Fn>
+inline void visitActivation(ActivationType type, Fn&& fn) {
+    visitActivation(type, MathPrecision::Exact, std::forward<Fn>(fn));
+}
+
 // 单个层的结构
 struct Layer {
     int inputSize;
@@ -26,8 +50,11 @@ struct Layer {
     std::vector<double> delta;
     ActivationType activation;
 
-    Layer(int inSize, int outSize, ActivationType act = ActivationType::Sigmoid);
-    void initializeWeights();
+    // 权重由 rng 决定：第 j 个神经元的权重与偏置来自 rng.stream(j)，
+    // 与初始化时是否并行、在哪个线程上无关
+    Layer(int inSize, int outSize, ActivationType act = ActivationType::Sigmoid,
+          PhiloxRng rng = nextRandomStream());
+    void initializeWeights(PhiloxRng rng);
     
     inline double& weight(int out, int in) {
         const size_t idx = static_cast<size_t>(out) * static_cast<size_t>(inputSize) + static_cast<size_t>(in);
@@ -39,6 +66,29 @@ struct Layer {
     }
 };
 
+// 单层的可视化快照（只含权重与激活，不含训练用的中间缓存）
+struct LayerSnapshot {
+    int inputSize = 0;
+    int outputSize = 0;
+    ActivationType activation = ActivationType::Sigmoid;
+    std::vector<double> weights;
+    std::vector<double> biases;
+    std::vector<double> output;
+
+    // 从层复制当前状态，复用已有容量
+    void capture(const Layer& layer);
+
+    inline double weight(int out, int in) const {
+        return weights[static_cast<size_t>(out) * static_cast<size_t>(inputSize) + static_cast<size_t>(in)];
+    }
+};
+
+// 整个网络在某一时刻的不可变快照，由 NeuralNetwork::publishSnapshot() 发布
+struct NetworkSnapshot {
+    std::vector<int> layerSizes; // 含输入层
+    std::vector<LayerSnapshot> layers;
+};
+
 // 神经网络类
 class NeuralNetwork {
 public:
@@ -59,10 +109,21 @@ public:
     // 更新权重
     void updateWeights(double learningRate);
 
-    // 训练
+    // 训练一轮；control 非空时在样本之间检查取消，提前结束时返回已训练样本的平均损失
     double train(const std::vector<std::vector<double>>& inputs,
                  const std::vector<std::vector<double>>& targets,
-                 double learningRate);
+                 double learningRate,
+                 const TrainingControl* control = nullptr);
+
+    // 同上，直接按行读取 DataTable 的连续存储，每个样本不再分配内存
+    double train(const DataTable& data, double learningRate, const TrainingControl* control = nullptr);
+
+    // 网络的随机种子：决定 build() 的初始权重与打乱顺序，需在 build() 之前设置。
+    // 未设置时取自 nextRandomStream()，随 setGlobalSeed() 可复现
+    void setSeed(uint64_t seed);
+    // 开启后每次 train() 按新的随机顺序遍历样本；第 e 次调用的顺序只由种子与 e 决定
+    void setShuffle(bool shuffle);
+    bool shuffle() const;
 
     // 计算损失 (均方误差)
     double calculateLoss(const std::vector<double>& output,
@@ -77,27 +138,42 @@ public:
     // 获取权重信息（用于可视化）
     std::vector<std::vector<std::vector<double>>> getAllWeights() const;
 
-private:
-    // 激活函数
-    double activate(double x, ActivationType type);
-    double activateDerivative(double x, ActivationType type);
-    double activateDerivativeOutput(double y, ActivationType type);
+    // 发布当前权重与激活的快照（build() 后自动发布一次，训练线程每轮之后调用）。
+    // 读端用 latestSnapshot() 无锁获取，绘制期间不会阻塞训练
+    void publishSnapshot();
+    std::shared_ptr<const NetworkSnapshot> latestSnapshot() const { return snapshots_.latest(); }
 
-    std::vector<double> forwardInternal(const std::vector<double>& input);
-    void backwardInternal(const std::vector<double>& target);
+    // 激活函数 exp/tanh 的计算精度（默认 Exact，见 fast_math.h）
+    void setMathPrecision(MathPrecision precision);
+    MathPrecision mathPrecision() const;
+
+private:
+    void checkInputSize(size_t size) const;
+    void checkTargetSize(size_t size) const;
+    // 单个样本的前向、损失、反向与更新；调用方负责检查长度
+    double trainSampleInternal(const double* input, const double* target, double learningRate);
+    // 结果留在 layers_.back().output
+    void forwardInternal(const double* input);
+    void backwardInternal(const double* target);
     void updateWeightsInternal(double learningRate);
-    double calculateLossInternal(const std::vector<double>& output,
-                                 const std::vector<double>& target);
+    double calculateLossInternal(const double* output, const double* target, size_t size) const;
+    // 本轮的样本顺序；不打乱时为 0..count-1
+    const std::vector<size_t>& epochOrder(size_t count);
 
     int inputSize_;
     std::vector<int> layerSizes_;
     std::vector<ActivationType> activations_;
     std::vector<Layer> layers_;
     bool isBuilt_;
+    MathPrecision precision_ = MathPrecision::Exact;
 
     mutable std::mutex mutex_;
+    SnapshotPublisher<NetworkSnapshot> snapshots_; // 写端由 mutex_ 串行化
 
-    std::mt19937 rng_;
+    PhiloxRng rng_;
+    bool shuffle_ = false;
+    uint64_t epoch_ = 0;
+    std::vector<size_t> order_;
 };
 
 #endif // NEURAL_NETWORK_H
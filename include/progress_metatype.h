@@ -0,0 +1,15 @@
+#ifndef PROGRESS_METATYPE_H
+#define PROGRESS_METATYPE_H
+
+#include <QMetaType>
+#include <vector>
+#include "progress_throttle.h"
+
+// 训练线程通过排队连接发送批量损失点，需要向 Qt 元类型系统注册
+Q_DECLARE_METATYPE(std::vector<LossPoint>)
+
+inline void registerProgressMetaTypes() {
+    qRegisterMetaType<std::vector<LossPoint>>("std::vector<LossPoint>");
+}
+
+#endif // PROGRESS_METATYPE_H
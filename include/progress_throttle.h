@@ -0,0 +1,67 @@
+#ifndef PROGRESS_THROTTLE_H
+#define PROGRESS_THROTTLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// 一个训练进度点（轮次与损失）
+struct LossPoint {
+    int epoch;
+    double loss;
+};
+
+/**
+ * @brief 训练进度的限频合并器
+ *
+ * 训练线程每轮调用 record()，全速计算；只有距上次刷新超过一帧（1 / rateHz 秒）时
+ * record() 才返回 true，此时调用 takeBatch() 取走这一帧内累积的损失点，一次性发给界面。
+ * 这样界面刷新频率与训练速度解耦，训练耗时不再受界面刷新影响。
+ *
+ * 每帧的点数有上限：累积超过 maxPointsPerBatch 的两倍时按 2 抽 1 稀疏化，并加倍之后的
+ * 采样间隔，因此单帧开销与轮次速度无关。最新的点总会包含在批次末尾。
+ * 非线程安全，只应由训练线程使用。
+ */
+class ProgressThrottle {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double kDefaultRateHz = 30.0;
+    static constexpr size_t kDefaultMaxPointsPerBatch = 256;
+
+    explicit ProgressThrottle(double rateHz = kDefaultRateHz,
+                              size_t maxPointsPerBatch = kDefaultMaxPointsPerBatch);
+
+    // rateHz <= 0 表示不限频，每个点都立即刷新
+    void setRate(double rateHz);
+    double rate() const { return rateHz_; }
+
+    // 记录一个点；返回 true 表示应当刷新（调用 takeBatch()）
+    bool record(int epoch, double loss) { return record(epoch, loss, Clock::now()); }
+    bool record(int epoch, double loss, Clock::time_point now);
+
+    // 是否有尚未取走的点
+    bool hasPending() const { return hasLatest_; }
+
+    // 取走累积的点（按轮次递增，末尾为最新点）并开始新的一帧
+    std::vector<LossPoint> takeBatch() { return takeBatch(Clock::now()); }
+    std::vector<LossPoint> takeBatch(Clock::time_point now);
+
+    // 丢弃累积的点，下一个点立即刷新
+    void reset();
+
+private:
+    double rateHz_;
+    Clock::duration interval_;
+    size_t maxPoints_;
+
+    std::vector<LossPoint> pending_;
+    LossPoint latest_{0, 0.0};
+    bool hasLatest_ = false;
+    size_t stride_ = 1;     // 当前采样间隔（稀疏化后加倍）
+    size_t sinceKept_ = 0;  // 距上一个保留点的轮数
+    Clock::time_point lastFlush_;
+    bool flushed_ = false;  // 是否已经刷新过（首个点立即刷新）
+};
+
+#endif // PROGRESS_THROTTLE_H
@@ -0,0 +1,71 @@
+#ifndef SNAPSHOT_PUBLISHER_H
+#define SNAPSHOT_PUBLISHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 单写者、多读者的不可变快照发布器
+ *
+ * 写端（训练线程）在私有缓冲区里填好一份快照后，用一次原子指针替换发布出去；
+ * 读端（GUI 线程）用 latest() 取得当前快照的 shared_ptr，之后可以任意长时间读取，
+ * 既不会看到写了一半的数据，也不会阻塞写端或被写端阻塞。
+ *
+ * 典型用法:
+ *   auto snap = publisher.acquire();   // 可复用的缓冲区
+ *   ...填充 *snap...
+ *   publisher.publish(std::move(snap));
+ *
+ * acquire() 会回收已经没有读者持有的上一代快照，稳态下写端在“当前、读者持有、
+ * 正在填充”三份缓冲区之间轮转（相当于三缓冲），不再反复分配内存。
+ * acquire()/publish() 只能由同一个写线程调用；latest()/version() 任意线程可调用。
+ */
+template <typename T>
+class SnapshotPublisher {
+public:
+    SnapshotPublisher() = default;
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    // 取得一份可写缓冲区：优先复用无人持有的旧快照（内容为旧数据，需整体覆盖）
+    std::shared_ptr<T> acquire() {
+        if (spare_) return std::move(spare_);
+        return std::make_shared<T>();
+    }
+
+    // 发布新快照；被替换下来的旧快照若已无读者，留作下次 acquire() 的缓冲区
+    void publish(std::shared_ptr<T> snapshot) {
+        std::shared_ptr<const T> previous =
+            std::atomic_exchange_explicit(&current_, std::shared_ptr<const T>(std::move(snapshot)),
+                                          std::memory_order_acq_rel);
+        version_.fetch_add(1, std::memory_order_release);
+
+        // 替换之后新的读者已拿不到 previous，引用计数为 1 说明只剩这里持有
+        if (previous && previous.use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            spare_ = std::const_pointer_cast<T>(std::move(previous));
+        }
+    }
+
+    // 最新发布的快照；尚未发布时为空
+    std::shared_ptr<const T> latest() const {
+        return std::atomic_load_explicit(&current_, std::memory_order_acquire);
+    }
+
+    // 已发布的次数，可用于判断是否有新快照
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // 丢弃当前快照（例如网络结构改变后）
+    void clear() {
+        std::atomic_store_explicit(&current_, std::shared_ptr<const T>(), std::memory_order_release);
+        spare_.reset();
+    }
+
+private:
+    std::shared_ptr<const T> current_;
+    std::shared_ptr<T> spare_;
+    std::atomic<uint64_t> version_{0};
+};
+
+#endif // SNAPSHOT_PUBLISHER_H
@@ -0,0 +1,44 @@
+#ifndef SYNTHETIC_DATASETS_H
+#define SYNTHETIC_DATASETS_H
+
+#include <string>
+#include <vector>
+#include "cnn/random.h"
+#include "cnn/tensor.h"
+
+/**
+ * @brief 可视化程序与命令行训练器共用的合成数据集
+ *
+ * 与界面无关：MLP 的逻辑门/圆形分类、CNN 的形状图像、注意力网络的排序任务。
+ * 随机数由调用者传入的 PhiloxRng 给出，固定种子即可在任意平台上逐位复现。
+ */
+
+// MLP 二维分类数据集
+enum class TabularDataset {
+    XOR,
+    AND,
+    OR,
+    Circle // 单位正方形内随机点，半径 0.5（归一化前）内为正类
+};
+
+struct TabularData {
+    std::vector<std::vector<double>> inputs;
+    std::vector<std::vector<double>> targets;
+};
+
+TabularData makeTabularDataset(TabularDataset dataset, PhiloxRng& gen, int circleSamples = 100);
+
+// 按名称 ("xor", "and", "or", "circle") 查找，未知名称抛出 std::invalid_argument
+TabularDataset tabularDatasetFromName(const std::string& name);
+
+// 单通道形状图像 (1, size, size)：shapeClass % 3 依次为圆形、方形、十字形，带高斯噪声
+Tensor makeShapeImage(int shapeClass, int size, PhiloxRng& gen);
+
+// 每类 samplesPerClass 张形状图像与 one-hot 标签，按类别顺序排列；各图像使用独立子流并行生成
+void makeShapeDataset(int size, int numClasses, int samplesPerClass, PhiloxRng& gen,
+                      std::vector<Tensor>& images, std::vector<std::vector<double>>& labels);
+
+// 排序任务：input 为 [0, 1) 内的随机序列 (1, seqLen, 1)，target 为其升序排列
+void makeSortSample(size_t seqLen, PhiloxRng& gen, Tensor& input, Tensor& target);
+
+#endif // SYNTHETIC_DATASETS_H
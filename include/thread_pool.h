@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 固定大小的工作线程池
+ *
+ * 进程内共享一个实例 (ThreadPool::global())，线程数为硬件并发数减一，
+ * 调用线程本身也参与 parallelFor 的计算。parallelFor 中的任务可以再次调用
+ * parallelFor：调用者会自己领取剩余的下标，因此嵌套调用不会死锁。
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t numWorkers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& global();
+
+    size_t workerCount() const { return workers_.size(); }
+
+    /**
+     * @brief 对 [0, count) 中每个下标并行调用 fn(i)，全部完成后返回
+     *
+     * 任务抛出的第一个异常会在调用线程中重新抛出。
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,43 @@
+#ifndef TRAINING_CONTROL_H
+#define TRAINING_CONTROL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief 训练线程的暂停/恢复/取消控制
+ *
+ * 控制端（GUI 线程）调用 pause()/resume()/stop()，训练线程在轮次之间调用
+ * checkpoint()：未暂停时只是两次原子读取；暂停时在条件变量上等待，不占用 CPU，
+ * resume() 或 stop() 会立即唤醒它。训练循环内部（小批量之间）用 stopRequested()
+ * 检查取消，使取消不必等到一整轮结束。
+ */
+class TrainingControl {
+public:
+    TrainingControl() = default;
+    TrainingControl(const TrainingControl&) = delete;
+    TrainingControl& operator=(const TrainingControl&) = delete;
+
+    // 新一次训练开始前清除暂停与取消状态
+    void reset();
+
+    void pause();
+    void resume();
+    // 请求取消；同时唤醒处于暂停中的训练线程
+    void stop();
+
+    bool isPaused() const { return paused_.load(std::memory_order_acquire); }
+    bool stopRequested() const { return stop_.load(std::memory_order_acquire); }
+
+    // 暂停时阻塞到恢复或取消；返回 false 表示应当停止训练
+    bool checkpoint();
+
+private:
+    std::atomic<bool> paused_{false};
+    std::atomic<bool> stop_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+#endif // TRAINING_CONTROL_H
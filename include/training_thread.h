@@ -5,7 +5,9 @@
 #include <QMutex>
 #include <atomic>
 #include <vector>
+#include "data_table.h"
 #include "neural_network.h"
+#include "progress_metatype.h"
 
 class TrainingThread : public QThread {
     Q_OBJECT
@@ -16,20 +18,24 @@ public:
 
     // 设置训练参数
     void setNetwork(NeuralNetwork* network);
-    void setTrainingData(const std::vector<std::vector<double>>& inputs,
-                         const std::vector<std::vector<double>>& targets);
+    // 训练数据按值传入并移动保存，调用方不再需要时可 std::move 以免复制
+    void setTrainingData(DataTable data);
     void setParameters(int epochs, double learningRate);
+    // 界面进度刷新频率（默认 30 Hz，<= 0 为每轮刷新），训练本身全速运行
+    void setUpdateRate(double rateHz);
 
-    // 控制
+    // 控制（先清除上次的停止/暂停请求再启动线程，之后发出的请求不会被覆盖）
+    void startTraining();
     void stopTraining();
     void pauseTraining();
     void resumeTraining();
 
-    bool isPaused() const { return paused_; }
+    bool isPaused() const { return control_.isPaused(); }
     bool isRunning() const { return running_; }
 
 signals:
-    void epochCompleted(int epoch, double loss);
+    // 一帧内累积的损失点（按轮次递增，末尾为最新轮次）
+    void progressUpdated(const std::vector<LossPoint>& points);
     void trainingCompleted();
     void weightsUpdated();
 
@@ -38,17 +44,19 @@ protected:
 
 private:
     NeuralNetwork* network_;
-    std::vector<std::vector<double>> inputs_;
-    std::vector<std::vector<double>> targets_;
+    DataTable data_;
 
     int epochs_;
     double learningRate_;
+    double updateRateHz_ = ProgressThrottle::kDefaultRateHz;
 
     std::atomic<bool> running_;
-    std::atomic<bool> paused_;
-    std::atomic<bool> stopRequested_;
+    TrainingControl control_;
 
     QMutex mutex_;
+
+    // 发布网络快照并把累积的进度一次性发给界面
+    void flushProgress(ProgressThrottle& throttle);
 };
 
 #endif // TRAINING_THREAD_H
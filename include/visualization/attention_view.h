@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include "attention/attention_network.h"
+#include "cnn/tensor_view.h"
 
 class AttentionView : public QWidget {
     Q_OBJECT
@@ -19,9 +20,11 @@ private:
     AttentionNetwork* network_;
 
     // Helper to draw a matrix/tensor
-    void drawMatrix(QPainter& painter, const Tensor& tensor, const QRect& rect, const QString& title);
+    void drawMatrix(QPainter& painter, const TensorView& tensor, const QRect& rect, const QString& title);
+    // Shades the cells of a weights heatmap that the sparse/causal pattern masks out
+    void drawMaskOverlay(QPainter& painter, const AttentionSnapshot& snapshot, const QRect& rect);
     // Helper to draw sequence
-    void drawSequence(QPainter& painter, const Tensor& seq, const QRect& rect, const QString& title);
+    void drawSequence(QPainter& painter, const TensorView& seq, const QRect& rect, const QString& title);
 };
 
 #endif // ATTENTION_VIEW_H
@@ -33,9 +33,9 @@ protected:
     void mousePressEvent(QMouseEvent* event) override;
 
 private:
-    void drawInputLayer(QPainter& painter, int x, int y);
-    void drawCNNLayer(QPainter& painter, int layerIndex, int x, int y);
-    void drawDenseLayer(QPainter& painter, int layerIndex, int x, int y);
+    void drawInputLayer(QPainter& painter, const CNNSnapshot& snapshot, int x, int y);
+    void drawCNNLayer(QPainter& painter, const CNNLayerSnapshot& layer, int x, int y);
+    void drawDenseLayer(QPainter& painter, const LayerSnapshot& layer, int x, int y);
     void draw3DBox(QPainter& painter, int x, int y, int w, int h, int d, const QColor& color);
     void drawConnection(QPainter& painter, int x1, int y1, int x2, int y2);
 
@@ -6,6 +6,7 @@
 #include <QScrollArea>
 #include <QMouseEvent>
 #include "../cnn/tensor.h"
+#include "../cnn/tensor_view.h"
 
 /**
  * @brief 特征图详细可视化组件
@@ -19,6 +20,8 @@ public:
     explicit FeatureMapView(QWidget* parent = nullptr);
 
     void setFeatureMap(const Tensor& featureMap, const QString& layerName);
+    // 任意跨步视图（通道切片/子窗口等），物化为连续张量
+    void setFeatureMap(const TensorView& featureMap, const QString& layerName);
     void clear();
 
     enum ColorMap { Grayscale, Heatmap, Viridis };
@@ -1,114 +1,429 @@
 #include "attention/attention_layer.h"
+#include "attention/positional_encoding.h"
 #include "cnn/random.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
-AttentionLayer::AttentionLayer(size_t d_model, size_t d_k)
-    : d_model_(d_model), d_k_(d_k) {
+AttentionLayer::AttentionLayer(size_t d_model, size_t d_k, size_t num_heads)
+    : AttentionLayerBase(d_model, d_k, num_heads) {
 
     // Initialize weights
-    // Xavier initialization
+    // Xavier initialization (same distribution as separate Q/K/V matrices)
     size_t fanIn = d_model;
     size_t fanOut = d_k;
 
-    W_Q_ = Tensor(1, d_model, d_k); W_Q_.xavierInit(fanIn, fanOut);
-    W_K_ = Tensor(1, d_model, d_k); W_K_.xavierInit(fanIn, fanOut);
-    W_V_ = Tensor(1, d_model, d_k); W_V_.xavierInit(fanIn, fanOut);
+    W_QKV_ = Tensor(1, d_model, 3 * d_k); W_QKV_.xavierInit(fanIn, fanOut);
     W_O_ = Tensor(1, d_k, d_model); W_O_.xavierInit(fanOut, fanIn);
 }
 
-Tensor AttentionLayer::forward(const Tensor& input) {
-    input_ = input; // Cache (1, Seq, D_model)
+void AttentionLayer::setPattern(const AttentionPattern& pattern) {
+    AttentionLayerBase::setPattern(pattern);
+    weightsStale_ = true;
+}
 
-    // Linear projections
-    // Input is (1, L, D). W is (1, D, K).
-    // Matmul: (1, L, D) * (1, D, K) -> (1, L, K)
-    Q_ = input.matmul(W_Q_);
-    K_ = input.matmul(W_K_);
-    V_ = input.matmul(W_V_);
+void AttentionLayer::rotateQK(double* row, const double* angles, bool inverse) const {
+    // angles holds (sin, cos) of the rotation angle for each pair of head columns
+    const double sign = inverse ? -1.0 : 1.0;
+    for (size_t block = 0; block < 2; ++block) {
+        for (size_t head = 0; head < num_heads_; ++head) {
+            double* x = row + block * d_k_ + head * d_head_;
+            for (size_t m = 0; m + 1 < d_head_; m += 2) {
+                const double sinA = sign * angles[m];
+                const double cosA = angles[m + 1];
+                const double x0 = x[m];
+                const double x1 = x[m + 1];
+                x[m] = x0 * cosA - x1 * sinA;
+                x[m + 1] = x0 * sinA + x1 * cosA;
+            }
+        }
+    }
+}
 
-    // Scaled Dot-Product Attention
-    // Q: (1, L, K). K^T: (1, K, L).
-    // Scores: (1, L, L)
-    Tensor K_T = K_.transpose();
-    scores_ = Q_.matmul(K_T);
-    scores_ *= (1.0 / std::sqrt(static_cast<double>(d_k_)));
+TensorView AttentionLayer::projection(size_t block) const {
+    return TensorView(QKV_).window(0, block * d_k_, seqLen_, d_k_);
+}
 
-    // Softmax
-    attentionWeights_ = scores_; // copy
-    attentionWeights_.softmax();
+// Keys [begin, end) taken every step rows
+struct KeyRange {
+    size_t begin;
+    size_t end;
+    size_t step;
+};
 
-    // Output
-    // Weights: (1, L, L). V: (1, L, K) -> Output: (1, L, K)
-    Tensor context = attentionWeights_.matmul(V_);
+// Keys visible to query i when positions [0, end) exist (end = i + 1 under causal masking):
+// the global prefix plus the strided local window, as at most two disjoint ranges
+static size_t keyRanges(const AttentionPattern& pattern, size_t i, size_t end, KeyRange* out) {
+    const size_t G = pattern.globalTokens;
+    if (pattern.isDense() || i < G) {
+        out[0] = {0, end, 1};
+        return 1;
+    }
+    size_t count = 0;
+    if (G > 0) out[count++] = {0, G, 1};
 
-    // Final projection
-    // Context (1, L, K) * W_O (1, K, D) -> (1, L, D)
-    Tensor output = context.matmul(W_O_);
+    // Local keys i + m * d, stopping short of the global prefix already covered
+    const size_t d = pattern.dilation;
+    size_t back = (i - G) / d;
+    size_t ahead = (end - 1 - i) / d;
+    if (pattern.window > 0) {
+        back = std::min(back, pattern.window);
+        ahead = std::min(ahead, pattern.window);
+    }
+    out[count++] = {i - back * d, i + ahead * d + 1, d};
+    return count;
+}
+
+size_t AttentionLayer::headWork() const {
+    // Keys each query visits (upper bound)
+    size_t keys = seqLen_;
+    if (!pattern_.isDense()) {
+        const size_t local = pattern_.window > 0 ? 2 * pattern_.window + 1 : seqLen_ / pattern_.dilation + 1;
+        keys = std::min(seqLen_, local + pattern_.globalTokens);
+    }
+    return batch_ * seqLen_ * keys * d_k_;
+}
+
+// ========== Tiled attention kernels ==========
+//
+// Per head, with S = Q K^T * scale and P = softmax(S) row-wise:
+//   forward:  O_i = sum_j P_ij V_j, computed with an online softmax over K/V tiles
+//             (running max m_i and running sum l_i); stores lse_i = m_i + log(l_i)
+//   backward: P_ij = exp(S_ij - lse_i), D_i = dO_i . O_i,
+//             dV_j += P_ij dO_i, dS_ij = P_ij (dO_i . V_j - D_i),
+//             dQ_i += dS_ij K_j * scale, dK_j += dS_ij Q_i * scale
+// Rows of Q/K/V are strided views into QKV_ (stride 3 * D_k); context rows have stride D_k.
+// Sequence b occupies rows [b * L, b * L + len_b); padded rows neither attend nor get
+// attended to, and their context and gradients stay zero. With causal masking, row i
+// only sees keys j <= i. A sparse pattern narrows each row to its key ranges, which are
+// walked with a row stride of step * kvStride, so masked keys are never touched.
+
+static double dot(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    for (size_t d = 0; d < n; ++d) sum += a[d] * b[d];
+    return sum;
+}
+
+static void axpy(double alpha, const double* x, double* y, size_t n) {
+    for (size_t d = 0; d < n; ++d) y[d] += alpha * x[d];
+}
+
+// Online-softmax attention of one query row over the given key/value ranges, streamed
+// in tiles. Writes the normalized output row to oi and returns the row's log-sum-exp.
+template <MathPrecision P>
+static double attendRow(const double* qi, const double* k, const double* v, size_t kvStride,
+                        const KeyRange* ranges, size_t numRanges, size_t dh, double scale, double* oi) {
+    constexpr size_t kTile = AttentionLayer::kTile;
+    double scores[kTile];
+    double rowMax = -std::numeric_limits<double>::infinity();
+    double rowSum = 0.0;
+    std::fill_n(oi, dh, 0.0);
+
+    for (size_t r = 0; r < numRanges; ++r) {
+        const KeyRange& range = ranges[r];
+        const size_t n = (range.end - range.begin + range.step - 1) / range.step;
+        const size_t rowStride = range.step * kvStride;
+        const double* kr = k + range.begin * kvStride;
+        const double* vr = v + range.begin * kvStride;
+
+        for (size_t j0 = 0; j0 < n; j0 += kTile) {
+            const size_t bc = std::min(kTile, n - j0);
+            double tileMax = rowMax;
+            for (size_t c = 0; c < bc; ++c) {
+                scores[c] = dot(qi, kr + (j0 + c) * rowStride, dh) * scale;
+                tileMax = std::max(tileMax, scores[c]);
+            }
+
+            // Rescale what has been accumulated so far to the new running max
+            if (tileMax > rowMax) {
+                const double correction = expApprox<P>(rowMax - tileMax);
+                rowSum *= correction;
+                for (size_t d = 0; d < dh; ++d) oi[d] *= correction;
+                rowMax = tileMax;
+            }
+
+            for (size_t c = 0; c < bc; ++c) {
+                const double weight = expApprox<P>(scores[c] - rowMax);
+                rowSum += weight;
+                axpy(weight, vr + (j0 + c) * rowStride, oi, dh);
+            }
+        }
+    }
+
+    const double invSum = 1.0 / rowSum;
+    for (size_t d = 0; d < dh; ++d) oi[d] *= invSum;
+    return rowMax + std::log(rowSum);
+}
+
+void AttentionLayer::forwardHead(size_t unit) {
+    const size_t head = unit % num_heads_;
+    const size_t row0 = (unit / num_heads_) * seqLen_;
+    const size_t len = lengths_[unit / num_heads_];
+    const size_t stride = 3 * d_k_;
+    const double* q = QKV_.rawData() + row0 * stride + head * d_head_;
+    const double* k = q + d_k_;
+    const double* v = q + 2 * d_k_;
+    double* lse = &lse_(head, row0, 0);
+    const double scale = 1.0 / std::sqrt(static_cast<double>(d_head_));
+
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        KeyRange ranges[2];
+        for (size_t i = 0; i < len; ++i) {
+            // Causal: row i sees keys [0, i]
+            const size_t numRanges = keyRanges(pattern_, i, causal_ ? i + 1 : len, ranges);
+            lse[i] = attendRow<P>(q + i * stride, k, v, stride, ranges, numRanges, d_head_, scale,
+                                  &context_(0, row0 + i, head * d_head_));
+        }
+    });
+}
+
+void AttentionLayer::backwardHead(size_t unit, const Tensor& dContext, Tensor& dQKV) const {
+    const size_t head = unit % num_heads_;
+    const size_t row0 = (unit / num_heads_) * seqLen_;
+    const size_t L = lengths_[unit / num_heads_];
+    const size_t stride = 3 * d_k_;
+    const double* q = QKV_.rawData() + row0 * stride + head * d_head_;
+    const double* k = q + d_k_;
+    const double* v = q + 2 * d_k_;
+    double* dq = dQKV.rawData() + row0 * stride + head * d_head_;
+    double* dk = dq + d_k_;
+    double* dv = dq + 2 * d_k_;
+    const double* lse = &lse_(head, row0, 0);
+    const double scale = 1.0 / std::sqrt(static_cast<double>(d_head_));
+
+    // D_i = dO_i . O_i
+    std::vector<double> rowDot(L);
+    for (size_t i = 0; i < L; ++i) {
+        rowDot[i] = dot(&dContext(0, row0 + i, head * d_head_), &context_(0, row0 + i, head * d_head_), d_head_);
+    }
+
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+
+        // Gradient contributions of one (query, key) pair
+        auto visitPair = [&](size_t i, size_t j) {
+            const double* qi = q + i * stride;
+            const double* kj = k + j * stride;
+            const double* vj = v + j * stride;
+            const double* dOi = &dContext(0, row0 + i, head * d_head_);
+            const double prob = expApprox<P>(dot(qi, kj, d_head_) * scale - lse[i]);
+            const double dScore = prob * (dot(dOi, vj, d_head_) - rowDot[i]) * scale;
+
+            axpy(prob, dOi, dv + j * stride, d_head_);
+            axpy(dScore, kj, dq + i * stride, d_head_);
+            axpy(dScore, qi, dk + j * stride, d_head_);
+        };
+
+        if (pattern_.isDense()) {
+            // K/V tiles outer so their gradients stay hot while every query row visits them
+            for (size_t j0 = 0; j0 < L; j0 += kTile) {
+                const size_t bc = std::min(kTile, L - j0);
+                // Causal: rows before the tile never see its keys
+                for (size_t i = causal_ ? j0 : 0; i < L; ++i) {
+                    const size_t cEnd = causal_ ? std::min(bc, i + 1 - j0) : bc;
+                    for (size_t c = 0; c < cEnd; ++c) visitPair(i, j0 + c);
+                }
+            }
+        } else {
+            // Sparse: each query row walks only its key ranges, which stay local
+            KeyRange ranges[2];
+            for (size_t i = 0; i < L; ++i) {
+                const size_t numRanges = keyRanges(pattern_, i, causal_ ? i + 1 : L, ranges);
+                for (size_t r = 0; r < numRanges; ++r) {
+                    for (size_t j = ranges[r].begin; j < ranges[r].end; j += ranges[r].step) visitPair(i, j);
+                }
+            }
+        }
+    });
+}
+
+const Tensor& AttentionLayer::getWeights() const {
+    if (weightsStale_) {
+        // First sequence of the batch; padded and masked entries stay 0
+        const size_t L = lengths_.empty() ? 0 : lengths_[0];
+        const double scale = 1.0 / std::sqrt(static_cast<double>(d_head_));
+        attentionWeights_.resize(num_heads_, seqLen_, seqLen_);
+        const size_t stride = 3 * d_k_;
+        KeyRange ranges[2];
+        for (size_t head = 0; head < num_heads_; ++head) {
+            const double* q = QKV_.rawData() + head * d_head_;
+            const double* k = q + d_k_;
+            for (size_t i = 0; i < L; ++i) {
+                const size_t numRanges = keyRanges(pattern_, i, causal_ ? i + 1 : L, ranges);
+                for (size_t r = 0; r < numRanges; ++r) {
+                    for (size_t j = ranges[r].begin; j < ranges[r].end; j += ranges[r].step) {
+                        const double score = dot(q + i * stride, k + j * stride, d_head_) * scale;
+                        attentionWeights_(head, i, j) = std::exp(score - lse_(head, i, 0));
+                    }
+                }
+            }
+        }
+        weightsStale_ = false;
+    }
+    return attentionWeights_;
+}
+
+Tensor AttentionLayer::forward(const Tensor& input, const std::vector<size_t>& lengths) {
+    setBatchShape(input, lengths);
+
+    // Cache (B * Seq) rows of D_model; the batch is folded into the row dimension
+    input_ = Tensor(input).asRows();
+    const size_t rows = input_.height();
+
+    // Packed linear projection over every row of the batch at once
+    // Input is (1, BL, D). W_QKV is (1, D, 3K).
+    // Matmul: (1, BL, D) * (1, D, 3K) -> (1, BL, 3K) = [Q | K | V]
+    QKV_ = input_.matmul(W_QKV_);
+
+    // RoPE: rotate Q and K by their position within the sequence
+    if (rotary_) {
+        TensorView table = PositionalEncodingCache::sinusoidal(d_head_, seqLen_);
+        for (size_t r = 0; r < rows; ++r) {
+            rotateQK(&QKV_(0, r, 0), &table(0, r % seqLen_, 0), false);
+        }
+    }
+
+    // Scaled Dot-Product Attention, tiled per (sequence, head)
+    // Each unit writes its own context block and lse rows, so units are independent
+    context_.resize(1, rows, d_k_);
+    lse_.resize(num_heads_, rows, 1);
+    forEachSequenceHead(headWork(), [&](size_t unit) { forwardHead(unit); });
+    weightsStale_ = true;
 
-    return output;
+    // Final projection
+    // Context (1, BL, K) * W_O (1, K, D) -> (1, BL, D) -> (B, L, D)
+    return context_.matmul(W_O_).reshape(batch_, seqLen_, d_model_);
 }
 
 Tensor AttentionLayer::backward(const Tensor& gradOutput, double learningRate) {
     // Simple gradient descent implementation (Backpropagation)
+    const TensorView dOutput = gradOutput.asRows();
 
     // 1. Gradient of W_O
     // Output = Context * W_O
     // dW_O = Context^T * gradOutput
     // dContext = gradOutput * W_O^T
-    Tensor context = attentionWeights_.matmul(V_); // Recompute context
-    Tensor dW_O = context.transpose().matmul(gradOutput);
-    Tensor dContext = gradOutput.matmul(W_O_.transpose());
-
-    // 2. Gradient of Attention Weights and V
-    // Context = Weights * V
-    // dV = Weights^T * dContext
-    // dWeights = dContext * V^T
-    Tensor dV = attentionWeights_.transpose().matmul(dContext);
-    Tensor dWeights = dContext.matmul(V_.transpose());
-
-    // 3. Gradient of Softmax (Scores)
-    // dScores = Weights * (dWeights - sum(dWeights * Weights))
-    // Note: simplified row-wise softmax gradient
-    Tensor dScores = dWeights; // placeholder for shape
-    for(size_t c=0; c<dScores.channels(); ++c) {
-        for(size_t h=0; h<dScores.height(); ++h) {
-            double sum_grad_p = 0.0;
-            for(size_t w=0; w<dScores.width(); ++w) {
-                sum_grad_p += dWeights(c, h, w) * attentionWeights_(c, h, w);
-            }
-            for(size_t w=0; w<dScores.width(); ++w) {
-                double s = attentionWeights_(c, h, w);
-                dScores(c, h, w) = s * (dWeights(c, h, w) - sum_grad_p);
-            }
+    Tensor dW_O = matmul(TensorView(context_).transposed(), dOutput);
+    Tensor dContext = matmul(dOutput, TensorView(W_O_).transposed());
+
+    // 2. Gradient of Q, K, V, recomputing attention probabilities tile by tile
+    Tensor dQKV(1, QKV_.height(), 3 * d_k_);
+    forEachSequenceHead(headWork(), [&](size_t unit) { backwardHead(unit, dContext, dQKV); });
+
+    // RoPE is orthogonal per position: gradients w.r.t. the unrotated projection are R^T dQ, R^T dK
+    if (rotary_) {
+        TensorView table = PositionalEncodingCache::sinusoidal(d_head_, seqLen_);
+        for (size_t r = 0; r < dQKV.height(); ++r) {
+            rotateQK(&dQKV(0, r, 0), &table(0, r % seqLen_, 0), true);
         }
     }
 
-    // 4. Scaling
-    dScores *= (1.0 / std::sqrt(static_cast<double>(d_k_)));
+    // 3. Gradient of the packed projection (one GEMM each)
+    // QKV = Input * W_QKV -> dW_QKV = Input^T * dQKV, dInput = dQKV * W_QKV^T
+    Tensor dW_QKV = matmul(TensorView(input_).transposed(), dQKV);
+    Tensor dInput = matmul(dQKV, TensorView(W_QKV_).transposed());
 
-    // 5. Gradient of Q and K
-    // Scores = Q * K^T
-    // dQ = dScores * K
-    // dK^T = Q^T * dScores -> dK = (Q^T * dScores)^T = dScores^T * Q
-    Tensor dQ = dScores.matmul(K_);
-    Tensor dK = dScores.transpose().matmul(Q_);
+    // Update Weights
+    W_QKV_ -= dW_QKV * learningRate;
+    W_O_ -= dW_O * learningRate;
 
-    // 6. Gradient of Weights Q, K, V
-    // Q = Input * W_Q -> dW_Q = Input^T * dQ, dInput_Q = dQ * W_Q^T
-    Tensor input_T = input_.transpose();
-    Tensor dW_Q = input_T.matmul(dQ);
-    Tensor dW_K = input_T.matmul(dK);
-    Tensor dW_V = input_T.matmul(dV);
+    return dInput.reshape(batch_, seqLen_, d_model_);
+}
 
-    Tensor dInput = dQ.matmul(W_Q_.transpose()) +
-                    dK.matmul(W_K_.transpose()) +
-                    dV.matmul(W_V_.transpose());
+void AttentionLayer::reserveCache(size_t rows) {
+    // Ring buffer: exactly one slot per position in the window
+    if (cacheWindow_ > 0) {
+        if (kvCache_.height() != cacheWindow_) kvCache_ = Tensor(1, cacheWindow_, 2 * d_k_);
+        return;
+    }
+    if (rows <= kvCache_.height()) return;
 
-    // Update Weights
-    W_Q_ -= dW_Q * learningRate;
-    W_K_ -= dW_K * learningRate;
-    W_V_ -= dW_V * learningRate;
-    W_O_ -= dW_O * learningRate;
+    // Grow geometrically so a stream of single-token appends copies O(L) rows in total
+    const size_t capacity = std::max({rows, 2 * kvCache_.height(), kTile});
+    Tensor grown(1, capacity, 2 * d_k_);
+    if (cacheLen_ > 0) {
+        std::copy_n(kvCache_.rawData(), cacheLen_ * 2 * d_k_, grown.rawData());
+    }
+    kvCache_ = std::move(grown);
+}
+
+// Maps position ranges to ring-buffer slots (slot = pos % W), keeping only positions
+// >= lo. The window spans at most W positions, so each range wraps at most once.
+static size_t ringRanges(const KeyRange* in, size_t numIn, size_t lo, size_t W, KeyRange* out) {
+    size_t count = 0;
+    for (size_t r = 0; r < numIn; ++r) {
+        const size_t step = in[r].step;
+        size_t begin = in[r].begin;
+        if (begin < lo) begin += (lo - begin + step - 1) / step * step;
+        if (begin >= in[r].end) continue;
+
+        const size_t n = (in[r].end - begin + step - 1) / step;
+        const size_t slot = begin % W;
+        const size_t beforeWrap = std::min(n, (W - slot + step - 1) / step);
+        out[count++] = {slot, slot + (beforeWrap - 1) * step + 1, step};
+        if (beforeWrap < n) {
+            const size_t wrapped = (begin + beforeWrap * step) % W;
+            out[count++] = {wrapped, wrapped + (n - beforeWrap - 1) * step + 1, step};
+        }
+    }
+    return count;
+}
+
+Tensor AttentionLayer::forwardIncremental(const Tensor& newRows) {
+    const size_t T = newRows.height();
+    const size_t stride = 2 * d_k_;
+
+    // Project only the new rows: (1, T, D) * (1, D, 3K) -> (1, T, 3K)
+    Tensor qkv = newRows.matmul(W_QKV_);
+    if (rotary_) {
+        if (cacheWindow_ > 0) {
+            // Unbounded stream: compute each row's angles instead of growing the shared table
+            std::vector<double> angles(d_head_);
+            for (size_t t = 0; t < T; ++t) {
+                PositionalEncodingCache::sinusoidalRow(d_head_, cacheLen_ + t, angles.data());
+                rotateQK(&qkv(0, t, 0), angles.data(), false);
+            }
+        } else {
+            TensorView table = PositionalEncodingCache::sinusoidal(d_head_, cacheLen_ + T);
+            for (size_t t = 0; t < T; ++t) {
+                rotateQK(&qkv(0, t, 0), &table(0, cacheLen_ + t, 0), false);
+            }
+        }
+    }
+
+    // Each new row appends its key/value, then attends to the cached keys up to and
+    // including itself (within the pattern, and within the window for a ring buffer).
+    // Rows go one at a time so a ring slot is never overwritten before its last reader.
+    reserveCache(cacheLen_ + T);
+    Tensor context(1, T, d_k_);
+    const double scale = 1.0 / std::sqrt(static_cast<double>(d_head_));
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        KeyRange ranges[2];
+        KeyRange slots[4];
+        for (size_t t = 0; t < T; ++t) {
+            const size_t pos = cacheLen_ + t;
+            const size_t W = cacheWindow_;
+            std::copy_n(&qkv(0, t, d_k_), stride, &kvCache_(0, W > 0 ? pos % W : pos, 0));
+
+            size_t numRanges = keyRanges(pattern_, pos, pos + 1, ranges);
+            const KeyRange* visible = ranges;
+            if (W > 0) {
+                numRanges = ringRanges(ranges, numRanges, pos + 1 - std::min(W, pos + 1), W, slots);
+                visible = slots;
+            }
+            for (size_t head = 0; head < num_heads_; ++head) {
+                const double* k = kvCache_.rawData() + head * d_head_;
+                const double* v = k + d_k_;
+                attendRow<P>(&qkv(0, t, head * d_head_), k, v, stride, visible, numRanges,
+                             d_head_, scale, &context(0, t, head * d_head_));
+            }
+        }
+    });
+    cacheLen_ += T;
 
-    return dInput;
+    return context.matmul(W_O_);
 }
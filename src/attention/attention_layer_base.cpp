@@ -0,0 +1,77 @@
+#include "attention/attention_layer_base.h"
+#include "attention/attention_layer.h"
+#include "attention/linear_attention_layer.h"
+#include "thread_pool.h"
+#include <stdexcept>
+#include <string>
+
+// Below this many multiply-adds per forward/backward the heads run serially;
+// dispatching to the pool costs more than it saves.
+static constexpr size_t kParallelHeadWork = 1 << 15;
+
+bool AttentionPattern::allows(size_t i, size_t j) const {
+    if (isDense() || i < globalTokens || j < globalTokens) return true;
+    const size_t distance = i > j ? i - j : j - i;
+    return distance % dilation == 0 && (window == 0 || distance / dilation <= window);
+}
+
+AttentionLayerBase::AttentionLayerBase(size_t d_model, size_t d_k, size_t num_heads)
+    : d_model_(d_model), d_k_(d_k), num_heads_(num_heads) {
+
+    if (num_heads == 0 || d_k % num_heads != 0) {
+        throw std::invalid_argument("d_k (" + std::to_string(d_k) + ") must be divisible by num_heads (" +
+                                    std::to_string(num_heads) + ")");
+    }
+    d_head_ = d_k / num_heads;
+}
+
+void AttentionLayerBase::setRotary(bool rotary) {
+    if (rotary && d_head_ % 2 != 0) {
+        throw std::invalid_argument("Rotary encoding needs an even head dimension, got " + std::to_string(d_head_));
+    }
+    rotary_ = rotary;
+}
+
+void AttentionLayerBase::setPattern(const AttentionPattern& pattern) {
+    if (pattern.dilation == 0) {
+        throw std::invalid_argument("Attention pattern dilation must be at least 1");
+    }
+    pattern_ = pattern;
+}
+
+void AttentionLayerBase::setBatchShape(const Tensor& input, const std::vector<size_t>& lengths) {
+    batch_ = input.channels();
+    seqLen_ = input.height();
+    if (lengths.empty()) {
+        lengths_.assign(batch_, seqLen_);
+        return;
+    }
+    if (lengths.size() != batch_) {
+        throw std::invalid_argument("Expected " + std::to_string(batch_) + " sequence lengths, got " +
+                                    std::to_string(lengths.size()));
+    }
+    for (size_t len : lengths) {
+        if (len > seqLen_) {
+            throw std::invalid_argument("Sequence length " + std::to_string(len) +
+                                        " exceeds padded length " + std::to_string(seqLen_));
+        }
+    }
+    lengths_ = lengths;
+}
+
+void AttentionLayerBase::forEachSequenceHead(size_t totalWork, const std::function<void(size_t)>& fn) const {
+    const size_t units = batch_ * num_heads_;
+    if (units > 1 && totalWork >= kParallelHeadWork) {
+        ThreadPool::global().parallelFor(units, fn);
+    } else {
+        for (size_t u = 0; u < units; ++u) fn(u);
+    }
+}
+
+std::unique_ptr<AttentionLayerBase> makeAttentionLayer(AttentionType type, size_t d_model, size_t d_k,
+                                                       size_t num_heads) {
+    if (type == AttentionType::Linear) {
+        return std::make_unique<LinearAttentionLayer>(d_model, d_k, num_heads);
+    }
+    return std::make_unique<AttentionLayer>(d_model, d_k, num_heads);
+}
@@ -1,86 +1,183 @@
 #include "attention/attention_network.h"
+#include "cnn/tensor_view.h"
 #include "cnn/random.h"
+#include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <stdexcept>
 
-AttentionNetwork::AttentionNetwork(size_t seqLen, size_t d_model, size_t d_k, size_t d_ff, size_t num_layers)
-    : seqLen_(seqLen), d_model_(d_model) {
+AttentionNetwork::AttentionNetwork(size_t seqLen, size_t d_model, size_t d_k, size_t d_ff, size_t num_layers,
+                                   size_t num_heads, PositionalEncodingType posEncoding,
+                                   AttentionType attentionType)
+    : seqLen_(seqLen), d_model_(d_model), numHeads_(num_heads), posEncodingType_(posEncoding),
+      attentionType_(attentionType) {
 
     // Embed
     W_embed_ = Tensor(1, 1, d_model);
     W_embed_.xavierInit(1, d_model);
     b_embed_ = Tensor(1, 1, d_model);
 
-    // Pos Encoding
-    posEncoding_ = Tensor(1, seqLen, d_model);
-    initPosEncoding();
+    // Pos Encoding (learned table starts from the sinusoidal one)
+    if (posEncoding == PositionalEncodingType::Learned) {
+        ensureLearnedEncoding(seqLen);
+    }
 
     // Blocks
     for (size_t i = 0; i < num_layers; ++i) {
-        blocks_.emplace_back(d_model, d_k, d_ff);
+        blocks_.emplace_back(d_model, d_k, d_ff, num_heads, attentionType);
+        blocks_.back().setRotary(posEncoding == PositionalEncodingType::Rotary);
     }
 
     // Output
     W_out_ = Tensor(1, d_model, 1);
     W_out_.xavierInit(d_model, 1);
     b_out_ = Tensor(1, 1, 1);
+
+    publishSnapshot();
 }
 
-void AttentionNetwork::initPosEncoding() {
-    for (size_t pos = 0; pos < seqLen_; ++pos) {
-        for (size_t i = 0; i < d_model_; ++i) {
-            if (i % 2 == 0) {
-                posEncoding_(0, pos, i) = std::sin(pos / std::pow(10000.0, (double)i / d_model_));
-            } else {
-                posEncoding_(0, pos, i) = std::cos(pos / std::pow(10000.0, (double)(i - 1) / d_model_));
-            }
-        }
+void AttentionNetwork::publishSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<AttentionSnapshot> snapshot = snapshots_.acquire();
+
+    snapshot->type = attentionType_;
+    snapshot->causal = causal_;
+    snapshot->pattern = pattern_;
+    snapshot->numHeads = numHeads_;
+    snapshot->input = input_;
+    snapshot->output = output_;
+    if (blocks_.empty() || input_.empty()) { // No forward yet: the projection caches are unallocated
+        snapshot->Q = snapshot->K = snapshot->V = snapshot->weights = Tensor();
+    } else {
+        const AttentionLayerBase& attn = blocks_[0].getAttention();
+        snapshot->Q = attn.getQ().toTensor();
+        snapshot->K = attn.getK().toTensor();
+        snapshot->V = attn.getV().toTensor();
+        snapshot->weights = attn.getWeights();
+    }
+
+    snapshots_.publish(std::move(snapshot));
+}
+
+void AttentionNetwork::setMathPrecision(MathPrecision precision) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    precision_ = precision;
+    for (auto& block : blocks_) {
+        block.setMathPrecision(precision);
+    }
+}
+
+MathPrecision AttentionNetwork::mathPrecision() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return precision_;
+}
+
+void AttentionNetwork::setFeedForwardActivation(FFNActivation activation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ffnActivation_ = activation;
+    for (auto& block : blocks_) {
+        block.setFeedForwardActivation(activation);
     }
 }
 
+FFNActivation AttentionNetwork::feedForwardActivation() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ffnActivation_;
+}
+
+void AttentionNetwork::setCausal(bool causal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    causal_ = causal;
+    for (auto& block : blocks_) {
+        block.setCausal(causal);
+    }
+}
+
+bool AttentionNetwork::isCausal() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return causal_;
+}
+
+void AttentionNetwork::setAttentionPattern(const AttentionPattern& pattern) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& block : blocks_) {
+        block.setAttentionPattern(pattern);
+    }
+    pattern_ = pattern;
+}
+
+AttentionPattern AttentionNetwork::attentionPattern() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pattern_;
+}
+
+void AttentionNetwork::ensureLearnedEncoding(size_t length) {
+    const size_t current = learnedPosEncoding_.height();
+    if (current >= length) return;
+
+    // Grow geometrically; trained rows are kept, new positions start from the sinusoidal table
+    const size_t grownLength = std::max(length, 2 * current);
+    Tensor grown = PositionalEncodingCache::sinusoidal(d_model_, grownLength).toTensor();
+    if (current > 0) {
+        std::copy_n(learnedPosEncoding_.rawData(), current * d_model_, grown.rawData());
+    }
+    learnedPosEncoding_ = std::move(grown);
+}
+
+TensorView AttentionNetwork::additiveEncoding(size_t length) {
+    switch (posEncodingType_) {
+        case PositionalEncodingType::Sinusoidal:
+            return PositionalEncodingCache::sinusoidal(d_model_, length);
+        case PositionalEncodingType::Learned:
+            ensureLearnedEncoding(length);
+            return TensorView(learnedPosEncoding_).window(0, 0, length, d_model_);
+        case PositionalEncodingType::Rotary:
+            break; // Applied inside attention instead
+    }
+    return TensorView();
+}
+
 Tensor AttentionNetwork::forward(const Tensor& input) {
     std::lock_guard<std::mutex> lock(mutex_);
-    input_ = input; // (1, L, 1)
 
     // Dynamic Sequence Length Support
-    if (input.height() != seqLen_) {
-        seqLen_ = input.height();
-        if (posEncoding_.height() != seqLen_) {
-            posEncoding_.resize(1, seqLen_, d_model_);
-            initPosEncoding();
-        }
-    }
+    seqLen_ = input.height();
+    forwardPacked(input, std::vector<size_t>(input.channels(), seqLen_));
+    return output_;
+}
 
-    // Embedding
-    // (1, L, 1) * (1, 1, D) -> (1, L, D)
-    embedded_ = input.matmul(W_embed_);
+void AttentionNetwork::forwardPacked(const Tensor& packed, const std::vector<size_t>& lengths) {
+    const size_t B = packed.channels();
+    const size_t L = packed.height();
+    input_ = packed; // (B, L, 1)
+    batchLengths_ = lengths;
 
-    // Add bias to embedding
-    for(size_t c=0; c<embedded_.channels(); ++c)
-        for(size_t h=0; h<embedded_.height(); ++h)
-            for(size_t w=0; w<embedded_.width(); ++w)
-                embedded_(c, h, w) += b_embed_(0, 0, w);
+    // Embedding, batch folded into rows
+    // (1, BL, 1) * (1, 1, D) -> (1, BL, D) -> (B, L, D)
+    blocksInput_ = input_.asRows().matmul(W_embed_).reshape(B, L, d_model_);
 
-    // Add Pos Encoding
-    blocksInput_ = embedded_ + posEncoding_;
+    // Add bias and Pos Encoding in one pass (prefix view of the shared table)
+    TensorView pe = additiveEncoding(L);
+    for(size_t c=0; c<B; ++c)
+        for(size_t h=0; h<L; ++h)
+            for(size_t w=0; w<d_model_; ++w)
+                blocksInput_(c, h, w) += b_embed_(0, 0, w) + (pe.empty() ? 0.0 : pe(0, h, w));
 
     // Blocks
     Tensor x = blocksInput_;
     for (auto& block : blocks_) {
-        x = block.forward(x);
+        x = block.forward(x, lengths);
     }
-    finalBlockOutput_ = x;
+    finalBlockOutput_ = std::move(x);
 
     // Output Head
-    // (1, L, D) * (1, D, 1) -> (1, L, 1)
-    output_ = finalBlockOutput_.matmul(W_out_);
-
-    // Add bias
-    for(size_t c=0; c<output_.channels(); ++c)
-        for(size_t h=0; h<output_.height(); ++h)
-            for(size_t w=0; w<output_.width(); ++w)
-                output_(c, h, w) += b_out_(0, 0, w);
+    // (1, BL, D) * (1, D, 1) -> (1, BL, 1) -> (B, L, 1)
+    output_ = finalBlockOutput_.asRows().matmul(W_out_).reshape(B, L, 1);
 
-    return output_;
+    // Add bias; padded positions are left at 0
+    for(size_t c=0; c<B; ++c)
+        for(size_t h=0; h<L; ++h)
+            output_(c, h, 0) = h < lengths[c] ? output_(c, h, 0) + b_out_(0, 0, 0) : 0.0;
 }
 
 double AttentionNetwork::backward(const Tensor& target, double learningRate) {
@@ -100,9 +197,17 @@ double AttentionNetwork::backward(const Tensor& target, double learningRate) {
     }
     loss /= N;
 
+    backwardPacked(gradOutput, learningRate);
+    return loss;
+}
+
+void AttentionNetwork::backwardPacked(const Tensor& gradOutput, double learningRate) {
+    const TensorView gradRows = gradOutput.asRows();
+
     // Output Head Backward
-    Tensor dFinalBlockOutput = gradOutput.matmul(W_out_.transpose());
-    Tensor dW_out = finalBlockOutput_.transpose().matmul(gradOutput);
+    Tensor dFinalBlockOutput = matmul(gradRows, TensorView(W_out_).transposed())
+                                   .reshape(gradOutput.channels(), gradOutput.height(), d_model_);
+    Tensor dW_out = matmul(TensorView(finalBlockOutput_.asRows()).transposed(), gradRows);
 
     // db_out
     Tensor db_out(1, 1, 1);
@@ -117,11 +222,17 @@ double AttentionNetwork::backward(const Tensor& target, double learningRate) {
         dX = blocks_[i].backward(dX, learningRate);
     }
 
-    // Pos Encoding (Fixed, no grad)
-    Tensor dEmbedded = dX;
+    // Pos Encoding (only the learned table has a gradient)
+    const Tensor& dEmbedded = dX;
+    if (posEncodingType_ == PositionalEncodingType::Learned) {
+        for(size_t c=0; c<dEmbedded.channels(); ++c)
+            for(size_t h=0; h<dEmbedded.height(); ++h)
+                for(size_t w=0; w<dEmbedded.width(); ++w)
+                    learnedPosEncoding_(0, h, w) -= learningRate * dEmbedded(c, h, w);
+    }
 
     // Embedding Backward
-    Tensor dW_embed = input_.transpose().matmul(dEmbedded);
+    Tensor dW_embed = matmul(TensorView(input_.asRows()).transposed(), dEmbedded.asRows());
 
     // db_embed
     Tensor db_embed(1, 1, d_model_);
@@ -132,6 +243,172 @@ double AttentionNetwork::backward(const Tensor& target, double learningRate) {
 
     W_embed_ -= dW_embed * learningRate;
     b_embed_ -= db_embed * learningRate;
+}
+
+std::vector<Tensor> AttentionNetwork::forwardBatch(const std::vector<Tensor>& sequences) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequences.empty()) return {};
+
+    // Pack into (B, Lmax, 1), zero padded
+    std::vector<size_t> lengths;
+    lengths.reserve(sequences.size());
+    size_t maxLen = 0;
+    for (const auto& seq : sequences) {
+        lengths.push_back(seq.height());
+        maxLen = std::max(maxLen, seq.height());
+    }
+    Tensor packed(sequences.size(), maxLen, 1);
+    for (size_t b = 0; b < sequences.size(); ++b) {
+        std::copy_n(sequences[b].rawData(), lengths[b], &packed(b, 0, 0));
+    }
+
+    forwardPacked(packed, lengths);
+
+    std::vector<Tensor> outputs;
+    outputs.reserve(sequences.size());
+    for (size_t b = 0; b < sequences.size(); ++b) {
+        Tensor out(1, lengths[b], 1);
+        std::copy_n(&output_(b, 0, 0), lengths[b], out.rawData());
+        outputs.push_back(std::move(out));
+    }
+    return outputs;
+}
+
+double AttentionNetwork::backwardBatch(const std::vector<Tensor>& targets, double learningRate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (targets.size() != batchLengths_.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(batchLengths_.size()) +
+                                    " targets, got " + std::to_string(targets.size()));
+    }
+
+    // MSE over real tokens only; padded positions get zero gradient
+    size_t N = 0;
+    for (size_t b = 0; b < targets.size(); ++b) {
+        if (targets[b].height() != batchLengths_[b]) {
+            throw std::invalid_argument("Target length mismatch for sequence " + std::to_string(b));
+        }
+        N += batchLengths_[b];
+    }
+    if (N == 0) return 0.0;
+
+    Tensor gradOutput(output_.channels(), output_.height(), 1);
+    double loss = 0.0;
+    for (size_t b = 0; b < targets.size(); ++b) {
+        for (size_t h = 0; h < batchLengths_[b]; ++h) {
+            double diff = output_(b, h, 0) - targets[b](0, h, 0);
+            loss += diff * diff;
+            gradOutput(b, h, 0) = 2.0 * diff / N;
+        }
+    }
+    loss /= N;
 
+    backwardPacked(gradOutput, learningRate);
     return loss;
 }
+
+std::vector<std::vector<size_t>> AttentionNetwork::bucketByLength(const std::vector<Tensor>& sequences,
+                                                                  size_t maxBatchSize) {
+    if (maxBatchSize == 0) {
+        throw std::invalid_argument("maxBatchSize must be positive");
+    }
+
+    // Neighbours in length order share a batch, so each batch pads to a close maximum
+    std::vector<size_t> order(sequences.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sequences[a].height() < sequences[b].height();
+    });
+
+    std::vector<std::vector<size_t>> buckets;
+    for (size_t start = 0; start < order.size(); start += maxBatchSize) {
+        const size_t end = std::min(order.size(), start + maxBatchSize);
+        buckets.emplace_back(order.begin() + start, order.begin() + end);
+    }
+    return buckets;
+}
+
+std::vector<Tensor> AttentionNetwork::forwardBucketed(const std::vector<Tensor>& sequences, size_t maxBatchSize) {
+    std::vector<Tensor> outputs(sequences.size());
+    for (const auto& bucket : bucketByLength(sequences, maxBatchSize)) {
+        std::vector<Tensor> batch;
+        batch.reserve(bucket.size());
+        for (size_t idx : bucket) batch.push_back(sequences[idx]);
+
+        std::vector<Tensor> batchOutputs = forwardBatch(batch);
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            outputs[bucket[i]] = std::move(batchOutputs[i]);
+        }
+    }
+    return outputs;
+}
+
+void AttentionNetwork::resetIncremental() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streamLen_ = 0;
+    for (auto& block : blocks_) {
+        block.resetCache();
+    }
+}
+
+size_t AttentionNetwork::incrementalLength() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streamLen_;
+}
+
+void AttentionNetwork::setContextWindow(size_t window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contextWindow_ = window;
+    streamLen_ = 0;
+    for (auto& block : blocks_) {
+        block.setCacheWindow(window);
+    }
+}
+
+size_t AttentionNetwork::contextWindow() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return contextWindow_;
+}
+
+Tensor AttentionNetwork::forwardIncremental(const Tensor& tokens) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t T = tokens.height();
+
+    // Embedding + bias + positional encoding at the stream offset
+    // (1, T, 1) * (1, 1, D) -> (1, T, D)
+    Tensor x = tokens.matmul(W_embed_);
+    if (contextWindow_ > 0) {
+        // Unbounded stream: no table may grow with the stream position
+        std::vector<double> pe(d_model_, 0.0);
+        for (size_t t = 0; t < T; ++t) {
+            const size_t pos = streamLen_ + t;
+            if (posEncodingType_ == PositionalEncodingType::Sinusoidal) {
+                PositionalEncodingCache::sinusoidalRow(d_model_, pos, pe.data());
+            } else if (posEncodingType_ == PositionalEncodingType::Learned) {
+                ensureLearnedEncoding(seqLen_);
+                const size_t row = std::min(pos, learnedPosEncoding_.height() - 1);
+                std::copy_n(&learnedPosEncoding_(0, row, 0), d_model_, pe.data());
+            }
+            for (size_t w = 0; w < d_model_; ++w)
+                x(0, t, w) += b_embed_(0, 0, w) + pe[w];
+        }
+    } else {
+        TensorView pe = additiveEncoding(streamLen_ + T);
+        for (size_t t = 0; t < T; ++t)
+            for (size_t w = 0; w < d_model_; ++w)
+                x(0, t, w) += b_embed_(0, 0, w) + (pe.empty() ? 0.0 : pe(0, streamLen_ + t, w));
+    }
+
+    // Blocks (each attends over its own KV cache)
+    for (auto& block : blocks_) {
+        x = block.forwardIncremental(x);
+    }
+    streamLen_ += T;
+
+    // Output Head
+    // (1, T, D) * (1, D, 1) -> (1, T, 1)
+    Tensor out = x.matmul(W_out_);
+    for (size_t t = 0; t < T; ++t)
+        out(0, t, 0) += b_out_(0, 0, 0);
+
+    return out;
+}
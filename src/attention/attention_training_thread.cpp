@@ -1,11 +1,12 @@
 #include "attention/attention_training_thread.h"
-#include <algorithm>
-#include <vector>
-#include <random>
+#include "data_pipeline.h"
+#include "synthetic_datasets.h"
+#include <utility>
 
 AttentionTrainingThread::AttentionTrainingThread()
-    : network_(nullptr), epochs_(1000), learningRate_(0.01), seqLen_(5),
-      running_(false), paused_(false) {}
+    : network_(nullptr), epochs_(1000), learningRate_(0.01), seqLen_(5) {
+    registerProgressMetaTypes();
+}
 
 AttentionTrainingThread::~AttentionTrainingThread() {
     stopTraining();
@@ -22,74 +23,82 @@ void AttentionTrainingThread::setParameters(int epochs, double learningRate, int
     seqLen_ = seqLen;
 }
 
+void AttentionTrainingThread::setUpdateRate(double rateHz) {
+    updateRateHz_ = rateHz;
+}
+
 void AttentionTrainingThread::startTraining() {
-    running_ = true;
-    paused_ = false;
+    control_.reset();
     start();
 }
 
 void AttentionTrainingThread::stopTraining() {
-    running_ = false;
-    resumeTraining();
+    control_.stop();
 }
 
 void AttentionTrainingThread::pauseTraining() {
-    paused_ = true;
+    control_.pause();
 }
 
 void AttentionTrainingThread::resumeTraining() {
-    QMutexLocker locker(&mutex_);
-    paused_ = false;
-    pauseCondition_.wakeAll();
+    control_.resume();
 }
 
 void AttentionTrainingThread::run() {
     if (!network_) return;
 
-    std::mt19937 gen(std::random_device{}());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
+    ProgressThrottle throttle(updateRateHz_);
+    const int batchSize = 50;
+
+    // Sort samples are synthesized on a generator thread and prefetched one batch ahead,
+    // so forward/backward never waits for data. While paused the generator sleeps on the full queue.
+    using SortSample = std::pair<Tensor, Tensor>;
+    const size_t seqLen = static_cast<size_t>(seqLen_);
+    DataPipeline<SortSample> samples(
+        [seqLen](size_t, PhiloxRng& gen) {
+            SortSample sample;
+            makeSortSample(seqLen, gen, sample.first, sample.second);
+            return sample;
+        },
+        kDataWorkers, 2 * batchSize, nextRandomStream()());
+    SortSample sample;
 
     for (int epoch = 1; epoch <= epochs_; ++epoch) {
-        if (!running_) break;
-
-        // Handle pause
-        {
-            QMutexLocker locker(&mutex_);
-            if (paused_) {
-                pauseCondition_.wait(&mutex_);
-            }
-        }
+        // Pause blocks on the control's condition variable; resume/stop wake it at once
+        if (control_.isPaused() && throttle.hasPending()) flushProgress(throttle);
+        if (!control_.checkpoint()) break;
 
         double epochLoss = 0.0;
-        int batchSize = 50;
 
         for (int b = 0; b < batchSize; ++b) {
-            // Generate Data
-            std::vector<double> data(seqLen_);
-            for (auto& v : data) v = dis(gen);
-
-            // Create Input Tensor
-            Tensor input = Tensor::fromVector(data, 1, seqLen_, 1);
-
-            // Create Target (Sorted)
-            std::vector<double> sortedData = data;
-            std::sort(sortedData.begin(), sortedData.end());
-            Tensor target = Tensor::fromVector(sortedData, 1, seqLen_, 1);
+            if (control_.stopRequested()) break; // Cancel between samples
+            samples.nextInOrder(sample);
 
             // Forward & Backward
-            network_->forward(input);
-            double loss = network_->backward(target, learningRate_);
+            network_->forward(sample.first);
+            double loss = network_->backward(sample.second, learningRate_);
             epochLoss += loss;
         }
 
-        epochLoss /= batchSize;
+        if (control_.stopRequested()) break; // Partial epoch: not reported
 
-        emit epochCompleted(epoch, epochLoss);
+        epochLoss /= batchSize;
 
-        if (epoch % 10 == 0) {
-            emit weightsUpdated();
+        // Training runs at full speed; the UI gets coalesced updates at its frame rate
+        if (throttle.record(epoch, epochLoss)) {
+            flushProgress(throttle);
         }
     }
 
+    if (throttle.hasPending()) {
+        flushProgress(throttle);
+    }
+
     emit trainingCompleted();
 }
+
+void AttentionTrainingThread::flushProgress(ProgressThrottle& throttle) {
+    network_->publishSnapshot();
+    emit progressUpdated(throttle.takeBatch());
+    emit weightsUpdated();
+}
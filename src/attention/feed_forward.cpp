@@ -0,0 +1,150 @@
+#include "attention/feed_forward.h"
+#include "activation_kernels.h"
+#include <algorithm>
+#include <stdexcept>
+
+FeedForward::FeedForward(size_t d_model, size_t d_ff, FFNActivation activation)
+    : d_model_(d_model), d_ff_(d_ff), activation_(activation) {
+
+    // Xavier initialization
+    W1_ = Tensor(1, d_model, d_ff); W1_.xavierInit(d_model, d_ff);
+    W2_ = Tensor(1, d_ff, d_model); W2_.xavierInit(d_ff, d_model);
+
+    // Biases (initialized to 0)
+    b1_ = Tensor(1, 1, d_ff);
+    b2_ = Tensor(1, 1, d_model);
+}
+
+template <typename Fn>
+void FeedForward::visitKernel(Fn&& fn) const {
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        if (activation_ == FFNActivation::GELU) {
+            fn(GELUKernelT<P>{});
+        } else {
+            fn(ReLUKernel{});
+        }
+    });
+}
+
+// y = act(x W + b) row by row, W row-major (K x N). The bias seeds the accumulator and
+// the activation runs as the epilogue of each row; pre (optional) receives x W + b.
+template <typename Kernel>
+static void denseForward(const double* x, const double* W, const double* b,
+                         double* pre, double* y, size_t rows, size_t K, size_t N) {
+    for (size_t r = 0; r < rows; ++r) {
+        const double* xr = x + r * K;
+        double* yr = y + r * N;
+        std::copy_n(b, N, yr);
+        for (size_t k = 0; k < K; ++k) {
+            const double xv = xr[k];
+            if (xv == 0.0) continue; // ReLU outputs are often zero
+            const double* wk = W + k * N;
+            for (size_t j = 0; j < N; ++j) {
+                yr[j] += xv * wk[j];
+            }
+        }
+        if (pre) {
+            std::copy_n(yr, N, pre + r * N);
+        }
+        for (size_t j = 0; j < N; ++j) {
+            yr[j] = Kernel::f(yr[j]);
+        }
+    }
+}
+
+static double dot(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+static void axpy(double alpha, const double* x, double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+Tensor FeedForward::forward(const Tensor& x) {
+    const size_t rows = x.channels() * x.height();
+    input_ = Tensor(x).asRows();
+    if (hidden_.height() != rows) {
+        hiddenPre_.resize(1, rows, d_ff_);
+        hidden_.resize(1, rows, d_ff_);
+    }
+    Tensor out(1, rows, d_model_);
+
+    visitKernel([&](auto kernel) {
+        using Kernel = decltype(kernel);
+        denseForward<Kernel>(input_.rawData(), W1_.rawData(), b1_.rawData(),
+                             hiddenPre_.rawData(), hidden_.rawData(), rows, d_model_, d_ff_);
+    });
+    denseForward<IdentityKernel>(hidden_.rawData(), W2_.rawData(), b2_.rawData(),
+                                 nullptr, out.rawData(), rows, d_ff_, d_model_);
+    return out;
+}
+
+Tensor FeedForward::infer(const Tensor& x) const {
+    const size_t rows = x.channels() * x.height();
+    Tensor hidden(1, rows, d_ff_);
+    Tensor out(1, rows, d_model_);
+
+    visitKernel([&](auto kernel) {
+        using Kernel = decltype(kernel);
+        denseForward<Kernel>(x.rawData(), W1_.rawData(), b1_.rawData(),
+                             nullptr, hidden.rawData(), rows, d_model_, d_ff_);
+    });
+    denseForward<IdentityKernel>(hidden.rawData(), W2_.rawData(), b2_.rawData(),
+                                 nullptr, out.rawData(), rows, d_ff_, d_model_);
+    return out;
+}
+
+void FeedForward::backward(const Tensor& gradOutput, double learningRate, Tensor& dInput) {
+    const size_t rows = input_.height();
+    if (gradOutput.size() != rows * d_model_ || dInput.size() != rows * d_model_) {
+        throw std::invalid_argument("FeedForward gradient size mismatch");
+    }
+
+    Tensor dW1(1, d_model_, d_ff_), db1(1, 1, d_ff_);
+    Tensor dW2(1, d_ff_, d_model_), db2(1, 1, d_model_);
+    std::vector<double> dPre(d_ff_);
+
+    const double* W1 = W1_.rawData();
+    const double* W2 = W2_.rawData();
+    double* gW1 = dW1.rawData();
+    double* gb1 = db1.rawData();
+    double* gW2 = dW2.rawData();
+    double* gb2 = db2.rawData();
+
+    visitKernel([&](auto kernel) {
+        using Kernel = decltype(kernel);
+        for (size_t r = 0; r < rows; ++r) {
+            const double* dy = gradOutput.rawData() + r * d_model_;
+            const double* x = input_.rawData() + r * d_model_;
+            const double* h = hidden_.rawData() + r * d_ff_;
+            const double* pre = hiddenPre_.rawData() + r * d_ff_;
+            double* dx = dInput.rawData() + r * d_model_;
+
+            // Dense 2: db2 += dy, dW2[f] += h_f * dy, and dPre_f = (dy . W2[f]) * act'(pre_f)
+            axpy(1.0, dy, gb2, d_model_);
+            for (size_t f = 0; f < d_ff_; ++f) {
+                const double* w2f = W2 + f * d_model_;
+                if (h[f] != 0.0) {
+                    axpy(h[f], dy, gW2 + f * d_model_, d_model_);
+                }
+                dPre[f] = dot(dy, w2f, d_model_) * Kernel::df(pre[f]);
+            }
+
+            // Dense 1: db1 += dPre, dW1[k] += x_k * dPre, dx_k += dPre . W1[k]
+            axpy(1.0, dPre.data(), gb1, d_ff_);
+            for (size_t k = 0; k < d_model_; ++k) {
+                const double* w1k = W1 + k * d_ff_;
+                axpy(x[k], dPre.data(), gW1 + k * d_ff_, d_ff_);
+                dx[k] += dot(dPre.data(), w1k, d_ff_);
+            }
+        }
+    });
+
+    W1_ -= dW1 * learningRate;
+    b1_ -= db1 * learningRate;
+    W2_ -= dW2 * learningRate;
+    b2_ -= db2 * learningRate;
+}
@@ -0,0 +1,296 @@
+#include "attention/linear_attention_layer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+LinearAttentionLayer::LinearAttentionLayer(size_t d_model, size_t d_k, size_t num_heads)
+    : AttentionLayerBase(d_model, d_k, num_heads) {
+
+    // Xavier initialization, as in AttentionLayer
+    W_QKV_ = Tensor(1, d_model, 3 * d_k); W_QKV_.xavierInit(d_model, d_k);
+    W_O_ = Tensor(1, d_k, d_model); W_O_.xavierInit(d_k, d_model);
+
+    resetCache();
+}
+
+void LinearAttentionLayer::setRotary(bool rotary) {
+    if (rotary) {
+        throw std::invalid_argument("Rotary encoding is not supported by linear attention");
+    }
+    AttentionLayerBase::setRotary(false);
+}
+
+void LinearAttentionLayer::setPattern(const AttentionPattern& pattern) {
+    if (!pattern.isDense()) {
+        throw std::invalid_argument("Sparse attention patterns are not supported by linear attention");
+    }
+    AttentionLayerBase::setPattern(pattern);
+}
+
+void LinearAttentionLayer::resetCache() {
+    kvState_ = Tensor(num_heads_, d_head_, d_head_);
+    keySum_ = Tensor(num_heads_, 1, d_head_);
+    streamLen_ = 0;
+}
+
+TensorView LinearAttentionLayer::projection(size_t block) const {
+    return TensorView(QKV_).window(0, block * d_k_, seqLen_, d_k_);
+}
+
+// ========== Linear attention kernels ==========
+//
+// Per head, with phi(x) = elu(x) + 1 applied elementwise, S = sum_j phi(k_j) v_j^T,
+// z = sum_j phi(k_j) (prefix sums j <= i under causal masking):
+//   forward:  n_i = S^T phi(q_i), den_i = phi(q_i) . z, o_i = n_i / den_i
+//   backward: dn_i = dO_i / den_i, dden_i = -(dO_i . o_i) / den_i,
+//             dphi(q_i) = S dn_i + z dden_i,
+//             dS = sum_i phi(q_i) dn_i^T, dz = sum_i phi(q_i) dden_i (suffix sums i >= j when causal),
+//             dphi(k_j) = dS v_j + dz, dv_j = dS^T phi(k_j)
+// S is stored row-major (row a = feature a), so S^T phi(q) is a sum of scaled rows.
+
+template <MathPrecision P>
+static double featureMap(double x) { return x > 0.0 ? x + 1.0 : expApprox<P>(x); }
+
+template <MathPrecision P>
+static double featureMapGrad(double x) { return x > 0.0 ? 1.0 : expApprox<P>(x); }
+
+static double dot(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    for (size_t d = 0; d < n; ++d) sum += a[d] * b[d];
+    return sum;
+}
+
+static void axpy(double alpha, const double* x, double* y, size_t n) {
+    for (size_t d = 0; d < n; ++d) y[d] += alpha * x[d];
+}
+
+// S += phi(k) v^T, z += phi(k); phiK receives phi(k)
+template <MathPrecision P>
+static void addKey(const double* k, const double* v, size_t dh, double* S, double* z, double* phiK) {
+    for (size_t a = 0; a < dh; ++a) {
+        phiK[a] = featureMap<P>(k[a]);
+        z[a] += phiK[a];
+        axpy(phiK[a], v, S + a * dh, dh);
+    }
+}
+
+// o = S^T phi(q) / (phi(q) . z); returns the normalizer
+template <MathPrecision P>
+static double readQuery(const double* q, const double* S, const double* z, size_t dh, double* phiQ, double* o) {
+    std::fill_n(o, dh, 0.0);
+    for (size_t a = 0; a < dh; ++a) {
+        phiQ[a] = featureMap<P>(q[a]);
+        axpy(phiQ[a], S + a * dh, o, dh);
+    }
+    const double den = dot(phiQ, z, dh);
+    const double invDen = 1.0 / den;
+    for (size_t d = 0; d < dh; ++d) o[d] *= invDen;
+    return den;
+}
+
+void LinearAttentionLayer::forwardHead(size_t unit) {
+    const size_t head = unit % num_heads_;
+    const size_t row0 = (unit / num_heads_) * seqLen_;
+    const size_t len = lengths_[unit / num_heads_];
+    const size_t stride = 3 * d_k_;
+    const size_t dh = d_head_;
+    const double* q = QKV_.rawData() + row0 * stride + head * dh;
+    const double* k = q + d_k_;
+    const double* v = q + 2 * d_k_;
+
+    std::vector<double> S(dh * dh, 0.0), z(dh, 0.0), phi(dh);
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        auto emit = [&](size_t i) {
+            denom_(head, row0 + i, 0) = readQuery<P>(q + i * stride, S.data(), z.data(), dh, phi.data(),
+                                                     &context_(0, row0 + i, head * dh));
+        };
+        if (causal_) {
+            // Row i reads the prefix sums over keys [0, i]
+            for (size_t i = 0; i < len; ++i) {
+                addKey<P>(k + i * stride, v + i * stride, dh, S.data(), z.data(), phi.data());
+                emit(i);
+            }
+        } else {
+            for (size_t j = 0; j < len; ++j) {
+                addKey<P>(k + j * stride, v + j * stride, dh, S.data(), z.data(), phi.data());
+            }
+            for (size_t i = 0; i < len; ++i) emit(i);
+        }
+    });
+}
+
+void LinearAttentionLayer::backwardHead(size_t unit, const Tensor& dContext, Tensor& dQKV) const {
+    const size_t head = unit % num_heads_;
+    const size_t row0 = (unit / num_heads_) * seqLen_;
+    const size_t len = lengths_[unit / num_heads_];
+    const size_t stride = 3 * d_k_;
+    const size_t dh = d_head_;
+    const double* q = QKV_.rawData() + row0 * stride + head * dh;
+    const double* k = q + d_k_;
+    const double* v = q + 2 * d_k_;
+    double* dq = dQKV.rawData() + row0 * stride + head * dh;
+    double* dk = dq + d_k_;
+    double* dv = dq + 2 * d_k_;
+
+    std::vector<double> S(dh * dh, 0.0), z(dh, 0.0), dS(dh * dh, 0.0), dz(dh, 0.0);
+    std::vector<double> phi(dh), dn(dh);
+
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+
+        // Gradient through query row i, reading S / z; accumulates dS / dz
+        auto queryGrad = [&](size_t i) {
+            const double* qi = q + i * stride;
+            const double* dOi = &dContext(0, row0 + i, head * dh);
+            const double* oi = &context_(0, row0 + i, head * dh);
+            const double invDen = 1.0 / denom_(head, row0 + i, 0);
+            const double dDen = -dot(dOi, oi, dh) * invDen;
+            for (size_t d = 0; d < dh; ++d) dn[d] = dOi[d] * invDen;
+
+            double* dqi = dq + i * stride;
+            for (size_t a = 0; a < dh; ++a) {
+                const double phiQ = featureMap<P>(qi[a]);
+                dqi[a] += (dot(S.data() + a * dh, dn.data(), dh) + z[a] * dDen) * featureMapGrad<P>(qi[a]);
+                axpy(phiQ, dn.data(), dS.data() + a * dh, dh);
+                dz[a] += phiQ * dDen;
+            }
+        };
+
+        // Gradient through key/value row j, reading dS / dz
+        auto keyGrad = [&](size_t j) {
+            const double* kj = k + j * stride;
+            const double* vj = v + j * stride;
+            double* dkj = dk + j * stride;
+            double* dvj = dv + j * stride;
+            for (size_t a = 0; a < dh; ++a) {
+                const double* dSa = dS.data() + a * dh;
+                dkj[a] += (dot(dSa, vj, dh) + dz[a]) * featureMapGrad<P>(kj[a]);
+                axpy(featureMap<P>(kj[a]), dSa, dvj, dh);
+            }
+        };
+
+        // Recompute the full sums S / z
+        for (size_t j = 0; j < len; ++j) {
+            addKey<P>(k + j * stride, v + j * stride, dh, S.data(), z.data(), phi.data());
+        }
+
+        if (causal_) {
+            // Reverse order: S / z shrink to the prefix of row i, dS / dz grow to the suffix
+            for (size_t i = len; i-- > 0;) {
+                queryGrad(i);
+                keyGrad(i);
+                const double* ki = k + i * stride;
+                const double* vi = v + i * stride;
+                for (size_t a = 0; a < dh; ++a) {
+                    const double phiK = featureMap<P>(ki[a]);
+                    z[a] -= phiK;
+                    axpy(-phiK, vi, S.data() + a * dh, dh);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < len; ++i) queryGrad(i);
+            for (size_t j = 0; j < len; ++j) keyGrad(j);
+        }
+    });
+}
+
+const Tensor& LinearAttentionLayer::getWeights() const {
+    if (weightsStale_) {
+        // First sequence of the batch; padded and masked entries stay 0
+        const size_t L = lengths_.empty() ? 0 : lengths_[0];
+        const size_t stride = 3 * d_k_;
+        const size_t dh = d_head_;
+        attentionWeights_.resize(num_heads_, seqLen_, seqLen_);
+        std::vector<double> phiQ(dh), phiK(L * dh);
+
+        visitPrecision(precision_, [&](auto p) {
+            constexpr MathPrecision P = decltype(p)::value;
+            for (size_t head = 0; head < num_heads_; ++head) {
+                const double* q = QKV_.rawData() + head * dh;
+                const double* k = q + d_k_;
+                for (size_t j = 0; j < L; ++j) {
+                    for (size_t a = 0; a < dh; ++a) phiK[j * dh + a] = featureMap<P>(k[j * stride + a]);
+                }
+                for (size_t i = 0; i < L; ++i) {
+                    for (size_t a = 0; a < dh; ++a) phiQ[a] = featureMap<P>(q[i * stride + a]);
+                    const double invDen = 1.0 / denom_(head, i, 0);
+                    const size_t n = causal_ ? i + 1 : L;
+                    for (size_t j = 0; j < n; ++j) {
+                        attentionWeights_(head, i, j) = dot(phiQ.data(), &phiK[j * dh], dh) * invDen;
+                    }
+                }
+            }
+        });
+        weightsStale_ = false;
+    }
+    return attentionWeights_;
+}
+
+Tensor LinearAttentionLayer::forward(const Tensor& input, const std::vector<size_t>& lengths) {
+    setBatchShape(input, lengths);
+
+    // Cache (B * Seq) rows of D_model; the batch is folded into the row dimension
+    input_ = Tensor(input).asRows();
+    const size_t rows = input_.height();
+
+    // Packed projection: (1, BL, D) * (1, D, 3K) -> (1, BL, 3K) = [Q | K | V]
+    QKV_ = input_.matmul(W_QKV_);
+
+    // Each unit writes its own context block and normalizers
+    context_.resize(1, rows, d_k_);
+    denom_.resize(num_heads_, rows, 1);
+    forEachSequenceHead(rows * d_k_ * d_head_, [&](size_t unit) { forwardHead(unit); });
+    weightsStale_ = true;
+
+    // Context (1, BL, K) * W_O (1, K, D) -> (1, BL, D) -> (B, L, D)
+    return context_.matmul(W_O_).reshape(batch_, seqLen_, d_model_);
+}
+
+Tensor LinearAttentionLayer::backward(const Tensor& gradOutput, double learningRate) {
+    const TensorView dOutput = gradOutput.asRows();
+
+    // Output = Context * W_O
+    Tensor dW_O = matmul(TensorView(context_).transposed(), dOutput);
+    Tensor dContext = matmul(dOutput, TensorView(W_O_).transposed());
+
+    // Gradient of the packed Q, K, V
+    Tensor dQKV(1, QKV_.height(), 3 * d_k_);
+    forEachSequenceHead(QKV_.height() * d_k_ * d_head_,
+                        [&](size_t unit) { backwardHead(unit, dContext, dQKV); });
+
+    // QKV = Input * W_QKV -> dW_QKV = Input^T * dQKV, dInput = dQKV * W_QKV^T
+    Tensor dW_QKV = matmul(TensorView(input_).transposed(), dQKV);
+    Tensor dInput = matmul(dQKV, TensorView(W_QKV_).transposed());
+
+    W_QKV_ -= dW_QKV * learningRate;
+    W_O_ -= dW_O * learningRate;
+
+    return dInput.reshape(batch_, seqLen_, d_model_);
+}
+
+Tensor LinearAttentionLayer::forwardIncremental(const Tensor& newRows) {
+    const size_t T = newRows.height();
+    const size_t dh = d_head_;
+
+    // Project only the new rows: (1, T, D) * (1, D, 3K) -> (1, T, 3K)
+    Tensor qkv = newRows.matmul(W_QKV_);
+
+    // Fold each new key into the running state, then read it with the row's query
+    Tensor context(1, T, d_k_);
+    std::vector<double> phi(dh);
+    visitPrecision(precision_, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        for (size_t t = 0; t < T; ++t) {
+            for (size_t head = 0; head < num_heads_; ++head) {
+                double* S = &kvState_(head, 0, 0);
+                double* z = &keySum_(head, 0, 0);
+                addKey<P>(&qkv(0, t, d_k_ + head * dh), &qkv(0, t, 2 * d_k_ + head * dh), dh, S, z, phi.data());
+                readQuery<P>(&qkv(0, t, head * dh), S, z, dh, phi.data(), &context(0, t, head * dh));
+            }
+        }
+    });
+    streamLen_ += T;
+
+    return context.matmul(W_O_);
+}
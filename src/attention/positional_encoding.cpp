@@ -0,0 +1,52 @@
+#include "attention/positional_encoding.h"
+#include <algorithm>
+#include <cmath>
+
+std::mutex PositionalEncodingCache::mutex_;
+std::map<size_t, std::vector<Tensor>> PositionalEncodingCache::tables_;
+
+// Smallest table ever built, so short sequences do not trigger a chain of tiny regrowths
+static constexpr size_t kMinTableLength = 64;
+
+// w_m for column i (pair m = i / 2)
+static double columnFrequency(size_t d_model, size_t i) {
+    return std::pow(10000.0, -static_cast<double>(i - i % 2) / d_model);
+}
+
+TensorView PositionalEncodingCache::sinusoidal(size_t d_model, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Tensor>& generations = tables_[d_model];
+
+    const size_t current = generations.empty() ? 0 : generations.back().height();
+    if (current < length) {
+        const size_t grownLength = std::max({length, 2 * current, kMinTableLength});
+        Tensor table(1, grownLength, d_model);
+
+        // Existing rows are copied; only the new positions need sin/cos
+        if (current > 0) {
+            std::copy_n(generations.back().rawData(), current * d_model, table.rawData());
+        }
+
+        std::vector<double> frequency(d_model);
+        for (size_t i = 0; i < d_model; ++i) {
+            frequency[i] = columnFrequency(d_model, i);
+        }
+        for (size_t pos = current; pos < grownLength; ++pos) {
+            double* row = &table(0, pos, 0);
+            for (size_t i = 0; i < d_model; ++i) {
+                const double angle = pos * frequency[i];
+                row[i] = (i % 2 == 0) ? std::sin(angle) : std::cos(angle);
+            }
+        }
+        generations.push_back(std::move(table));
+    }
+
+    return TensorView(generations.back().rawData(), 1, length, d_model);
+}
+
+void PositionalEncodingCache::sinusoidalRow(size_t d_model, size_t pos, double* out) {
+    for (size_t i = 0; i < d_model; ++i) {
+        const double angle = pos * columnFrequency(d_model, i);
+        out[i] = (i % 2 == 0) ? std::sin(angle) : std::cos(angle);
+    }
+}
@@ -0,0 +1,94 @@
+#include "attention/streaming_engine.h"
+#include <algorithm>
+#include <stdexcept>
+
+StreamingEngine::StreamingEngine(AttentionNetwork& network, size_t contextWindow, size_t chunkSize)
+    : network_(network), contextWindow_(contextWindow), chunkSize_(chunkSize) {
+
+    if (contextWindow == 0 || chunkSize == 0) {
+        throw std::invalid_argument("StreamingEngine needs a positive context window and chunk size");
+    }
+    pending_.reserve(chunkSize);
+    arrivals_.reserve(chunkSize);
+    recentLatency_.reserve(kLatencyWindow);
+    reset();
+}
+
+void StreamingEngine::reset() {
+    pending_.clear();
+    arrivals_.clear();
+    network_.setContextWindow(contextWindow_);
+
+    tokens_ = 0;
+    chunks_ = 0;
+    totalLatency_ = 0.0;
+    maxLatency_ = 0.0;
+    totalCompute_ = 0.0;
+    recentLatency_.clear();
+    recentNext_ = 0;
+}
+
+std::vector<double> StreamingEngine::push(double value) {
+    pending_.push_back(value);
+    arrivals_.push_back(Clock::now());
+    if (pending_.size() < chunkSize_) return {};
+    return runChunk();
+}
+
+std::vector<double> StreamingEngine::flush() {
+    if (pending_.empty()) return {};
+    return runChunk();
+}
+
+std::vector<double> StreamingEngine::runChunk() {
+    const size_t T = pending_.size();
+    Tensor tokens(1, T, 1);
+    std::copy(pending_.begin(), pending_.end(), tokens.rawData());
+
+    const Clock::time_point start = Clock::now();
+    Tensor out = network_.forwardIncremental(tokens);
+    const Clock::time_point done = Clock::now();
+
+    std::vector<double> outputs(out.rawData(), out.rawData() + T);
+
+    // Statistics: per-token latency from arrival, network time shared across the chunk
+    totalCompute_ += std::chrono::duration<double, std::micro>(done - start).count();
+    for (size_t t = 0; t < T; ++t) {
+        const double latency = std::chrono::duration<double, std::micro>(done - arrivals_[t]).count();
+        totalLatency_ += latency;
+        maxLatency_ = std::max(maxLatency_, latency);
+        if (recentLatency_.size() < kLatencyWindow) {
+            recentLatency_.push_back(latency);
+        } else {
+            recentLatency_[recentNext_] = latency;
+        }
+        recentNext_ = (recentNext_ + 1) % kLatencyWindow;
+    }
+    tokens_ += T;
+    ++chunks_;
+
+    pending_.clear();
+    arrivals_.clear();
+    return outputs;
+}
+
+StreamingLatencyStats StreamingEngine::latencyStats() const {
+    StreamingLatencyStats stats;
+    stats.tokens = tokens_;
+    stats.chunks = chunks_;
+    if (tokens_ == 0) return stats;
+
+    stats.meanMicros = totalLatency_ / tokens_;
+    stats.maxMicros = maxLatency_;
+    stats.computeMicrosPerToken = totalCompute_ / tokens_;
+
+    std::vector<double> sorted = recentLatency_;
+    auto percentile = [&sorted](double q) {
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    };
+    stats.p50Micros = percentile(0.50);
+    stats.p99Micros = percentile(0.99);
+    return stats;
+}
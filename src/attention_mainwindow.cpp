@@ -4,6 +4,18 @@
 #include <QGroupBox>
 #include <QSplitter>
 #include <QDateTime>
+#include <QMessageBox>
+#include <algorithm>
+
+// Attention pattern for each entry of the pattern combo box
+static AttentionPattern patternForIndex(int index) {
+    switch (index) {
+        case 1: return AttentionPattern::slidingWindow(2);
+        case 2: return AttentionPattern::dilated(2, 2);
+        case 3: return AttentionPattern::windowWithGlobal(2, 1);
+        default: return AttentionPattern::dense();
+    }
+}
 
 AttentionMainWindow::AttentionMainWindow(QWidget* parent)
     : QMainWindow(parent),
@@ -67,6 +79,40 @@ void AttentionMainWindow::setupUI() {
     layerLayout->addWidget(layersSpinBox_);
     paramLayout->addLayout(layerLayout);
 
+    // Heads (createNetwork snaps D_model to a multiple of 4, so every choice divides it)
+    QHBoxLayout* headLayout = new QHBoxLayout();
+    headLayout->addWidget(new QLabel("Heads:"));
+    headsComboBox_ = new QComboBox();
+    headsComboBox_->addItems({"1", "2", "4"});
+    headLayout->addWidget(headsComboBox_);
+    paramLayout->addLayout(headLayout);
+
+    // Positional encoding (index matches PositionalEncodingType)
+    QHBoxLayout* posLayout = new QHBoxLayout();
+    posLayout->addWidget(new QLabel("Pos Enc:"));
+    posEncodingComboBox_ = new QComboBox();
+    posEncodingComboBox_->addItems({"Sinusoidal", "Learned", "RoPE"});
+    posLayout->addWidget(posEncodingComboBox_);
+    paramLayout->addLayout(posLayout);
+
+    // Attention variant (index matches AttentionType)
+    QHBoxLayout* attnTypeLayout = new QHBoxLayout();
+    attnTypeLayout->addWidget(new QLabel("Attention:"));
+    attentionTypeComboBox_ = new QComboBox();
+    attentionTypeComboBox_->addItems({"Softmax", "Linear"});
+    attnTypeLayout->addWidget(attentionTypeComboBox_);
+    paramLayout->addLayout(attnTypeLayout);
+
+    // Sparse attention pattern; weights are unaffected, so it applies immediately
+    QHBoxLayout* patternLayout = new QHBoxLayout();
+    patternLayout->addWidget(new QLabel("Pattern:"));
+    patternComboBox_ = new QComboBox();
+    patternComboBox_->addItems({"Dense", "Sliding Window", "Dilated", "Window + Global"});
+    connect(patternComboBox_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &AttentionMainWindow::onPatternChanged);
+    patternLayout->addWidget(patternComboBox_);
+    paramLayout->addLayout(patternLayout);
+
     controlLayout->addWidget(paramGroup);
 
     // Training Params
@@ -156,7 +202,7 @@ void AttentionMainWindow::setupUI() {
         QLabel { color: #ddd; }
         QGroupBox { color: white; font-weight: bold; border: 1px solid #444; margin-top: 10px; padding-top: 10px; }
         QGroupBox::title { subcontrol-origin: margin; left: 10px; padding: 0 5px; }
-        QSpinBox, QDoubleSpinBox { background-color: #3d3d4d; color: white; padding: 5px; }
+        QSpinBox, QDoubleSpinBox, QComboBox { background-color: #3d3d4d; color: white; padding: 5px; }
         QPushButton { background-color: #3d3d5d; color: white; border: none; padding: 8px; border-radius: 4px; }
         QPushButton:hover { background-color: #4d4d6d; }
         QPushButton:disabled { background-color: #2d2d3d; color: #666; }
@@ -164,17 +210,58 @@ void AttentionMainWindow::setupUI() {
     )");
 }
 
-void AttentionMainWindow::createNetwork() {
+bool AttentionMainWindow::createNetwork() {
     int seqLen = seqLenSpinBox_->value();
-    int d_model = dModelSpinBox_->value();
     int layers = layersSpinBox_->value();
+    int heads = headsComboBox_->currentText().toInt();
+    auto posEncoding = static_cast<PositionalEncodingType>(posEncodingComboBox_->currentIndex());
+    auto attentionType = static_cast<AttentionType>(attentionTypeComboBox_->currentIndex());
+    if (attentionType == AttentionType::Linear && posEncoding == PositionalEncodingType::Rotary) {
+        log("RoPE is not supported by linear attention; using Sinusoidal");
+        posEncodingComboBox_->setCurrentIndex(static_cast<int>(PositionalEncodingType::Sinusoidal));
+        posEncoding = PositionalEncodingType::Sinusoidal;
+    }
+    // The spin box steps by 4, but a typed value can be anything in range.
+    // RoPE rotates channel pairs, so with it every head also needs an even width
+    const int unit = posEncoding == PositionalEncodingType::Rotary ? std::max(4, 2 * heads) : 4;
+    const int d_model = std::max(unit, dModelSpinBox_->value() / unit * unit);
+    if (d_model != dModelSpinBox_->value()) {
+        log(QString("D_model must be a multiple of %1; using %2").arg(unit).arg(d_model));
+        dModelSpinBox_->setValue(d_model);
+    }
     int d_k = d_model; // Use same for simplicity
     int d_ff = d_model * 2; // Simple multiplier
 
-    network_ = std::make_unique<AttentionNetwork>(seqLen, d_model, d_k, d_ff, layers);
+    try {
+        network_ = std::make_unique<AttentionNetwork>(seqLen, d_model, d_k, d_ff, layers, heads, posEncoding,
+                                                      attentionType);
+    } catch (const std::exception& e) {
+        log(QString("Failed to create network: %1").arg(e.what()));
+        QMessageBox::warning(this, "Network", QString("Cannot create the network:\n%1").arg(e.what()));
+        return false;
+    }
+    if (attentionType == AttentionType::Softmax) {
+        network_->setAttentionPattern(patternForIndex(patternComboBox_->currentIndex()));
+        network_->publishSnapshot();
+    }
     attentionView_->setNetwork(network_.get());
 
-    log(QString("Network created: Seq=%1, D=%2, Layers=%3").arg(seqLen).arg(d_model).arg(layers));
+    log(QString("Network created: Seq=%1, D=%2, Layers=%3, Heads=%4, PosEnc=%5, Attention=%6")
+        .arg(seqLen).arg(d_model).arg(layers).arg(heads).arg(posEncodingComboBox_->currentText())
+        .arg(attentionTypeComboBox_->currentText()));
+    return true;
+}
+
+void AttentionMainWindow::onPatternChanged(int index) {
+    if (!network_) return;
+    if (network_->getAttentionType() == AttentionType::Linear) {
+        log("Sparse patterns apply to softmax attention only");
+        return;
+    }
+    network_->setAttentionPattern(patternForIndex(index));
+    network_->publishSnapshot();
+    attentionView_->updateView();
+    log("Attention pattern: " + patternComboBox_->currentText());
 }
 
 void AttentionMainWindow::onStartTraining() {
@@ -187,6 +274,9 @@ void AttentionMainWindow::onStartTraining() {
         bool paramsChanged = false;
         if (network_->getDModel() != (size_t)currentDModel) paramsChanged = true;
         if (network_->getNumLayers() != (size_t)currentLayers) paramsChanged = true;
+        if (network_->getNumHeads() != (size_t)headsComboBox_->currentText().toInt()) paramsChanged = true;
+        if (static_cast<int>(network_->getPositionalEncoding()) != posEncodingComboBox_->currentIndex()) paramsChanged = true;
+        if (static_cast<int>(network_->getAttentionType()) != attentionTypeComboBox_->currentIndex()) paramsChanged = true;
         // SeqLen is now dynamic, but if it changed significantly we might want to reset?
         // Actually, if seqLen changed, we definitely want the training thread to use the new one.
         // The network handles dynamic seqLen, but we might want to update the network's concept of it.
@@ -197,21 +287,22 @@ void AttentionMainWindow::onStartTraining() {
 
         if (paramsChanged) {
             log("Configuration changed. Recreating network...");
-            createNetwork();
+            if (!createNetwork()) return;
         }
-    } else {
-        createNetwork();
+    } else if (!createNetwork()) {
+        return;
     }
 
     lossChart_->clear();
     progressBar_->setValue(0);
     totalEpochs_ = epochsSpinBox_->value();
+    currentEpoch_ = 0;
 
     trainingThread_ = std::make_unique<AttentionTrainingThread>();
     trainingThread_->setNetwork(network_.get());
     trainingThread_->setParameters(totalEpochs_, learningRateSpinBox_->value(), seqLenSpinBox_->value());
 
-    connect(trainingThread_.get(), &AttentionTrainingThread::epochCompleted, this, &AttentionMainWindow::onEpochCompleted);
+    connect(trainingThread_.get(), &AttentionTrainingThread::progressUpdated, this, &AttentionMainWindow::onProgressUpdated);
     connect(trainingThread_.get(), &AttentionTrainingThread::trainingCompleted, this, &AttentionMainWindow::onTrainingCompleted);
     connect(trainingThread_.get(), &AttentionTrainingThread::weightsUpdated, this, &AttentionMainWindow::onWeightsUpdated);
 
@@ -244,16 +335,22 @@ void AttentionMainWindow::onPauseResumeTraining() {
 
 void AttentionMainWindow::onResetNetwork() {
     onStopTraining();
-    createNetwork();
+    if (!createNetwork()) return;
     lossChart_->clear();
     progressBar_->setValue(0);
     updateStatus("Network Reset");
 }
 
-void AttentionMainWindow::onEpochCompleted(int epoch, double loss) {
-    lossChart_->addDataPoint(epoch, loss);
+void AttentionMainWindow::onProgressUpdated(const std::vector<LossPoint>& points) {
+    if (points.empty()) return;
+    const int previousEpoch = currentEpoch_;
+    const int epoch = points.back().epoch;
+    const double loss = points.back().loss;
+    currentEpoch_ = epoch;
+    lossChart_->addDataPoints(points);
     progressBar_->setValue((epoch * 100) / totalEpochs_);
-    if (epoch % 100 == 0) log(QString("Epoch %1: Loss %2").arg(epoch).arg(loss));
+    // A batch may span several epochs: log the newest once it crosses a multiple of 100
+    if (epoch / 100 != previousEpoch / 100) log(QString("Epoch %1: Loss %2").arg(epoch).arg(loss));
 }
 
 void AttentionMainWindow::onTrainingCompleted() {
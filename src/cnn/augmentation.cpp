@@ -0,0 +1,341 @@
+#include "cnn/augmentation.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// 每个线程的中间缓冲：变换在 output 与 scratch 之间交替
+thread_local Tensor scratch;
+thread_local std::vector<size_t> rowIndex;
+thread_local std::vector<double> rowWeight;
+thread_local std::vector<size_t> columnIndex;
+thread_local std::vector<double> columnWeight;
+
+void copyInto(const TensorView& input, Tensor& output) {
+    if (input.isContiguous() && output.size() == input.size() && output.rawData() == &input(0, 0, 0)) {
+        return; // 原地增强
+    }
+    output.resize(input.channels(), input.height(), input.width());
+    double* dst = output.rawData();
+    if (input.isContiguous()) {
+        const double* src = &input(0, 0, 0);
+        std::copy(src, src + input.size(), dst);
+        return;
+    }
+    for (size_t c = 0; c < input.channels(); ++c)
+        for (size_t h = 0; h < input.height(); ++h)
+            for (size_t w = 0; w < input.width(); ++w)
+                *dst++ = input(c, h, w);
+}
+
+void flipRows(Tensor& image) {
+    const size_t width = image.width();
+    const size_t rows = image.channels() * image.height();
+    double* data = image.rawData();
+    for (size_t r = 0; r < rows; ++r) {
+        std::reverse(data + r * width, data + (r + 1) * width);
+    }
+}
+
+void flipColumns(Tensor& image) {
+    const size_t width = image.width();
+    const size_t height = image.height();
+    for (size_t c = 0; c < image.channels(); ++c) {
+        double* plane = image.rawData() + c * height * width;
+        for (size_t top = 0, bottom = height - 1; top < bottom; ++top, --bottom) {
+            std::swap_ranges(plane + top * width, plane + (top + 1) * width, plane + bottom * width);
+        }
+    }
+}
+
+// 逆时针旋转 quarterTurns 个 90 度，写入 dst
+void rotate(const Tensor& src, Tensor& dst, int quarterTurns) {
+    const size_t n = src.height();
+    dst.resize(src.channels(), n, n);
+    for (size_t c = 0; c < src.channels(); ++c) {
+        const double* in = src.rawData() + c * n * n;
+        double* out = dst.rawData() + c * n * n;
+        for (size_t y = 0; y < n; ++y) {
+            double* row = out + y * n;
+            for (size_t x = 0; x < n; ++x) {
+                switch (quarterTurns) {
+                    case 1: row[x] = in[x * n + (n - 1 - y)]; break;
+                    case 2: row[x] = in[(n - 1 - y) * n + (n - 1 - x)]; break;
+                    default: row[x] = in[(n - 1 - x) * n + y]; break;
+                }
+            }
+        }
+    }
+}
+
+// dst(h, w) = src(h - dy, w - dx)，越界处为 0
+void translate(const Tensor& src, Tensor& dst, long dy, long dx) {
+    const long height = static_cast<long>(src.height());
+    const long width = static_cast<long>(src.width());
+    dst.resize(src.channels(), src.height(), src.width()); // 已清零
+    const long first = std::max(0L, dx);
+    const long last = std::min(width, width + dx);
+    if (first >= last) return;
+    for (size_t c = 0; c < src.channels(); ++c) {
+        const double* in = src.rawData() + c * src.height() * src.width();
+        double* out = dst.rawData() + c * src.height() * src.width();
+        for (long h = std::max(0L, dy); h < std::min(height, height + dy); ++h) {
+            const double* from = in + (h - dy) * width + (first - dx);
+            std::copy(from, from + (last - first), out + h * width + first);
+        }
+    }
+}
+
+// 双线性采样的源坐标：out 个输出位置映射到长度为 size、从 origin 开始的区间
+void samplingGrid(size_t out, size_t origin, size_t size, std::vector<size_t>& index,
+                  std::vector<double>& weight) {
+    index.resize(out);
+    weight.resize(out);
+    const double scale = static_cast<double>(size) / static_cast<double>(out);
+    for (size_t i = 0; i < out; ++i) {
+        double pos = (static_cast<double>(i) + 0.5) * scale - 0.5;
+        pos = std::min(std::max(pos, 0.0), static_cast<double>(size - 1));
+        const size_t lower = std::min(static_cast<size_t>(pos), size - 1);
+        index[i] = origin + lower;
+        weight[i] = pos - static_cast<double>(lower);
+    }
+}
+
+// 裁剪 src 中 (y0, x0) 起 cropH × cropW 的区域，双线性缩放回原尺寸写入 dst
+void cropResize(const Tensor& src, Tensor& dst, size_t y0, size_t x0, size_t cropH, size_t cropW) {
+    const size_t height = src.height();
+    const size_t width = src.width();
+    dst.resize(src.channels(), height, width);
+
+    samplingGrid(width, x0, cropW, columnIndex, columnWeight);
+    samplingGrid(height, y0, cropH, rowIndex, rowWeight);
+    const size_t lastRow = y0 + cropH - 1;
+    const size_t lastCol = x0 + cropW - 1;
+
+    for (size_t c = 0; c < src.channels(); ++c) {
+        const double* in = src.rawData() + c * height * width;
+        double* out = dst.rawData() + c * height * width;
+        for (size_t y = 0; y < height; ++y) {
+            const double* top = in + rowIndex[y] * width;
+            const double* bottom = in + std::min(rowIndex[y] + 1, lastRow) * width;
+            const double fy = rowWeight[y];
+            double* row = out + y * width;
+            for (size_t x = 0; x < width; ++x) {
+                const size_t left = columnIndex[x];
+                const size_t right = std::min(left + 1, lastCol);
+                const double fx = columnWeight[x];
+                const double upper = top[left] + (top[right] - top[left]) * fx;
+                const double lower = bottom[left] + (bottom[right] - bottom[left]) * fx;
+                row[x] = upper + (lower - upper) * fy;
+            }
+        }
+    }
+}
+
+double parseValue(const std::string& name, const std::string& text) {
+    size_t used = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size()) {
+        throw std::invalid_argument("Augmentation '" + name + "' has an invalid value: " + text);
+    }
+    return value;
+}
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) return std::string();
+    const size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+ImageAugmenter& ImageAugmenter::flipHorizontal(double probability) {
+    if (probability < 0.0 || probability > 1.0) {
+        throw std::invalid_argument("Flip probability must be in [0, 1]");
+    }
+    return add(Kind::FlipHorizontal, probability);
+}
+
+ImageAugmenter& ImageAugmenter::flipVertical(double probability) {
+    if (probability < 0.0 || probability > 1.0) {
+        throw std::invalid_argument("Flip probability must be in [0, 1]");
+    }
+    return add(Kind::FlipVertical, probability);
+}
+
+ImageAugmenter& ImageAugmenter::rotate90() {
+    return add(Kind::Rotate90, 0.0);
+}
+
+ImageAugmenter& ImageAugmenter::shift(size_t maxShift) {
+    if (maxShift == 0) {
+        throw std::invalid_argument("Shift must be at least 1 pixel");
+    }
+    return add(Kind::Shift, static_cast<double>(maxShift));
+}
+
+ImageAugmenter& ImageAugmenter::crop(double minScale) {
+    if (!(minScale > 0.0 && minScale <= 1.0)) {
+        throw std::invalid_argument("Crop scale must be in (0, 1]");
+    }
+    return add(Kind::Crop, minScale);
+}
+
+ImageAugmenter& ImageAugmenter::noise(double stddev) {
+    if (!(stddev >= 0.0)) {
+        throw std::invalid_argument("Noise standard deviation must be non-negative");
+    }
+    return add(Kind::Noise, stddev);
+}
+
+ImageAugmenter& ImageAugmenter::add(Kind kind, double value) {
+    steps_.push_back({kind, value});
+    return *this;
+}
+
+ImageAugmenter ImageAugmenter::fromSpec(const std::string& spec) {
+    ImageAugmenter augmenter;
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        item = trim(item);
+        if (item.empty() || item == "none") continue;
+
+        const size_t eq = item.find('=');
+        const std::string name = trim(item.substr(0, eq));
+        const bool hasValue = eq != std::string::npos;
+        const std::string valueText = hasValue ? trim(item.substr(eq + 1)) : std::string();
+
+        if (name == "flip_h") {
+            augmenter.flipHorizontal(hasValue ? parseValue(name, valueText) : 0.5);
+        } else if (name == "flip_v") {
+            augmenter.flipVertical(hasValue ? parseValue(name, valueText) : 0.5);
+        } else if (name == "rot90") {
+            if (hasValue) throw std::invalid_argument("Augmentation 'rot90' takes no value");
+            augmenter.rotate90();
+        } else if (name == "shift") {
+            const double pixels = hasValue ? parseValue(name, valueText) : 2.0;
+            if (pixels < 1.0 || pixels != std::floor(pixels)) {
+                throw std::invalid_argument("Augmentation 'shift' needs a whole number of pixels");
+            }
+            augmenter.shift(static_cast<size_t>(pixels));
+        } else if (name == "crop") {
+            augmenter.crop(hasValue ? parseValue(name, valueText) : 0.8);
+        } else if (name == "noise") {
+            augmenter.noise(hasValue ? parseValue(name, valueText) : 0.05);
+        } else {
+            throw std::invalid_argument("Unknown augmentation: " + name +
+                                        " (expected flip_h, flip_v, rot90, shift, crop or noise)");
+        }
+    }
+    return augmenter;
+}
+
+std::string ImageAugmenter::spec() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < steps_.size(); ++i) {
+        if (i > 0) out << ',';
+        const Step& step = steps_[i];
+        switch (step.kind) {
+            case Kind::FlipHorizontal: out << "flip_h=" << step.value; break;
+            case Kind::FlipVertical: out << "flip_v=" << step.value; break;
+            case Kind::Rotate90: out << "rot90"; break;
+            case Kind::Shift: out << "shift=" << step.value; break;
+            case Kind::Crop: out << "crop=" << step.value; break;
+            case Kind::Noise: out << "noise=" << step.value; break;
+        }
+    }
+    return steps_.empty() ? "none" : out.str();
+}
+
+void ImageAugmenter::apply(const TensorView& input, Tensor& output, PhiloxRng& gen) const {
+    if (input.empty()) {
+        throw std::invalid_argument("Cannot augment an empty tensor");
+    }
+    copyInto(input, output);
+
+    for (const Step& step : steps_) {
+        switch (step.kind) {
+            case Kind::FlipHorizontal:
+                if (gen.uniform() < step.value) flipRows(output);
+                break;
+            case Kind::FlipVertical:
+                if (gen.uniform() < step.value) flipColumns(output);
+                break;
+            case Kind::Rotate90: {
+                if (output.height() != output.width()) {
+                    throw std::invalid_argument("rot90 augmentation needs square images");
+                }
+                const int turns = static_cast<int>(gen.uniformIndex(4));
+                if (turns == 0) break;
+                rotate(output, scratch, turns);
+                std::swap(output, scratch);
+                break;
+            }
+            case Kind::Shift: {
+                const long maxShift = static_cast<long>(step.value);
+                const uint64_t span = static_cast<uint64_t>(2 * maxShift + 1);
+                const long dy = static_cast<long>(gen.uniformIndex(span)) - maxShift;
+                const long dx = static_cast<long>(gen.uniformIndex(span)) - maxShift;
+                if (dy == 0 && dx == 0) break;
+                translate(output, scratch, dy, dx);
+                std::swap(output, scratch);
+                break;
+            }
+            case Kind::Crop: {
+                const double scale = step.value + (1.0 - step.value) * gen.uniform();
+                const size_t height = output.height();
+                const size_t width = output.width();
+                const size_t cropH = std::max<size_t>(1, static_cast<size_t>(std::lround(scale * height)));
+                const size_t cropW = std::max<size_t>(1, static_cast<size_t>(std::lround(scale * width)));
+                const size_t y0 = static_cast<size_t>(gen.uniformIndex(height - std::min(cropH, height) + 1));
+                const size_t x0 = static_cast<size_t>(gen.uniformIndex(width - std::min(cropW, width) + 1));
+                if (cropH >= height && cropW >= width) break;
+                cropResize(output, scratch, y0, x0, std::min(cropH, height), std::min(cropW, width));
+                std::swap(output, scratch);
+                break;
+            }
+            case Kind::Noise: {
+                if (step.value == 0.0) break;
+                double* data = output.rawData();
+                const size_t n = output.size();
+                for (size_t i = 0; i < n; ++i) {
+                    data[i] += gen.normal(0.0, step.value);
+                }
+                break;
+            }
+        }
+    }
+}
+
+Tensor ImageAugmenter::apply(const TensorView& input, PhiloxRng& gen) const {
+    Tensor output;
+    apply(input, output, gen);
+    return output;
+}
+
+std::unique_ptr<DataPipeline<Tensor>> makeAugmentationPipeline(
+    const ImageAugmenter& augmenter, AugmentationSource source, size_t datasetSize,
+    size_t numWorkers, size_t prefetchDepth, uint64_t seed, size_t total) {
+    if (datasetSize == 0) {
+        throw std::invalid_argument("Augmentation pipeline needs a non-empty dataset");
+    }
+    if (!source) {
+        throw std::invalid_argument("Augmentation pipeline needs a sample source");
+    }
+    return std::make_unique<DataPipeline<Tensor>>(
+        [augmenter, source = std::move(source), datasetSize](size_t index, PhiloxRng& gen) {
+            Tensor sample;
+            augmenter.apply(source(index % datasetSize), sample, gen);
+            return sample;
+        },
+        numWorkers, prefetchDepth, seed, total);
+}
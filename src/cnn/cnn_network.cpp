@@ -6,10 +6,37 @@
 #include <mutex>
 
 #include <limits>
+#include <numeric>
+
+namespace {
+
+// 网络随机流的划分：卷积层、全连接层的初始权重与样本顺序各用一个子流
+const uint64_t kConvInitStream = 0;
+const uint64_t kDenseInitStream = 1;
+const uint64_t kShuffleStream = 2;
+
+} // namespace
 
 CNNNetwork::CNNNetwork()
     : inputChannels_(0), inputHeight_(0), inputWidth_(0),
-      currentChannels_(0), currentHeight_(0), currentWidth_(0) {}
+      currentChannels_(0), currentHeight_(0), currentWidth_(0),
+      rng_(nextRandomStream()) {}
+
+void CNNNetwork::setSeed(uint64_t seed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rng_ = PhiloxRng(seed);
+    epoch_ = 0;
+}
+
+void CNNNetwork::setShuffle(bool shuffle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shuffle_ = shuffle;
+}
+
+bool CNNNetwork::shuffle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shuffle_;
+}
 
 void CNNNetwork::setInputSize(size_t channels, size_t height, size_t width) {
     inputChannels_ = channels;
@@ -29,8 +56,10 @@ void CNNNetwork::addConvLayer(size_t outputChannels, size_t kernelSize,
 
     auto layer = std::make_shared<ConvolutionalLayer>(
         currentChannels_, currentHeight_, currentWidth_,
-        outputChannels, kernelSize, stride, padding, activation);
+        outputChannels, kernelSize, stride, padding, activation,
+        rng_.stream(kConvInitStream).stream(cnnLayers_.size()));
 
+    layer->setMathPrecision(precision_);
     cnnLayers_.push_back(layer);
 
     currentChannels_ = layer->outputChannels();
@@ -92,13 +121,15 @@ void CNNNetwork::build() {
         throw std::runtime_error("Flattened size exceeds supported dense layer size");
     }
     int prevSize = static_cast<int>(flattenedSize_);
+    const PhiloxRng denseRng = rng_.stream(kDenseInitStream);
 
     for (size_t i = 0; i < denseLayerSizes_.size(); ++i) {
-        denseLayers_.emplace_back(prevSize, denseLayerSizes_[i], denseActivations_[i]);
+        denseLayers_.emplace_back(prevSize, denseLayerSizes_[i], denseActivations_[i], denseRng.stream(i));
         prevSize = denseLayerSizes_[i];
     }
 
     isBuilt_ = true;
+    publishSnapshot();
 }
 
 void CNNNetwork::buildSimpleCNN(size_t inputChannels, size_t inputHeight, size_t inputWidth,
@@ -140,7 +171,8 @@ void CNNNetwork::updateWeights(double learningRate) {
 
 double CNNNetwork::train(const std::vector<Tensor>& inputs,
                           const std::vector<std::vector<double>>& targets,
-                          double learningRate) {
+                          double learningRate,
+                          const TrainingControl* control) {
     if (inputs.empty() || targets.empty()) {
         throw std::invalid_argument("Training data cannot be empty");
     }
@@ -153,15 +185,79 @@ double CNNNetwork::train(const std::vector<Tensor>& inputs,
 
     std::lock_guard<std::mutex> lock(mutex_);
     double totalLoss = 0.0;
+    size_t trained = 0;
+
+    if (shuffle_) {
+        shufflePermutation(order_, inputs.size(), rng_.stream(kShuffleStream).stream(epoch_++));
+    } else {
+        order_.resize(inputs.size());
+        std::iota(order_.begin(), order_.end(), size_t(0));
+    }
+
+    for (size_t i : order_) {
+        if (control && control->stopRequested()) break;
+        totalLoss += trainSampleInternal(inputs[i], targets[i], learningRate);
+        ++trained;
+    }
+
+    return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+}
+
+double CNNNetwork::trainBatch(const std::vector<TensorView>& inputs,
+                              const std::vector<const double*>& targets,
+                              double learningRate,
+                              const TrainingControl* control) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Training data size mismatch");
+    }
+    if (!isBuilt_) {
+        throw std::runtime_error("Network not built");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t outputSize = denseLayers_.empty() ? flattenedSize_ : denseLayers_.back().output.size();
+    batchTarget_.resize(outputSize);
+    double totalLoss = 0.0;
+    size_t trained = 0;
 
     for (size_t i = 0; i < inputs.size(); ++i) {
-        std::vector<double> output = forwardInternal(inputs[i]);
-        totalLoss += calculateLossInternal(output, targets[i]);
-        backwardInternal(targets[i]);
-        updateWeightsInternal(learningRate);
+        if (control && control->stopRequested()) break;
+        const TensorView& view = inputs[i];
+        if (view.channels() != inputChannels_ || view.height() != inputHeight_ ||
+            view.width() != inputWidth_) {
+            throw std::invalid_argument("Input shape mismatch");
+        }
+
+        // 复制到复用的输入缓冲区（形状不变时不重新分配）
+        if (batchInput_.channels() != inputChannels_ || batchInput_.height() != inputHeight_ ||
+            batchInput_.width() != inputWidth_) {
+            batchInput_ = Tensor(inputChannels_, inputHeight_, inputWidth_);
+        }
+        double* dst = batchInput_.rawData();
+        if (view.isContiguous()) {
+            std::copy(&view(0, 0, 0), &view(0, 0, 0) + view.size(), dst);
+        } else {
+            for (size_t c = 0; c < view.channels(); ++c)
+                for (size_t h = 0; h < view.height(); ++h)
+                    for (size_t w = 0; w < view.width(); ++w)
+                        *dst++ = view(c, h, w);
+        }
+        std::copy(targets[i], targets[i] + outputSize, batchTarget_.begin());
+
+        totalLoss += trainSampleInternal(batchInput_, batchTarget_, learningRate);
+        ++trained;
     }
 
-    return totalLoss / static_cast<double>(inputs.size());
+    return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+}
+
+double CNNNetwork::trainSampleInternal(const Tensor& input, const std::vector<double>& target,
+                                       double learningRate) {
+    std::vector<double> output = forwardInternal(input);
+    const double loss = calculateLossInternal(output, target);
+    backwardInternal(target);
+    updateWeightsInternal(learningRate);
+    return loss;
 }
 
 double CNNNetwork::calculateLoss(const std::vector<double>& output,
@@ -170,6 +266,19 @@ double CNNNetwork::calculateLoss(const std::vector<double>& output,
     return calculateLossInternal(output, target);
 }
 
+void CNNNetwork::setMathPrecision(MathPrecision precision) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    precision_ = precision;
+    for (auto& layer : cnnLayers_) {
+        layer->setMathPrecision(precision);
+    }
+}
+
+MathPrecision CNNNetwork::mathPrecision() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return precision_;
+}
+
 size_t CNNNetwork::totalParameters() const {
     std::lock_guard<std::mutex> lock(mutex_);
     size_t total = 0;
@@ -183,6 +292,33 @@ size_t CNNNetwork::totalParameters() const {
     return total;
 }
 
+void CNNNetwork::publishSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<CNNSnapshot> snapshot = snapshots_.acquire();
+
+    snapshot->inputChannels = inputChannels_;
+    snapshot->inputHeight = inputHeight_;
+    snapshot->inputWidth = inputWidth_;
+
+    snapshot->cnnLayers.resize(cnnLayers_.size());
+    for (size_t i = 0; i < cnnLayers_.size(); ++i) {
+        CNNLayerSnapshot& out = snapshot->cnnLayers[i];
+        out.type = cnnLayers_[i]->type();
+        out.name = cnnLayers_[i]->name();
+        out.outputChannels = cnnLayers_[i]->outputChannels();
+        out.outputHeight = cnnLayers_[i]->outputHeight();
+        out.outputWidth = cnnLayers_[i]->outputWidth();
+        out.output = cnnLayers_[i]->getOutput(); // 深拷贝，独占的旧缓冲区原地复用
+    }
+
+    snapshot->denseLayers.resize(denseLayers_.size());
+    for (size_t i = 0; i < denseLayers_.size(); ++i) {
+        snapshot->denseLayers[i].capture(denseLayers_[i]);
+    }
+
+    snapshots_.publish(std::move(snapshot));
+}
+
 std::vector<Tensor> CNNNetwork::getAllFeatureMaps() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<Tensor> featureMaps;
@@ -241,43 +377,41 @@ std::vector<double> CNNNetwork::forwardInternal(const Tensor& input) {
     }
     validateInputShape(input);
 
+    // 各层输出由网络持有并移交给下一层，展平层据此直接复用存储
     Tensor current = input;
     for (auto& layer : cnnLayers_) {
-        current = layer->forward(current);
+        current = layer->forwardOwned(std::move(current));
     }
 
-    flattenedOutput_ = std::move(current.data());
+    if (denseLayers_.empty()) {
+        lastOutput_ = current.flatten();
+        return lastOutput_;
+    }
 
-    const std::vector<double>* denseInputPtr = &flattenedOutput_;
+    // 有全连接层时展平层必为最后一个 CNN 层，其 getOutput() 与 current 共享存储
+    flattenedOutput_ = TensorView(cnnLayers_.back()->getOutput());
 
-    for (auto& layer : denseLayers_) {
-        layer.input = *denseInputPtr;
+    for (size_t l = 0; l < denseLayers_.size(); ++l) {
+        Layer& layer = denseLayers_[l];
+        const double* in = denseInput(l);
 
         for (int j = 0; j < layer.outputSize; ++j) {
             const size_t jIdx = static_cast<size_t>(j);
             double sum = layer.biases[jIdx];
             for (int i = 0; i < layer.inputSize; ++i) {
-                const size_t iIdx = static_cast<size_t>(i);
-                sum += layer.weight(j, i) * (*denseInputPtr)[iIdx];
+                sum += layer.weight(j, i) * in[static_cast<size_t>(i)];
             }
 
-            switch (layer.activation) {
-                case ActivationType::Sigmoid:
-                    layer.output[jIdx] = 1.0 / (1.0 + std::exp(-std::clamp(sum, -500.0, 500.0)));
-                    break;
-                case ActivationType::ReLU:
-                    layer.output[jIdx] = std::max(0.0, sum);
-                    break;
-                case ActivationType::Tanh:
-                    layer.output[jIdx] = std::tanh(sum);
-                    break;
-            }
+            layer.output[jIdx] = sum;
         }
 
-        denseInputPtr = &layer.output;
+        double* out = layer.output.data();
+        visitActivation(layer.activation, precision_, [&](auto kernel) {
+            activationForward<decltype(kernel)>(out, out, layer.output.size());
+        });
     }
 
-    lastOutput_ = denseLayers_.empty() ? flattenedOutput_ : denseLayers_.back().output;
+    lastOutput_ = denseLayers_.back().output;
     return lastOutput_;
 }
 
@@ -289,33 +423,16 @@ void CNNNetwork::backwardInternal(const std::vector<double>& target) {
         throw std::invalid_argument("Target size mismatch");
     }
 
+    // 激活导数直接由前向输出求得，无需重新计算预激活值
     for (int j = 0; j < outputLayer.outputSize; ++j) {
         const size_t jIdx = static_cast<size_t>(j);
-        double error = target[jIdx] - outputLayer.output[jIdx];
-        double sum = outputLayer.biases[jIdx];
-        for (int i = 0; i < outputLayer.inputSize; ++i) {
-            const size_t iIdx = static_cast<size_t>(i);
-            sum += outputLayer.weight(j, i) * outputLayer.input[iIdx];
-        }
-
-        double derivative = 1.0;
-        switch (outputLayer.activation) {
-            case ActivationType::Sigmoid: {
-                double s = 1.0 / (1.0 + std::exp(-std::clamp(sum, -500.0, 500.0)));
-                derivative = s * (1.0 - s);
-                break;
-            }
-            case ActivationType::ReLU:
-                derivative = sum > 0 ? 1.0 : 0.0;
-                break;
-            case ActivationType::Tanh: {
-                double t = std::tanh(sum);
-                derivative = 1.0 - t * t;
-                break;
-            }
-        }
-        outputLayer.delta[jIdx] = error * derivative;
+        outputLayer.delta[jIdx] = target[jIdx] - outputLayer.output[jIdx];
     }
+    visitActivation(outputLayer.activation, precision_, [&](auto kernel) {
+        activationBackwardFromOutput<decltype(kernel)>(
+            outputLayer.output.data(), outputLayer.delta.data(), outputLayer.delta.data(),
+            outputLayer.delta.size());
+    });
 
     for (int l = static_cast<int>(denseLayers_.size()) - 2; l >= 0; --l) {
         const size_t lIdx = static_cast<size_t>(l);
@@ -329,30 +446,13 @@ void CNNNetwork::backwardInternal(const std::vector<double>& target) {
                 const size_t jIdx = static_cast<size_t>(j);
                 error += nextLayer.weight(j, i) * nextLayer.delta[jIdx];
             }
-            double sum = currentLayer.biases[iIdx];
-            for (int k = 0; k < currentLayer.inputSize; ++k) {
-                const size_t kIdx = static_cast<size_t>(k);
-                sum += currentLayer.weight(i, k) * currentLayer.input[kIdx];
-            }
-
-            double derivative = 1.0;
-            switch (currentLayer.activation) {
-                case ActivationType::Sigmoid: {
-                    double s = 1.0 / (1.0 + std::exp(-std::clamp(sum, -500.0, 500.0)));
-                    derivative = s * (1.0 - s);
-                    break;
-                }
-                case ActivationType::ReLU:
-                    derivative = sum > 0 ? 1.0 : 0.0;
-                    break;
-                case ActivationType::Tanh: {
-                    double t = std::tanh(sum);
-                    derivative = 1.0 - t * t;
-                    break;
-                }
-            }
-            currentLayer.delta[iIdx] = error * derivative;
+            currentLayer.delta[iIdx] = error;
         }
+        visitActivation(currentLayer.activation, precision_, [&](auto kernel) {
+            activationBackwardFromOutput<decltype(kernel)>(
+                currentLayer.output.data(), currentLayer.delta.data(), currentLayer.delta.data(),
+                currentLayer.delta.size());
+        });
     }
 
     Layer& firstDense = denseLayers_[0];
@@ -366,20 +466,21 @@ void CNNNetwork::backwardInternal(const std::vector<double>& target) {
         gradFromDense(0, 0, i) = grad;
     }
 
-    Tensor gradCurrent = gradFromDense;
+    Tensor gradCurrent = std::move(gradFromDense);
     for (int i = static_cast<int>(cnnLayers_.size()) - 1; i >= 0; --i) {
-        gradCurrent = cnnLayers_[static_cast<size_t>(i)]->backward(gradCurrent);
+        gradCurrent = cnnLayers_[static_cast<size_t>(i)]->backwardOwned(std::move(gradCurrent));
     }
 }
 
 void CNNNetwork::updateWeightsInternal(double learningRate) {
-    for (auto& layer : denseLayers_) {
+    for (size_t l = 0; l < denseLayers_.size(); ++l) {
+        Layer& layer = denseLayers_[l];
+        const double* in = denseInput(l);
         for (int j = 0; j < layer.outputSize; ++j) {
             const size_t jIdx = static_cast<size_t>(j);
             double delta_lr = learningRate * layer.delta[jIdx];
             for (int i = 0; i < layer.inputSize; ++i) {
-                const size_t iIdx = static_cast<size_t>(i);
-                layer.weight(j, i) += delta_lr * layer.input[iIdx];
+                layer.weight(j, i) += delta_lr * in[static_cast<size_t>(i)];
             }
             layer.biases[jIdx] += delta_lr;
         }
@@ -406,6 +507,10 @@ double CNNNetwork::calculateLossInternal(const std::vector<double>& output,
     return loss / static_cast<double>(output.size());
 }
 
+const double* CNNNetwork::denseInput(size_t l) const {
+    return l == 0 ? &flattenedOutput_(0, 0, 0) : denseLayers_[l - 1].output.data();
+}
+
 void CNNNetwork::validateInputShape(const Tensor& input) const {
     if (input.channels() != inputChannels_ ||
         input.height() != inputHeight_ ||
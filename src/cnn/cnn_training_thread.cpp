@@ -1,14 +1,18 @@
 #include "cnn/cnn_training_thread.h"
+#include "data_pipeline.h"
+#include "synthetic_datasets.h"
 #include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 CNNTrainingThread::CNNTrainingThread(QObject* parent)
     : QThread(parent)
     , network_(nullptr)
     , epochs_(100)
     , learningRate_(0.01)
-    , running_(false)
-    , paused_(false)
-    , stopRequested_(false) {
+    , running_(false) {
+    registerProgressMetaTypes();
 }
 
 CNNTrainingThread::~CNNTrainingThread() {
@@ -21,11 +25,26 @@ void CNNTrainingThread::setNetwork(CNNNetwork* network) {
     network_ = network;
 }
 
-void CNNTrainingThread::setTrainingData(const std::vector<Tensor>& inputs,
-                                        const std::vector<std::vector<double>>& targets) {
+void CNNTrainingThread::setTrainingData(std::vector<Tensor> inputs,
+                                        std::vector<std::vector<double>> targets) {
     QMutexLocker locker(&mutex_);
-    inputs_ = inputs;
-    targets_ = targets;
+    inputs_ = std::move(inputs);
+    targets_ = std::move(targets);
+    shapeSamplesPerClass_ = 0;
+}
+
+void CNNTrainingThread::setShapeDataset(int imageSize, int numClasses, int samplesPerClass) {
+    QMutexLocker locker(&mutex_);
+    inputs_.clear();
+    targets_.clear();
+    shapeImageSize_ = imageSize;
+    shapeClasses_ = numClasses;
+    shapeSamplesPerClass_ = samplesPerClass;
+}
+
+void CNNTrainingThread::setAugmentation(ImageAugmenter augmenter) {
+    QMutexLocker locker(&mutex_);
+    augmenter_ = std::move(augmenter);
 }
 
 void CNNTrainingThread::setParameters(int epochs, double learningRate) {
@@ -34,44 +53,161 @@ void CNNTrainingThread::setParameters(int epochs, double learningRate) {
     learningRate_ = learningRate;
 }
 
+void CNNTrainingThread::setUpdateRate(double rateHz) {
+    QMutexLocker locker(&mutex_);
+    updateRateHz_ = rateHz;
+}
+
+void CNNTrainingThread::startTraining() {
+    control_.reset();
+    start();
+}
+
 void CNNTrainingThread::stopTraining() {
-    stopRequested_ = true;
-    paused_ = false;
+    control_.stop();
 }
 
 void CNNTrainingThread::pauseTraining() {
-    paused_ = true;
+    control_.pause();
 }
 
 void CNNTrainingThread::resumeTraining() {
-    paused_ = false;
+    control_.resume();
 }
 
 void CNNTrainingThread::run() {
     if (!network_) return;
 
     running_ = true;
-    stopRequested_ = false;
 
-    for (int epoch = 0; epoch < epochs_ && !stopRequested_; ++epoch) {
-        while (paused_ && !stopRequested_) {
-            msleep(100);
+    ProgressThrottle throttle;
+    {
+        QMutexLocker locker(&mutex_);
+        throttle.setRate(updateRateHz_);
+    }
+
+    if (!buildShapeDataset()) {
+        running_ = false;
+        emit trainingCompleted();
+        return;
+    }
+
+    // 启用增强时，生成线程在整个训练期间持续产出增强样本，与网络计算重叠进行
+    std::unique_ptr<DataPipeline<Tensor>> augmented;
+    {
+        QMutexLocker locker(&mutex_);
+        if (!augmenter_.empty() && !inputs_.empty()) {
+            augmented = makeAugmentationPipeline(
+                augmenter_, [this](size_t index) { return TensorView(inputs_[index]); }, inputs_.size(),
+                kAugmentWorkers, 2 * kAugmentBatch, nextRandomStream()(),
+                static_cast<size_t>(epochs_) * inputs_.size());
         }
+    }
 
-        if (stopRequested_) break;
+    for (int epoch = 0; epoch < epochs_; ++epoch) {
+        if (control_.isPaused() && throttle.hasPending()) {
+            flushProgress(throttle); // 暂停时界面显示到最新一轮
+        }
+        // 暂停时在条件变量上等待，不占用 CPU；恢复或取消会立即唤醒
+        if (!control_.checkpoint()) break;
 
         double loss;
-        {
+        if (augmented) {
+            loss = trainAugmentedEpoch(*augmented);
+        } else {
             QMutexLocker locker(&mutex_);
-            loss = network_->train(inputs_, targets_, learningRate_);
+            loss = network_->train(inputs_, targets_, learningRate_, &control_);
         }
+        if (control_.stopRequested()) break; // 本轮在样本之间被取消，不计入进度
 
-        emit epochCompleted(epoch + 1, loss);
-        emit weightsUpdated();
+        // 训练全速进行，界面按帧率接收合并后的进度
+        if (throttle.record(epoch + 1, loss)) {
+            flushProgress(throttle);
+        }
+    }
 
-        msleep(10);
+    if (throttle.hasPending()) {
+        flushProgress(throttle);
     }
 
     running_ = false;
     emit trainingCompleted();
 }
+
+void CNNTrainingThread::flushProgress(ProgressThrottle& throttle) {
+    // 发布快照后再通知界面，界面绘制时只读快照，不再争用网络的锁
+    network_->publishSnapshot();
+    emit progressUpdated(throttle.takeBatch());
+    emit weightsUpdated();
+}
+
+double CNNTrainingThread::trainAugmentedEpoch(DataPipeline<Tensor>& pipeline) {
+    const size_t total = inputs_.size();
+    std::vector<Tensor> images(kAugmentBatch);
+    std::vector<TensorView> views;
+    std::vector<const double*> targets;
+    double totalLoss = 0.0;
+    size_t trained = 0;
+
+    while (trained < total && !control_.stopRequested()) {
+        const size_t count = std::min(kAugmentBatch, total - trained);
+        views.clear();
+        targets.clear();
+        // 本批训练期间，生成线程已在增强后续样本
+        for (size_t k = 0; k < count; ++k) {
+            size_t index = 0;
+            if (!pipeline.nextInOrder(images[k], &index)) {
+                return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+            }
+            views.emplace_back(images[k]);
+            targets.push_back(targets_[index % total].data());
+        }
+
+        QMutexLocker locker(&mutex_);
+        totalLoss += network_->trainBatch(views, targets, learningRate_, &control_) * static_cast<double>(count);
+        trained += count;
+    }
+    return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+}
+
+bool CNNTrainingThread::buildShapeDataset() {
+    int imageSize, numClasses, samplesPerClass;
+    {
+        QMutexLocker locker(&mutex_);
+        if (shapeSamplesPerClass_ <= 0 || !inputs_.empty()) return true;
+        imageSize = shapeImageSize_;
+        numClasses = shapeClasses_;
+        samplesPerClass = shapeSamplesPerClass_;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t total = static_cast<size_t>(numClasses) * static_cast<size_t>(samplesPerClass);
+    std::vector<Tensor> images(total);
+    std::vector<std::vector<double>> labels(total);
+
+    // 样本编号决定类别（与 makeShapeDataset 相同的按类别排列），各生成线程并行合成
+    const size_t workers = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+    DataPipeline<Tensor> pipeline(
+        [imageSize, samplesPerClass](size_t index, PhiloxRng& gen) {
+            return makeShapeImage(static_cast<int>(index) / samplesPerClass, imageSize, gen);
+        },
+        workers, 64, nextRandomStream()(), total);
+
+    Tensor image;
+    size_t index = 0;
+    while (pipeline.next(image, &index)) {
+        if (control_.stopRequested()) return false;
+        images[index] = std::move(image);
+        labels[index].assign(static_cast<size_t>(numClasses), 0.0);
+        labels[index][index / static_cast<size_t>(samplesPerClass)] = 1.0;
+    }
+
+    {
+        QMutexLocker locker(&mutex_);
+        inputs_ = std::move(images);
+        targets_ = std::move(labels);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    emit datasetReady(static_cast<int>(total), seconds);
+    return true;
+}
@@ -1,4 +1,6 @@
 #include "cnn/conv_layer.h"
+#include "cnn/tensor_view.h"
+#include "thread_pool.h"
 #include <cmath>
 #include <algorithm>
 #include <stdexcept>
@@ -6,7 +8,7 @@
 ConvolutionalLayer::ConvolutionalLayer(size_t inputChannels, size_t inputHeight, size_t inputWidth,
                                        size_t outputChannels, size_t kernelSize,
                                        size_t stride, size_t padding,
-                                       CNNActivationType activation)
+                                       CNNActivationType activation, PhiloxRng rng)
     : inputChannels_(inputChannels), inputHeight_(inputHeight), inputWidth_(inputWidth),
       outputChannels_(outputChannels), kernelSize_(kernelSize),
       stride_(stride), padding_(padding), activation_(activation) {
@@ -14,7 +16,7 @@ ConvolutionalLayer::ConvolutionalLayer(size_t inputChannels, size_t inputHeight,
         throw std::invalid_argument("ConvolutionalLayer: stride must be greater than 0");
     }
     computeOutputSize();
-    initializeWeights();
+    initializeWeights(rng);
 }
 
 void ConvolutionalLayer::computeOutputSize() {
@@ -40,7 +42,7 @@ void ConvolutionalLayer::computeOutputSize() {
     outputWidth_ = static_cast<size_t>(outW);
 }
 
-void ConvolutionalLayer::initializeWeights() {
+void ConvolutionalLayer::initializeWeights(PhiloxRng rng) {
     kernels_.resize(outputChannels_);
     kernelGradients_.resize(outputChannels_);
     biases_.resize(outputChannels_, 0.0);
@@ -49,16 +51,19 @@ void ConvolutionalLayer::initializeWeights() {
     size_t fanIn = inputChannels_ * kernelSize_ * kernelSize_;
     size_t fanOut = outputChannels_ * kernelSize_ * kernelSize_;
 
-    for (size_t oc = 0; oc < outputChannels_; ++oc) {
+    const bool useHe = activation_ == CNNActivationType::ReLU || activation_ == CNNActivationType::LeakyReLU ||
+                       activation_ == CNNActivationType::GELU;
+    ThreadPool::global().parallelFor(outputChannels_, [&](size_t oc) {
         kernels_[oc] = Tensor(inputChannels_, kernelSize_, kernelSize_);
         kernelGradients_[oc] = Tensor(inputChannels_, kernelSize_, kernelSize_);
 
-        if (activation_ == CNNActivationType::ReLU || activation_ == CNNActivationType::LeakyReLU) {
-            kernels_[oc].heInit(fanIn);
+        PhiloxRng kernelRng = rng.stream(oc);
+        if (useHe) {
+            kernels_[oc].heInit(kernelRng, fanIn);
         } else {
-            kernels_[oc].xavierInit(fanIn, fanOut);
+            kernels_[oc].xavierInit(kernelRng, fanIn, fanOut);
         }
-    }
+    });
 
     preActivation_ = Tensor(outputChannels_, outputHeight_, outputWidth_);
     lastOutput_ = Tensor(outputChannels_, outputHeight_, outputWidth_);
@@ -68,42 +73,6 @@ void ConvolutionalLayer::initializeWeights() {
     paddedInputBuffer_ = Tensor(inputChannels_, paddedH, paddedW);
 }
 
-double ConvolutionalLayer::activate(double x) const {
-    switch (activation_) {
-        case CNNActivationType::ReLU:
-            return std::max(0.0, x);
-        case CNNActivationType::LeakyReLU:
-            return x > 0 ? x : 0.01 * x;
-        case CNNActivationType::Sigmoid:
-            return 1.0 / (1.0 + std::exp(-std::clamp(x, -500.0, 500.0)));
-        case CNNActivationType::Tanh:
-            return std::tanh(x);
-        case CNNActivationType::None:
-        default:
-            return x;
-    }
-}
-
-double ConvolutionalLayer::activateDerivative(double x) const {
-    switch (activation_) {
-        case CNNActivationType::ReLU:
-            return x > 0 ? 1.0 : 0.0;
-        case CNNActivationType::LeakyReLU:
-            return x > 0 ? 1.0 : 0.01;
-        case CNNActivationType::Sigmoid: {
-            double s = 1.0 / (1.0 + std::exp(-std::clamp(x, -500.0, 500.0)));
-            return s * (1.0 - s);
-        }
-        case CNNActivationType::Tanh: {
-            double t = std::tanh(x);
-            return 1.0 - t * t;
-        }
-        case CNNActivationType::None:
-        default:
-            return 1.0;
-    }
-}
-
 Tensor ConvolutionalLayer::forward(const Tensor& input) {
     if (input.channels() != inputChannels_ ||
         input.height() != inputHeight_ ||
@@ -143,11 +112,15 @@ Tensor ConvolutionalLayer::forward(const Tensor& input) {
                 }
 
                 preActivation_(oc, oh, ow) = sum;
-                outputBuffer_(oc, oh, ow) = activate(sum);
             }
         }
     }
 
+    visitActivation(activation_, precision_, [&](auto kernel) {
+        activationForward<decltype(kernel)>(preActivation_.rawData(), outputBuffer_.rawData(),
+                                            preActivation_.size());
+    });
+
     lastOutput_ = outputBuffer_;
     return lastOutput_;
 }
@@ -166,19 +139,14 @@ Tensor ConvolutionalLayer::backward(const Tensor& gradOutput) {
     gradInput.zero();
 
     Tensor delta(outputChannels_, outputHeight_, outputWidth_);
-    for (size_t oc = 0; oc < outputChannels_; ++oc) {
-        for (size_t oh = 0; oh < outputHeight_; ++oh) {
-            for (size_t ow = 0; ow < outputWidth_; ++ow) {
-                delta(oc, oh, ow) = gradOutput(oc, oh, ow) *
-                                   activateDerivative(preActivation_(oc, oh, ow));
-            }
-        }
-    }
-
-    Tensor paddedInput = lastInput_;
-    if (padding_ > 0) {
-        paddedInput = lastInput_.pad(padding_, padding_, 0.0);
-    }
+    visitActivation(activation_, precision_, [&](auto kernel) {
+        activationBackward<decltype(kernel)>(preActivation_.rawData(), gradOutput.rawData(),
+                                             delta.rawData(), delta.size());
+    });
+
+    // 复用前向传播时已填充的输入缓冲区，避免再次复制/填充
+    const TensorView paddedInput = padding_ > 0 ? TensorView(paddedInputBuffer_)
+                                                : TensorView(lastInput_);
 
     for (size_t oc = 0; oc < outputChannels_; ++oc) {
         for (size_t oh = 0; oh < outputHeight_; ++oh) {
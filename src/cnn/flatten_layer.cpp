@@ -7,48 +7,34 @@ FlattenLayer::FlattenLayer(size_t inputChannels, size_t inputHeight, size_t inpu
 }
 
 Tensor FlattenLayer::forward(const Tensor& input) {
+    // input 为只读引用，复制一份后按所有权移交的路径处理
+    return forwardOwned(Tensor(input));
+}
+
+Tensor FlattenLayer::forwardOwned(Tensor&& input) {
     if (input.channels() != inputChannels_ ||
         input.height() != inputHeight_ ||
         input.width() != inputWidth_) {
         throw std::invalid_argument("FlattenLayer: input shape mismatch");
     }
 
-    lastInput_ = input;
-
-    Tensor output(1, 1, flattenedSize_);
-
-    size_t idx = 0;
-    for (size_t c = 0; c < inputChannels_; ++c) {
-        for (size_t h = 0; h < inputHeight_; ++h) {
-            for (size_t w = 0; w < inputWidth_; ++w) {
-                output(0, 0, idx++) = input(c, h, w);
-            }
-        }
-    }
-
-    lastOutput_ = output;
-    return output;
+    // CHW行主序数据本身已是展平顺序，输出与输入共享存储
+    lastOutput_ = input.reshape(1, 1, flattenedSize_);
+    return lastOutput_.reshape(1, 1, flattenedSize_);
 }
 
 Tensor FlattenLayer::backward(const Tensor& gradOutput) {
+    return backwardOwned(Tensor(gradOutput));
+}
+
+Tensor FlattenLayer::backwardOwned(Tensor&& gradOutput) {
     if (gradOutput.channels() != 1 ||
         gradOutput.height() != 1 ||
         gradOutput.width() != flattenedSize_) {
         throw std::invalid_argument("FlattenLayer: gradOutput shape mismatch");
     }
 
-    Tensor gradInput(inputChannels_, inputHeight_, inputWidth_);
-
-    size_t idx = 0;
-    for (size_t c = 0; c < inputChannels_; ++c) {
-        for (size_t h = 0; h < inputHeight_; ++h) {
-            for (size_t w = 0; w < inputWidth_; ++w) {
-                gradInput(c, h, w) = gradOutput(0, 0, idx++);
-            }
-        }
-    }
-
-    return gradInput;
+    return gradOutput.reshape(inputChannels_, inputHeight_, inputWidth_);
 }
 
 std::vector<double> FlattenLayer::getFlattenedOutput() const {
@@ -1,14 +1,168 @@
 #include "cnn/random.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
 #include <random>
+#include <stdexcept>
 
 namespace {
-    std::mt19937 createRng() {
-        std::random_device rd;
-        return std::mt19937(rd());
+
+const uint32_t kPhiloxM0 = 0xD2511F53u;
+const uint32_t kPhiloxM1 = 0xCD9E8D57u;
+const uint32_t kPhiloxW0 = 0x9E3779B9u;
+const uint32_t kPhiloxW1 = 0xBB67AE85u;
+
+// 全局流的编号空间：共享分配的流与各线程的流互不重叠
+const uint64_t kSharedStreams = 1;
+const uint64_t kThreadStreams = 2;
+
+uint64_t splitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+void mulHiLo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+    const uint64_t product = static_cast<uint64_t>(a) * b;
+    hi = static_cast<uint32_t>(product >> 32);
+    lo = static_cast<uint32_t>(product);
+}
+
+uint64_t initialSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+std::atomic<uint64_t>& seedStorage() {
+    static std::atomic<uint64_t> seed{initialSeed()};
+    return seed;
+}
+
+std::atomic<uint64_t> nextStream{0};
+std::atomic<uint64_t> seedGeneration{0};
+std::atomic<uint64_t> nextThreadIndex{0};
+
+} // namespace
+
+std::array<uint32_t, 4> PhiloxRng::block(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+        uint32_t hi0, lo0, hi1, lo1;
+        mulHiLo(kPhiloxM0, counter[0], hi0, lo0);
+        mulHiLo(kPhiloxM1, counter[2], hi1, lo1);
+        counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+        key[0] += kPhiloxW0;
+        key[1] += kPhiloxW1;
+    }
+    return counter;
+}
+
+PhiloxRng PhiloxRng::stream(uint64_t id) const {
+    return PhiloxRng(seed_, splitMix64(stream_ ^ splitMix64(id)));
+}
+
+PhiloxRng::result_type PhiloxRng::operator()() {
+    // 计数器 = (分组序号, 流编号)，密钥 = 种子
+    const uint64_t blockIndex = position_ >> 1;
+    if (blockIndex != cachedBlock_) {
+        const std::array<uint32_t, 4> out = block(
+            {static_cast<uint32_t>(blockIndex), static_cast<uint32_t>(blockIndex >> 32),
+             static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)},
+            {static_cast<uint32_t>(seed_), static_cast<uint32_t>(seed_ >> 32)});
+        cached_[0] = static_cast<uint64_t>(out[0]) | (static_cast<uint64_t>(out[1]) << 32);
+        cached_[1] = static_cast<uint64_t>(out[2]) | (static_cast<uint64_t>(out[3]) << 32);
+        cachedBlock_ = blockIndex;
+    }
+    return cached_[position_++ & 1];
+}
+
+double PhiloxRng::uniform() {
+    return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+}
+
+uint64_t PhiloxRng::uniformIndex(uint64_t n) {
+    if (n == 0) {
+        throw std::invalid_argument("uniformIndex: n must be greater than 0");
+    }
+    // 丢弃最低的 2^64 mod n 个值，余下的取模后均匀
+    const uint64_t threshold = (0 - n) % n;
+    for (;;) {
+        const uint64_t x = (*this)();
+        if (x >= threshold) return x % n;
+    }
+}
+
+double PhiloxRng::normal(double mean, double stddev) {
+    const double u1 = 1.0 - uniform(); // (0, 1]，避免 log(0)
+    const double u2 = uniform();
+    const double twoPi = 6.283185307179586476925;
+    return mean + stddev * std::sqrt(-2.0 * std::log(u1)) * std::cos(twoPi * u2);
+}
+
+void setGlobalSeed(uint64_t seed) {
+    seedStorage().store(seed);
+    nextStream.store(0);
+    seedGeneration.fetch_add(1);
+}
+
+uint64_t globalSeed() {
+    return seedStorage().load();
+}
+
+PhiloxRng nextRandomStream() {
+    return PhiloxRng(globalSeed(), kSharedStreams).stream(nextStream.fetch_add(1));
+}
+
+PhiloxRng& getRng() {
+    struct ThreadRng {
+        uint64_t index = nextThreadIndex.fetch_add(1);
+        uint64_t generation = ~uint64_t(0);
+        PhiloxRng rng;
+    };
+    thread_local ThreadRng local;
+    // 全局种子改变后，各线程在下次使用时重新派生自己的流
+    const uint64_t generation = seedGeneration.load();
+    if (local.generation != generation) {
+        local.rng = PhiloxRng(globalSeed(), kThreadStreams).stream(local.index);
+        local.generation = generation;
+    }
+    return local.rng;
+}
+
+void shufflePermutation(std::vector<size_t>& order, size_t n, PhiloxRng rng) {
+    order.resize(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    for (size_t i = n; i > 1; --i) {
+        const size_t j = static_cast<size_t>(rng.uniformIndex(i));
+        std::swap(order[i - 1], order[j]);
+    }
+}
+
+ShuffledBatchSampler::ShuffledBatchSampler(size_t size, size_t batchSize, PhiloxRng rng, bool shuffle)
+    : batchSize_(batchSize), rng_(rng), shuffle_(shuffle), order_(size) {
+    if (batchSize == 0) {
+        throw std::invalid_argument("ShuffledBatchSampler: batch size must be greater than 0");
+    }
+    setEpoch(0);
+}
+
+void ShuffledBatchSampler::setEpoch(uint64_t epoch) {
+    epoch_ = epoch;
+    position_ = 0;
+    if (shuffle_) {
+        shufflePermutation(order_, order_.size(), rng_.stream(epoch));
+    } else {
+        std::iota(order_.begin(), order_.end(), size_t(0));
     }
 }
 
-std::mt19937& getRng() {
-    static std::mt19937 rng = createRng();
-    return rng;
+bool ShuffledBatchSampler::next(std::vector<size_t>& batch) {
+    batch.clear();
+    if (position_ >= order_.size()) return false;
+    const size_t end = std::min(position_ + batchSize_, order_.size());
+    batch.assign(order_.begin() + static_cast<std::ptrdiff_t>(position_),
+                 order_.begin() + static_cast<std::ptrdiff_t>(end));
+    position_ = end;
+    return true;
 }
@@ -1,38 +1,101 @@
 #include "cnn/tensor.h"
+#include "cnn/tensor_view.h"
 #include "cnn/random.h"
 #include <limits>
 #include <string>
 
+namespace {
+    const std::vector<double>& emptyStorage() {
+        static const std::vector<double> empty;
+        return empty;
+    }
+
+    void checkReshape(size_t size, size_t channels, size_t height, size_t width) {
+        if (channels * height * width != size) {
+            throw std::invalid_argument("Reshape size mismatch: " + std::to_string(size) +
+                                        " vs " + std::to_string(channels * height * width));
+        }
+    }
+}
+
 Tensor::Tensor() : channels_(0), height_(0), width_(0) {}
 
 Tensor::Tensor(size_t channels, size_t height, size_t width)
     : channels_(channels), height_(height), width_(width),
-      data_(channels * height * width, 0.0) {}
+      data_(std::make_shared<std::vector<double>>(channels * height * width, 0.0)) {}
 
 Tensor::Tensor(size_t channels, size_t height, size_t width, double initValue)
     : channels_(channels), height_(height), width_(width),
-      data_(channels * height * width, initValue) {}
+      data_(std::make_shared<std::vector<double>>(channels * height * width, initValue)) {}
+
+Tensor::Tensor(const Tensor& other)
+    : channels_(other.channels_), height_(other.height_), width_(other.width_),
+      data_(other.data_ ? std::make_shared<std::vector<double>>(*other.data_) : nullptr) {}
+
+Tensor::Tensor(Tensor&& other) noexcept
+    : channels_(other.channels_), height_(other.height_), width_(other.width_),
+      data_(std::move(other.data_)) {
+    other.channels_ = other.height_ = other.width_ = 0;
+}
+
+Tensor& Tensor::operator=(const Tensor& other) {
+    if (this == &other) return *this;
+    channels_ = other.channels_;
+    height_ = other.height_;
+    width_ = other.width_;
+    if (!other.data_) {
+        data_.reset();
+    } else if (data_ && data_.use_count() == 1) {
+        // 独占存储时原地复用缓冲区
+        *data_ = *other.data_;
+    } else {
+        // 视图赋值时脱离共享存储，避免改写其他张量
+        data_ = std::make_shared<std::vector<double>>(*other.data_);
+    }
+    return *this;
+}
+
+Tensor& Tensor::operator=(Tensor&& other) noexcept {
+    if (this == &other) return *this;
+    channels_ = other.channels_;
+    height_ = other.height_;
+    width_ = other.width_;
+    data_ = std::move(other.data_);
+    other.channels_ = other.height_ = other.width_ = 0;
+    return *this;
+}
+
+std::vector<double>& Tensor::data() {
+    if (!data_) {
+        data_ = std::make_shared<std::vector<double>>();
+    }
+    return *data_;
+}
+
+const std::vector<double>& Tensor::data() const {
+    return data_ ? *data_ : emptyStorage();
+}
 
 double& Tensor::at(size_t c, size_t h, size_t w) {
     if (c >= channels_ || h >= height_ || w >= width_) {
         throw std::out_of_range("Tensor index out of range");
     }
-    return data_[index(c, h, w)];
+    return (*data_)[index(c, h, w)];
 }
 
 const double& Tensor::at(size_t c, size_t h, size_t w) const {
     if (c >= channels_ || h >= height_ || w >= width_) {
         throw std::out_of_range("Tensor index out of range");
     }
-    return data_[index(c, h, w)];
+    return (*data_)[index(c, h, w)];
 }
 
 double& Tensor::operator()(size_t c, size_t h, size_t w) {
-    return data_[index(c, h, w)];
+    return (*data_)[index(c, h, w)];
 }
 
 const double& Tensor::operator()(size_t c, size_t h, size_t w) const {
-    return data_[index(c, h, w)];
+    return (*data_)[index(c, h, w)];
 }
 
 std::vector<double> Tensor::getChannel(size_t c) const {
@@ -49,7 +112,7 @@ std::vector<double> Tensor::getChannel(size_t c) const {
     }
     const auto offset = static_cast<std::ptrdiff_t>(offsetSize);
     const auto count = static_cast<std::ptrdiff_t>(countSize);
-    std::copy(data_.begin() + offset, data_.begin() + offset + count, channel.begin());
+    std::copy(data_->begin() + offset, data_->begin() + offset + count, channel.begin());
     return channel;
 }
 
@@ -62,59 +125,84 @@ void Tensor::setChannel(size_t c, const std::vector<double>& data) {
         throw std::out_of_range("Tensor offset out of range");
     }
     const auto offset = static_cast<std::ptrdiff_t>(offsetSize);
-    std::copy(data.begin(), data.end(), data_.begin() + offset);
+    std::copy(data.begin(), data.end(), data_->begin() + offset);
 }
 
 void Tensor::resize(size_t channels, size_t height, size_t width) {
     channels_ = channels;
     height_ = height;
     width_ = width;
-    data_.resize(channels * height * width);
-    std::fill(data_.begin(), data_.end(), 0.0);
+    if (data_ && data_.use_count() == 1) {
+        data_->assign(channels * height * width, 0.0);
+    } else {
+        data_ = std::make_shared<std::vector<double>>(channels * height * width, 0.0);
+    }
+}
+
+Tensor Tensor::reshape(size_t channels, size_t height, size_t width) {
+    checkReshape(size(), channels, height, width);
+    Tensor view;
+    view.channels_ = channels;
+    view.height_ = height;
+    view.width_ = width;
+    view.data_ = data_;
+    return view;
+}
+
+TensorView Tensor::reshape(size_t channels, size_t height, size_t width) const {
+    checkReshape(size(), channels, height, width);
+    return TensorView(rawData(), channels, height, width);
+}
+
+TensorView Tensor::asRows() const {
+    return reshape(1, channels_ * height_, width_);
 }
 
 void Tensor::fill(double value) {
-    std::fill(data_.begin(), data_.end(), value);
+    if (data_) std::fill(data_->begin(), data_->end(), value);
 }
 
 void Tensor::randomInit(double min, double max) {
-    auto& gen = getRng();
-    std::uniform_real_distribution<> dis(min, max);
-    for (auto& v : data_) {
-        v = dis(gen);
+    PhiloxRng rng = nextRandomStream();
+    randomInit(rng, min, max);
+}
+
+void Tensor::randomInit(PhiloxRng& rng, double min, double max) {
+    for (auto& v : data()) {
+        v = rng.uniform(min, max);
     }
 }
 
 void Tensor::xavierInit(size_t fanIn, size_t fanOut) {
+    PhiloxRng rng = nextRandomStream();
+    xavierInit(rng, fanIn, fanOut);
+}
+
+void Tensor::xavierInit(PhiloxRng& rng, size_t fanIn, size_t fanOut) {
     if (fanIn == 0 || fanOut == 0) {
         throw std::invalid_argument("Xavier initialization: fanIn and fanOut must be greater than 0");
     }
-    auto& gen = getRng();
     double limit = std::sqrt(6.0 / (static_cast<double>(fanIn) + static_cast<double>(fanOut)));
-    std::uniform_real_distribution<> dis(-limit, limit);
-    for (auto& v : data_) {
-        v = dis(gen);
+    for (auto& v : data()) {
+        v = rng.uniform(-limit, limit);
     }
 }
 
 void Tensor::heInit(size_t fanIn) {
+    PhiloxRng rng = nextRandomStream();
+    heInit(rng, fanIn);
+}
+
+void Tensor::heInit(PhiloxRng& rng, size_t fanIn) {
     if (fanIn == 0) {
         throw std::invalid_argument("He initialization: fanIn must be greater than 0");
     }
-    auto& gen = getRng();
     double stddev = std::sqrt(2.0 / static_cast<double>(fanIn));
-    std::normal_distribution<> dis(0.0, stddev);
-    for (auto& v : data_) {
-        v = dis(gen);
+    for (auto& v : data()) {
+        v = rng.normal(0.0, stddev);
     }
 }
 
-Tensor Tensor::operator+(const Tensor& other) const {
-    Tensor result(*this);
-    result += other;
-    return result;
-}
-
 void Tensor::pad(Tensor& destination, size_t padHeight, size_t padWidth, double padValue) const {
     size_t newHeight = height_ + 2 * padHeight;
     size_t newWidth = width_ + 2 * padWidth;
@@ -136,72 +224,35 @@ void Tensor::pad(Tensor& destination, size_t padHeight, size_t padWidth, double
     }
 }
 
-Tensor Tensor::operator-(const Tensor& other) const {
-    Tensor result(*this);
-    result -= other;
-    return result;
-}
-
-Tensor Tensor::operator*(double scalar) const {
-    Tensor result(*this);
-    result *= scalar;
-    return result;
-}
-
-Tensor& Tensor::operator+=(const Tensor& other) {
-    for (size_t i = 0; i < data_.size(); ++i) {
-        data_[i] += other.data_[i];
-    }
-    return *this;
-}
-
-Tensor& Tensor::operator-=(const Tensor& other) {
-    for (size_t i = 0; i < data_.size(); ++i) {
-        data_[i] -= other.data_[i];
-    }
-    return *this;
-}
-
 Tensor& Tensor::operator*=(double scalar) {
-    for (auto& v : data_) {
+    for (auto& v : data()) {
         v *= scalar;
     }
     return *this;
 }
 
-void Tensor::apply(const std::function<double(double)>& func) {
-    for (auto& v : data_) {
-        v = func(v);
-    }
-}
-
-Tensor Tensor::map(const std::function<double(double)>& func) const {
-    Tensor result(*this);
-    result.apply(func);
-    return result;
-}
-
 double Tensor::sum() const {
-    return std::accumulate(data_.begin(), data_.end(), 0.0);
+    const auto& d = data();
+    return std::accumulate(d.begin(), d.end(), 0.0);
 }
 
 double Tensor::mean() const {
-    if (data_.empty()) return 0.0;
-    return sum() / static_cast<double>(data_.size());
+    if (empty()) return 0.0;
+    return sum() / static_cast<double>(size());
 }
 
 double Tensor::max() const {
-    if (data_.empty()) return 0.0;
-    return *std::max_element(data_.begin(), data_.end());
+    if (empty()) return 0.0;
+    return *std::max_element(data_->begin(), data_->end());
 }
 
 double Tensor::min() const {
-    if (data_.empty()) return 0.0;
-    return *std::min_element(data_.begin(), data_.end());
+    if (empty()) return 0.0;
+    return *std::min_element(data_->begin(), data_->end());
 }
 
 std::vector<double> Tensor::flatten() const {
-    return data_;
+    return data();
 }
 
 Tensor Tensor::fromVector(const std::vector<double>& vec,
@@ -210,7 +261,7 @@ Tensor Tensor::fromVector(const std::vector<double>& vec,
     if (vec.size() != channels * height * width) {
         throw std::invalid_argument("Vector size mismatch");
     }
-    t.data_ = vec;
+    *t.data_ = vec;
     return t;
 }
 
@@ -227,67 +278,48 @@ Tensor Tensor::pad(size_t padHeight, size_t padWidth, double padValue) const {
 }
 
 Tensor Tensor::matmul(const Tensor& other) const {
-    if (channels_ != other.channels_) {
-        throw std::invalid_argument("Channel mismatch in matmul: " + std::to_string(channels_) + " vs " + std::to_string(other.channels_));
-    }
-    if (width_ != other.height_) {
-        throw std::invalid_argument("Dimension mismatch in matmul: " + std::to_string(width_) + " vs " + std::to_string(other.height_));
-    }
-
-    Tensor result(channels_, height_, other.width_);
-    for (size_t c = 0; c < channels_; ++c) {
-        for (size_t i = 0; i < height_; ++i) {
-            for (size_t k = 0; k < width_; ++k) {
-                double val = at(c, i, k);
-                for (size_t j = 0; j < other.width_; ++j) {
-                    result(c, i, j) += val * other(c, k, j);
-                }
-            }
-        }
-    }
-    return result;
+    return ::matmul(TensorView(*this), TensorView(other));
 }
 
 Tensor Tensor::transpose() const {
-    Tensor result(channels_, width_, height_);
-    for (size_t c = 0; c < channels_; ++c) {
-        for (size_t h = 0; h < height_; ++h) {
-            for (size_t w = 0; w < width_; ++w) {
-                result(c, w, h) = at(c, h, w);
-            }
-        }
-    }
-    return result;
+    return TensorView(*this).transposed().toTensor();
 }
 
-void Tensor::softmax() {
-    for (size_t c = 0; c < channels_; ++c) {
-        for (size_t h = 0; h < height_; ++h) {
+void Tensor::softmax(MathPrecision precision) {
+    visitPrecision(precision, [&](auto p) {
+        constexpr MathPrecision P = decltype(p)::value;
+        double* rowPtr = rawData();
+        const size_t rows = channels_ * height_;
+        for (size_t r = 0; r < rows; ++r, rowPtr += width_) {
             double maxVal = -std::numeric_limits<double>::infinity();
             for (size_t w = 0; w < width_; ++w) {
-                maxVal = std::max(maxVal, at(c, h, w));
+                maxVal = std::max(maxVal, rowPtr[w]);
             }
 
             double sumExp = 0.0;
             for (size_t w = 0; w < width_; ++w) {
-                double val = std::exp(at(c, h, w) - maxVal);
-                at(c, h, w) = val;
+                double val = expApprox<P>(rowPtr[w] - maxVal);
+                rowPtr[w] = val;
                 sumExp += val;
             }
 
+            const double invSum = 1.0 / sumExp;
             for (size_t w = 0; w < width_; ++w) {
-                at(c, h, w) /= sumExp;
+                rowPtr[w] *= invSum;
             }
         }
-    }
+    });
 }
 
 Tensor Tensor::randn(size_t c, size_t h, size_t w) {
+    PhiloxRng rng = nextRandomStream();
+    return randn(c, h, w, rng);
+}
+
+Tensor Tensor::randn(size_t c, size_t h, size_t w, PhiloxRng& rng) {
     Tensor t(c, h, w);
-    auto& gen = getRng();
-    std::normal_distribution<> dis(0.0, 1.0);
-    for (auto& v : t.data_) {
-        v = dis(gen);
+    for (auto& v : t.data()) {
+        v = rng.normal();
     }
     return t;
 }
@@ -0,0 +1,91 @@
+#include "cnn/tensor_view.h"
+#include <limits>
+#include <string>
+
+TensorView TensorView::channel(size_t c) const {
+    return channelRange(c, 1);
+}
+
+TensorView TensorView::channelRange(size_t first, size_t count) const {
+    if (first + count > channels_) {
+        throw std::out_of_range("TensorView channel range out of range");
+    }
+    return TensorView(data_, offset_ + first * strideC_,
+                      count, height_, width_,
+                      strideC_, strideH_, strideW_);
+}
+
+TensorView TensorView::transposed() const {
+    return TensorView(data_, offset_,
+                      channels_, width_, height_,
+                      strideC_, strideW_, strideH_);
+}
+
+TensorView TensorView::window(size_t h0, size_t w0, size_t height, size_t width) const {
+    if (h0 + height > height_ || w0 + width > width_) {
+        throw std::out_of_range("TensorView window out of range");
+    }
+    return TensorView(data_, offset_ + h0 * strideH_ + w0 * strideW_,
+                      channels_, height, width,
+                      strideC_, strideH_, strideW_);
+}
+
+double TensorView::min() const {
+    if (empty()) return 0.0;
+    double result = std::numeric_limits<double>::max();
+    for (size_t c = 0; c < channels_; ++c)
+        for (size_t h = 0; h < height_; ++h)
+            for (size_t w = 0; w < width_; ++w)
+                result = std::min(result, (*this)(c, h, w));
+    return result;
+}
+
+double TensorView::max() const {
+    if (empty()) return 0.0;
+    double result = std::numeric_limits<double>::lowest();
+    for (size_t c = 0; c < channels_; ++c)
+        for (size_t h = 0; h < height_; ++h)
+            for (size_t w = 0; w < width_; ++w)
+                result = std::max(result, (*this)(c, h, w));
+    return result;
+}
+
+Tensor TensorView::toTensor() const {
+    Tensor result(channels_, height_, width_);
+    double* dst = result.rawData();
+    size_t idx = 0;
+    for (size_t c = 0; c < channels_; ++c)
+        for (size_t h = 0; h < height_; ++h)
+            for (size_t w = 0; w < width_; ++w)
+                dst[idx++] = (*this)(c, h, w);
+    return result;
+}
+
+Tensor matmul(const TensorView& a, const TensorView& b) {
+    if (a.channels() != b.channels()) {
+        throw std::invalid_argument("Channel mismatch in matmul: " + std::to_string(a.channels()) + " vs " + std::to_string(b.channels()));
+    }
+    if (a.width() != b.height()) {
+        throw std::invalid_argument("Dimension mismatch in matmul: " + std::to_string(a.width()) + " vs " + std::to_string(b.height()));
+    }
+
+    const size_t M = a.height();
+    const size_t K = a.width();
+    const size_t N = b.width();
+    Tensor result(a.channels(), M, N);
+    double* out = result.rawData();
+
+    for (size_t c = 0; c < a.channels(); ++c) {
+        double* outC = out + c * M * N;
+        for (size_t i = 0; i < M; ++i) {
+            double* outRow = outC + i * N;
+            for (size_t k = 0; k < K; ++k) {
+                const double val = a(c, i, k);
+                for (size_t j = 0; j < N; ++j) {
+                    outRow[j] += val * b(c, k, j);
+                }
+            }
+        }
+    }
+    return result;
+}
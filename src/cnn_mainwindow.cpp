@@ -3,7 +3,6 @@
 #include <QDateTime>
 #include <QMessageBox>
 #include <cmath>
-#include <random>
 #include <algorithm>
 
 CNNMainWindow::CNNMainWindow(QWidget* parent)
@@ -113,6 +112,16 @@ void CNNMainWindow::setupUI() {
     samplesLayout->addWidget(samplesSpinBox_);
     dataLayout->addLayout(samplesLayout);
 
+    QHBoxLayout* augmentLayout = new QHBoxLayout();
+    augmentLayout->addWidget(new QLabel("Augment:"));
+    augmentationEdit_ = new QLineEdit();
+    augmentationEdit_->setPlaceholderText("e.g. flip_h,shift=2,noise=0.05");
+    augmentationEdit_->setToolTip("Random augmentation applied to every sample while training:\n"
+                                  "flip_h[=p], flip_v[=p], rot90, shift[=pixels], crop[=min scale], noise[=stddev].\n"
+                                  "Leave empty to train on the original images.");
+    augmentLayout->addWidget(augmentationEdit_);
+    dataLayout->addLayout(augmentLayout);
+
     controlLayout->addWidget(dataGroup);
 
     // 训练参数
@@ -288,8 +297,10 @@ void CNNMainWindow::setupUI() {
     )");
 
     trainingThread_ = std::make_unique<CNNTrainingThread>(this);
-    connect(trainingThread_.get(), &CNNTrainingThread::epochCompleted, 
-            this, &CNNMainWindow::onEpochCompleted);
+    connect(trainingThread_.get(), &CNNTrainingThread::progressUpdated,
+            this, &CNNMainWindow::onProgressUpdated);
+    connect(trainingThread_.get(), &CNNTrainingThread::datasetReady,
+            this, &CNNMainWindow::onDatasetReady);
     connect(trainingThread_.get(), &CNNTrainingThread::trainingCompleted, 
             this, &CNNMainWindow::onTrainingCompleted);
     connect(trainingThread_.get(), &CNNTrainingThread::weightsUpdated, 
@@ -355,71 +366,15 @@ void CNNMainWindow::createNetwork() {
 }
 
 void CNNMainWindow::generateTrainingData() {
-    trainImages_.clear();
-    trainLabels_.clear();
-
     int inputSize = inputSizeSpinBox_->value();
     int numClasses = numClassesSpinBox_->value();
     int samplesPerClass = samplesSpinBox_->value();
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> posDist(0.2, 0.8);
-    std::uniform_real_distribution<> sizeDist(0.15, 0.35);
-    std::normal_distribution<> noiseDist(0.0, 0.05);
-
-    for (int c = 0; c < numClasses; ++c) {
-        for (int s = 0; s < samplesPerClass; ++s) {
-            Tensor image(1, inputSize, inputSize, 0.0);
-
-            double centerX = posDist(gen);
-            double centerY = posDist(gen);
-            double size = sizeDist(gen);
-
-            for (int y = 0; y < inputSize; ++y) {
-                for (int x = 0; x < inputSize; ++x) {
-                    double nx = static_cast<double>(x) / inputSize;
-                    double ny = static_cast<double>(y) / inputSize;
-                    double dx = nx - centerX;
-                    double dy = ny - centerY;
-
-                    double value = 0.0;
-
-                    switch (c % 3) {
-                        case 0: // 圆形
-                            if (std::sqrt(dx*dx + dy*dy) < size) {
-                                value = 1.0;
-                            }
-                            break;
-                        case 1: // 方形
-                            if (std::abs(dx) < size && std::abs(dy) < size) {
-                                value = 1.0;
-                            }
-                            break;
-                        case 2: // 十字形
-                            if ((std::abs(dx) < size/3 && std::abs(dy) < size) ||
-                                (std::abs(dy) < size/3 && std::abs(dx) < size)) {
-                                value = 1.0;
-                            }
-                            break;
-                    }
-
-                    value += noiseDist(gen);
-                    value = std::clamp(value, 0.0, 1.0);
-                    image(0, y, x) = value;
-                }
-            }
-
-            trainImages_.push_back(image);
-
-            std::vector<double> label(numClasses, 0.0);
-            label[c] = 1.0;
-            trainLabels_.push_back(label);
-        }
-    }
+    // 图像由训练线程在开始训练时并行合成，界面不会因生成数据而卡顿
+    trainingThread_->setShapeDataset(inputSize, numClasses, samplesPerClass);
 
-    log(QString("Generated %1 training samples (%2 classes)")
-        .arg(trainImages_.size()).arg(numClasses));
+    log(QString("Training data: %1 samples (%2 classes), generated when training starts")
+        .arg(numClasses * samplesPerClass).arg(numClasses));
 }
 
 void CNNMainWindow::onStartTraining() {
@@ -427,13 +382,22 @@ void CNNMainWindow::onStartTraining() {
         return;
     }
 
+    ImageAugmenter augmenter;
+    try {
+        augmenter = ImageAugmenter::fromSpec(augmentationEdit_->text().toStdString());
+    } catch (const std::invalid_argument& e) {
+        QMessageBox::warning(this, "Augmentation", QString::fromStdString(e.what()));
+        return;
+    }
+
     lossChart_->clear();
     totalEpochs_ = epochsSpinBox_->value();
+    currentEpoch_ = 0;
     double learningRate = learningRateSpinBox_->value();
 
     trainingThread_->setNetwork(cnnNetwork_.get());
-    trainingThread_->setTrainingData(trainImages_, trainLabels_);
     trainingThread_->setParameters(totalEpochs_, learningRate);
+    trainingThread_->setAugmentation(augmenter);
 
     startButton_->setEnabled(false);
     stopButton_->setEnabled(true);
@@ -441,20 +405,31 @@ void CNNMainWindow::onStartTraining() {
     buildButton_->setEnabled(false);
     resetButton_->setEnabled(false);
 
-    trainingThread_->start();
+    trainingThread_->startTraining();
 
     updateStatus("Training...");
-    log(QString("Training started: %1 epochs, LR=%2")
-        .arg(totalEpochs_).arg(learningRate));
+    log(QString("Training started: %1 epochs, LR=%2, augmentation: %3")
+        .arg(totalEpochs_).arg(learningRate).arg(QString::fromStdString(augmenter.spec())));
+}
+
+void CNNMainWindow::onDatasetReady(int samples, double seconds) {
+    log(QString("Generated %1 training samples in %2 ms")
+        .arg(samples).arg(seconds * 1000.0, 0, 'f', 1));
 }
 
-void CNNMainWindow::onEpochCompleted(int epoch, double loss) {
-    lossChart_->addDataPoint(epoch, loss);
+void CNNMainWindow::onProgressUpdated(const std::vector<LossPoint>& points) {
+    if (points.empty()) return;
+    const int previousEpoch = currentEpoch_;
+    const int epoch = points.back().epoch;
+    const double loss = points.back().loss;
+    currentEpoch_ = epoch;
+    lossChart_->addDataPoints(points);
 
     int progress = static_cast<int>(100.0 * epoch / totalEpochs_);
     progressBar_->setValue(progress);
 
-    if (epoch % 10 == 0) {
+    // 一批可能跨过多个轮次，跨过 10 的整数倍时记录最新一轮
+    if (epoch / 10 != previousEpoch / 10) {
         log(QString("Epoch %1/%2 - Loss: %3")
             .arg(epoch).arg(totalEpochs_).arg(loss, 0, 'f', 6));
     }
@@ -520,17 +495,18 @@ void CNNMainWindow::onResetNetwork() {
 void CNNMainWindow::onLayerClicked(int layerIndex) {
     if (!cnnNetwork_) return;
 
-    std::lock_guard<std::mutex> lock(cnnNetwork_->getMutex());
-    const auto& cnnLayers = cnnNetwork_->getCNNLayers();
+    std::shared_ptr<const CNNSnapshot> snapshot = cnnNetwork_->latestSnapshot();
+    if (!snapshot) return;
+    const auto& cnnLayers = snapshot->cnnLayers;
 
     int cnnLayerIndex = layerIndex - 1;
 
     if (cnnLayerIndex >= 0 && cnnLayerIndex < static_cast<int>(cnnLayers.size())) {
         const auto& layer = cnnLayers[cnnLayerIndex];
-        const Tensor& output = layer->getOutput();
+        const Tensor& output = layer.output;
 
         if (!output.empty()) {
-            QString layerName = QString::fromStdString(layer->name()) +
+            QString layerName = QString::fromStdString(layer.name) +
                                QString(" (Layer %1)").arg(cnnLayerIndex);
             featureMapView_->setFeatureMap(output, layerName);
             log(QString("Showing feature maps for %1").arg(layerName));
@@ -0,0 +1,310 @@
+#include "data_table.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+DataTable::DataTable(size_t rows, size_t featureCount, size_t targetCount)
+    : rows_(rows), featureCount_(featureCount), targetCount_(targetCount),
+      features_(rows * featureCount, 0.0), targets_(rows * targetCount, 0.0) {}
+
+DataTable DataTable::fromRows(const std::vector<std::vector<double>>& inputs,
+                              const std::vector<std::vector<double>>& targets) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("DataTable: inputs and targets have different row counts");
+    }
+    const size_t featureCount = inputs.empty() ? 0 : inputs.front().size();
+    const size_t targetCount = targets.empty() ? 0 : targets.front().size();
+    DataTable table(inputs.size(), featureCount, targetCount);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].size() != featureCount || targets[i].size() != targetCount) {
+            throw std::invalid_argument("DataTable: row " + std::to_string(i) + " has a different length");
+        }
+        std::copy(inputs[i].begin(), inputs[i].end(), table.features(i));
+        std::copy(targets[i].begin(), targets[i].end(), table.targets(i));
+    }
+    return table;
+}
+
+void DataTable::setColumnNames(std::vector<std::string> featureNames, std::vector<std::string> targetNames) {
+    featureNames_ = std::move(featureNames);
+    targetNames_ = std::move(targetNames);
+}
+
+DataTable::Standardization DataTable::standardize() {
+    Standardization result;
+    result.mean.assign(featureCount_, 0.0);
+    result.stddev.assign(featureCount_, 1.0);
+    if (rows_ == 0) return result;
+
+    // 两遍：先求均值，再求偏差平方和；E[x²] - mean² 在均值远大于离散程度时会相消殆尽
+    for (size_t r = 0; r < rows_; ++r) {
+        const double* row = features(r);
+        for (size_t c = 0; c < featureCount_; ++c) {
+            result.mean[c] += row[c];
+        }
+    }
+    const double n = static_cast<double>(rows_);
+    for (size_t c = 0; c < featureCount_; ++c) {
+        result.mean[c] /= n;
+    }
+    std::vector<double> squares(featureCount_, 0.0);
+    for (size_t r = 0; r < rows_; ++r) {
+        const double* row = features(r);
+        for (size_t c = 0; c < featureCount_; ++c) {
+            const double d = row[c] - result.mean[c];
+            squares[c] += d * d;
+        }
+    }
+    for (size_t c = 0; c < featureCount_; ++c) {
+        const double stddev = std::sqrt(squares[c] / n);
+        result.stddev[c] = stddev > 1e-12 ? stddev : 1.0;
+    }
+    applyStandardization(result);
+    return result;
+}
+
+void DataTable::applyStandardization(const Standardization& standardization) {
+    if (standardization.mean.size() != featureCount_ || standardization.stddev.size() != featureCount_) {
+        throw std::invalid_argument("DataTable: standardization has the wrong number of columns");
+    }
+    std::vector<double> inverse(featureCount_);
+    for (size_t c = 0; c < featureCount_; ++c) {
+        inverse[c] = 1.0 / standardization.stddev[c];
+    }
+    for (size_t r = 0; r < rows_; ++r) {
+        double* row = features(r);
+        for (size_t c = 0; c < featureCount_; ++c) {
+            row[c] = (row[c] - standardization.mean[c]) * inverse[c];
+        }
+    }
+}
+
+// ==================== CSV ====================
+
+namespace {
+
+const size_t kMinChunkBytes = 64 * 1024; // 小于此大小的块不值得再拆分
+
+bool isBlank(const char* begin, const char* end) {
+    for (const char* p = begin; p != end; ++p) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+    }
+    return true;
+}
+
+// 依次调用 fn(lineBegin, lineEnd)，lineEnd 不含换行与行尾的 '\r'
+template <typename Fn>
+void forEachLine(const char* begin, const char* end, Fn&& fn) {
+    const char* line = begin;
+    while (line < end) {
+        const char* newline = std::find(line, end, '\n');
+        const char* lineEnd = newline;
+        if (lineEnd > line && lineEnd[-1] == '\r') --lineEnd;
+        fn(line, lineEnd);
+        line = newline == end ? end : newline + 1;
+    }
+}
+
+// 去掉首尾空白与包围字段的双引号
+void trimField(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+    if (end - begin >= 2 && *begin == '"' && end[-1] == '"') {
+        ++begin;
+        --end;
+    }
+}
+
+std::vector<std::string> splitHeader(const char* begin, const char* end, char delimiter) {
+    std::vector<std::string> names;
+    const char* field = begin;
+    while (true) {
+        const char* fieldEnd = std::find(field, end, delimiter);
+        const char* b = field;
+        const char* e = fieldEnd;
+        trimField(b, e);
+        names.emplace_back(b, e);
+        if (fieldEnd == end) break;
+        field = fieldEnd + 1;
+    }
+    return names;
+}
+
+[[noreturn]] void csvError(size_t line, size_t column, const std::string& message) {
+    throw std::runtime_error("CSV line " + std::to_string(line) + ", column " + std::to_string(column) +
+                             ": " + message);
+}
+
+} // namespace
+
+DataTable parseCsv(const std::string& text, const CsvOptions& options) {
+    const char* const textBegin = text.data();
+    const char* const textEnd = text.data() + text.size();
+
+    // 表头（或第一行数据）决定列数
+    const char* body = textBegin;
+    size_t headerLines = 0;
+    std::vector<std::string> columnNames;
+    size_t columnCount = 0;
+    while (body < textEnd) {
+        const char* newline = std::find(body, textEnd, '\n');
+        const char* lineEnd = newline;
+        if (lineEnd > body && lineEnd[-1] == '\r') --lineEnd;
+        if (!isBlank(body, lineEnd)) {
+            columnNames = splitHeader(body, lineEnd, options.delimiter);
+            columnCount = columnNames.size();
+            if (options.hasHeader) {
+                ++headerLines;
+                body = newline == textEnd ? textEnd : newline + 1;
+            } else {
+                columnNames.clear();
+            }
+            break;
+        }
+        ++headerLines;
+        body = newline == textEnd ? textEnd : newline + 1;
+    }
+    if (columnCount == 0) {
+        throw std::runtime_error("CSV has no columns");
+    }
+
+    // 每列的去向：>= 0 为特征下标，< 0 为 -(目标下标 + 1)
+    std::vector<long> slot(columnCount, 0);
+    std::vector<size_t> targetColumns;
+    if (!options.targetColumns.empty()) {
+        if (!options.hasHeader) {
+            throw std::invalid_argument("CSV target columns by name need a header");
+        }
+        for (const std::string& name : options.targetColumns) {
+            auto it = std::find(columnNames.begin(), columnNames.end(), name);
+            if (it == columnNames.end()) {
+                throw std::invalid_argument("CSV has no column named '" + name + "'");
+            }
+            targetColumns.push_back(static_cast<size_t>(it - columnNames.begin()));
+        }
+    } else {
+        if (options.targetCount >= columnCount) {
+            throw std::invalid_argument("CSV needs at least one feature column besides the targets");
+        }
+        for (size_t t = 0; t < options.targetCount; ++t) {
+            targetColumns.push_back(columnCount - options.targetCount + t);
+        }
+    }
+    std::vector<bool> isTarget(columnCount, false);
+    for (size_t t = 0; t < targetColumns.size(); ++t) {
+        if (isTarget[targetColumns[t]]) {
+            throw std::invalid_argument("CSV target column listed twice");
+        }
+        isTarget[targetColumns[t]] = true;
+        slot[targetColumns[t]] = -static_cast<long>(t) - 1;
+    }
+    std::vector<std::string> featureNames;
+    std::vector<std::string> targetNames(targetColumns.size());
+    long nextFeature = 0;
+    for (size_t c = 0; c < columnCount; ++c) {
+        if (!isTarget[c]) {
+            slot[c] = nextFeature++;
+            if (!columnNames.empty()) featureNames.push_back(columnNames[c]);
+        } else if (!columnNames.empty()) {
+            targetNames[static_cast<size_t>(-slot[c] - 1)] = columnNames[c];
+        }
+    }
+    const size_t featureCount = static_cast<size_t>(nextFeature);
+    const size_t targetCount = targetColumns.size();
+
+    // 按换行切块：块边界总在某行开头
+    ThreadPool& pool = ThreadPool::global();
+    const size_t bodySize = static_cast<size_t>(textEnd - body);
+    const size_t maxChunks = 4 * (pool.workerCount() + 1);
+    const size_t numChunks = std::max<size_t>(1, std::min(maxChunks, bodySize / kMinChunkBytes));
+    std::vector<const char*> bounds(numChunks + 1, textEnd);
+    bounds[0] = body;
+    for (size_t c = 1; c < numChunks; ++c) {
+        const char* guess = std::max(bounds[c - 1], body + bodySize * c / numChunks);
+        const char* newline = std::find(guess, textEnd, '\n');
+        bounds[c] = newline == textEnd ? textEnd : newline + 1;
+    }
+
+    // 第一遍：每块的数据行数与物理行数
+    std::vector<size_t> chunkRows(numChunks, 0);
+    std::vector<size_t> chunkLines(numChunks, 0);
+    pool.parallelFor(numChunks, [&](size_t c) {
+        forEachLine(bounds[c], bounds[c + 1], [&](const char* begin, const char* end) {
+            ++chunkLines[c];
+            if (!isBlank(begin, end)) ++chunkRows[c];
+        });
+    });
+
+    std::vector<size_t> firstRow(numChunks, 0);
+    std::vector<size_t> firstLine(numChunks, headerLines + 1);
+    for (size_t c = 1; c < numChunks; ++c) {
+        firstRow[c] = firstRow[c - 1] + chunkRows[c - 1];
+        firstLine[c] = firstLine[c - 1] + chunkLines[c - 1];
+    }
+    const size_t rows = firstRow.back() + chunkRows.back();
+
+    // 第二遍：各块并行解析到连续矩阵中的对应行
+    DataTable table(rows, featureCount, targetCount);
+    pool.parallelFor(numChunks, [&](size_t c) {
+        size_t row = firstRow[c];
+        size_t line = firstLine[c];
+        forEachLine(bounds[c], bounds[c + 1], [&](const char* begin, const char* end) {
+            if (isBlank(begin, end)) {
+                ++line;
+                return;
+            }
+            double* features = table.features(row);
+            double* targets = table.targets(row);
+            const char* field = begin;
+            for (size_t col = 0; col < columnCount; ++col) {
+                if (field > end) {
+                    csvError(line, col + 1, "expected " + std::to_string(columnCount) + " fields");
+                }
+                const char* fieldEnd = std::find(field, end, options.delimiter);
+                const char* b = field;
+                const char* e = fieldEnd;
+                trimField(b, e);
+                if (b < e && *b == '+') ++b;
+                if (b == e) {
+                    csvError(line, col + 1, "missing value");
+                }
+                double value = 0.0;
+                const auto parsed = std::from_chars(b, e, value);
+                if (parsed.ec != std::errc() || parsed.ptr != e) {
+                    csvError(line, col + 1, "not a number: '" + std::string(b, e) + "'");
+                }
+                if (slot[col] >= 0) {
+                    features[slot[col]] = value;
+                } else {
+                    targets[-slot[col] - 1] = value;
+                }
+                field = fieldEnd + 1;
+            }
+            if (field <= end) {
+                csvError(line, columnCount + 1, "more than " + std::to_string(columnCount) + " fields");
+            }
+            ++row;
+            ++line;
+        });
+    });
+
+    table.setColumnNames(std::move(featureNames), std::move(targetNames));
+    if (options.standardize) {
+        table.standardize();
+    }
+    return table;
+}
+
+DataTable loadCsv(const std::string& path, const CsvOptions& options) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open CSV file: " + path);
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return parseCsv(contents.str(), options);
+}
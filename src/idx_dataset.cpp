@@ -0,0 +1,278 @@
+#include "idx_dataset.h"
+#include "mapped_dataset.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const size_t kChunkSize = 256;         // 每个并行任务处理的样本数
+const size_t kPixelChunk = 1 << 16;    // 统计均值/方差时每个并行任务处理的像素数
+
+struct IdxHeader {
+    std::vector<size_t> dims;
+    size_t dataOffset = 0;
+    size_t count() const { return dims.empty() ? 0 : dims[0]; }
+    size_t itemSize() const {
+        size_t size = 1;
+        for (size_t i = 1; i < dims.size(); ++i) size *= dims[i];
+        return size;
+    }
+};
+
+uint32_t readBigEndian(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+IdxHeader readIdxHeader(std::ifstream& in, const std::string& path, size_t expectedDims) {
+    unsigned char magic[4] = {0, 0, 0, 0};
+    if (!in.read(reinterpret_cast<char*>(magic), 4)) {
+        throw std::runtime_error("IDX file too small: " + path);
+    }
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        throw std::runtime_error("IDX file is gzip-compressed, decompress it first: " + path);
+    }
+    if (magic[0] != 0 || magic[1] != 0) {
+        throw std::runtime_error("Not an IDX file: " + path);
+    }
+    if (magic[2] != 0x08) {
+        throw std::runtime_error("Unsupported IDX element type (only unsigned byte): " + path);
+    }
+    if (magic[3] != expectedDims) {
+        throw std::runtime_error("IDX file " + path + " has " + std::to_string(magic[3]) +
+                                 " dimensions, expected " + std::to_string(expectedDims));
+    }
+
+    IdxHeader header;
+    for (size_t i = 0; i < expectedDims; ++i) {
+        unsigned char dim[4];
+        if (!in.read(reinterpret_cast<char*>(dim), 4)) {
+            throw std::runtime_error("Truncated IDX header: " + path);
+        }
+        header.dims.push_back(readBigEndian(dim));
+    }
+    header.dataOffset = 4 + 4 * expectedDims;
+    return header;
+}
+
+IdxHeader readIdxHeader(const std::string& path, size_t expectedDims) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open IDX file: " + path);
+    }
+    return readIdxHeader(in, path, expectedDims);
+}
+
+// 读取头部与前 count 个条目的原始字节
+std::vector<unsigned char> readIdxData(const std::string& path, size_t expectedDims, size_t count,
+                                       IdxHeader& header) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open IDX file: " + path);
+    }
+    header = readIdxHeader(in, path, expectedDims);
+    std::vector<unsigned char> bytes(count * header.itemSize());
+    if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error("Truncated IDX data: " + path);
+    }
+    return bytes;
+}
+
+size_t sampleCount(const IdxHeader& images, const IdxHeader& labels, size_t limit) {
+    if (images.count() != labels.count()) {
+        throw std::runtime_error("IDX image/label count mismatch: " + std::to_string(images.count()) +
+                                 " vs " + std::to_string(labels.count()));
+    }
+    return limit > 0 ? std::min(limit, images.count()) : images.count();
+}
+
+// "IDX" + 预处理方式；显式给定统计量时为其哈希（低字节 0x80），统计量不同的缓存不会被误用
+uint32_t cacheTag(const IdxLoadOptions& options) {
+    if (!options.useStatistics) {
+        return 0x49445800u | (static_cast<uint32_t>(options.normalization) + 1);
+    }
+    unsigned char bytes[2 * sizeof(double)];
+    std::memcpy(bytes, &options.statistics.offset, sizeof(double));
+    std::memcpy(bytes + sizeof(double), &options.statistics.scale, sizeof(double));
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (unsigned char b : bytes) {
+        hash = (hash ^ b) * 16777619u;
+    }
+    return (hash & 0xffffff00u) | 0x80u;
+}
+
+// 按 options 确定归一化参数；Standardize 先求均值，再求偏差平方和（两遍，避免 E[x²] - mean² 的相消）
+IdxStatistics resolveStatistics(const IdxLoadOptions& options, const std::vector<unsigned char>& pixels) {
+    if (options.useStatistics) return options.statistics;
+    IdxStatistics statistics;
+    if (options.normalization == IdxNormalization::UnitRange) {
+        statistics.scale = 1.0 / 255.0;
+    } else if (options.normalization == IdxNormalization::Standardize && !pixels.empty()) {
+        const size_t chunks = (pixels.size() + kPixelChunk - 1) / kPixelChunk;
+        std::vector<double> partial(chunks, 0.0);
+        auto reduce = [&](auto term) {
+            ThreadPool::global().parallelFor(chunks, [&](size_t c) {
+                const size_t end = std::min(pixels.size(), (c + 1) * kPixelChunk);
+                double sum = 0.0;
+                for (size_t i = c * kPixelChunk; i < end; ++i) sum += term(static_cast<double>(pixels[i]));
+                partial[c] = sum;
+            });
+            double total = 0.0;
+            for (double p : partial) total += p;
+            return total;
+        };
+        const double n = static_cast<double>(pixels.size());
+        const double mean = reduce([](double x) { return x; }) / n;
+        const double variance = reduce([mean](double x) { return (x - mean) * (x - mean); }) / n;
+        statistics.offset = mean;
+        statistics.scale = variance > 0.0 ? 1.0 / std::sqrt(variance) : 1.0;
+    }
+    return statistics;
+}
+
+// 缓存命中时的归一化参数：按自身统计的 Standardize 需重新读取源像素
+IdxStatistics sourceStatistics(const std::string& imagesPath, const IdxLoadOptions& options, size_t count) {
+    if (options.useStatistics || options.normalization != IdxNormalization::Standardize) {
+        return resolveStatistics(options, {});
+    }
+    IdxHeader header;
+    return resolveStatistics(options, readIdxData(imagesPath, 3, count, header));
+}
+
+bool cacheUsable(const std::string& cachePath, const std::string& imagesPath,
+                 const std::string& labelsPath, const IdxLoadOptions& options,
+                 const IdxHeader& images, size_t count) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::exists(cachePath, ec)) return false;
+    const auto cacheTime = fs::last_write_time(cachePath, ec);
+    if (ec) return false;
+    if (cacheTime < fs::last_write_time(imagesPath, ec) || ec) return false;
+    if (cacheTime < fs::last_write_time(labelsPath, ec) || ec) return false;
+
+    try {
+        MappedDataset cache(cachePath);
+        return cache.tag() == cacheTag(options) && cache.size() == count &&
+               cache.channels() == 1 && cache.height() == images.dims[1] && cache.width() == images.dims[2];
+    } catch (const std::exception&) {
+        return false; // 损坏或格式不符的缓存视为不存在
+    }
+}
+
+IdxDataset decodeIdx(const std::string& imagesPath, const std::string& labelsPath,
+                     const IdxLoadOptions& options) {
+    IdxHeader imageHeader = readIdxHeader(imagesPath, 3);
+    IdxHeader labelHeader = readIdxHeader(labelsPath, 1);
+    const size_t count = sampleCount(imageHeader, labelHeader, options.limit);
+
+    const std::vector<unsigned char> pixels = readIdxData(imagesPath, 3, count, imageHeader);
+    const std::vector<unsigned char> rawLabels = readIdxData(labelsPath, 1, count, labelHeader);
+
+    const size_t rows = imageHeader.dims[1];
+    const size_t cols = imageHeader.dims[2];
+    const size_t pixelsPerImage = rows * cols;
+    const size_t chunks = (count + kChunkSize - 1) / kChunkSize;
+    ThreadPool& pool = ThreadPool::global();
+
+    IdxDataset dataset;
+    dataset.statistics = resolveStatistics(options, pixels);
+    const double offset = dataset.statistics.offset;
+    const double scale = dataset.statistics.scale;
+
+    unsigned char maxLabel = 0;
+    for (unsigned char label : rawLabels) maxLabel = std::max(maxLabel, label);
+    dataset.numClasses = std::max<size_t>(2, static_cast<size_t>(maxLabel) + 1);
+
+    dataset.images.resize(count);
+    dataset.labels.resize(count);
+    pool.parallelFor(chunks, [&](size_t c) {
+        const size_t end = std::min(count, (c + 1) * kChunkSize);
+        for (size_t i = c * kChunkSize; i < end; ++i) {
+            Tensor image(1, rows, cols);
+            double* dst = image.rawData();
+            const unsigned char* src = pixels.data() + i * pixelsPerImage;
+            for (size_t k = 0; k < pixelsPerImage; ++k) {
+                dst[k] = (static_cast<double>(src[k]) - offset) * scale;
+            }
+            dataset.images[i] = std::move(image);
+
+            dataset.labels[i].assign(dataset.numClasses, 0.0);
+            dataset.labels[i][rawLabels[i]] = 1.0;
+        }
+    });
+    return dataset;
+}
+
+void writeCache(const std::string& cachePath, const IdxDataset& dataset, const IdxLoadOptions& options) {
+    if (dataset.images.empty()) {
+        throw std::runtime_error("Cannot cache an empty IDX dataset");
+    }
+    const Tensor& first = dataset.images.front();
+    DatasetWriter writer(cachePath, first.channels(), first.height(), first.width(), dataset.numClasses);
+    writer.setTag(cacheTag(options));
+    for (size_t i = 0; i < dataset.images.size(); ++i) {
+        writer.append(dataset.images[i], dataset.labels[i]);
+    }
+    writer.finish();
+}
+
+} // namespace
+
+IdxNormalization idxNormalizationFromName(const std::string& name) {
+    if (name == "none") return IdxNormalization::None;
+    if (name == "unit") return IdxNormalization::UnitRange;
+    if (name == "standardize") return IdxNormalization::Standardize;
+    throw std::invalid_argument("Unknown IDX normalization: " + name + " (expected none, unit or standardize)");
+}
+
+IdxDataset loadIdxDataset(const std::string& imagesPath, const std::string& labelsPath,
+                          const IdxLoadOptions& options) {
+    if (!options.cachePath.empty()) {
+        const IdxHeader imageHeader = readIdxHeader(imagesPath, 3);
+        const size_t count = sampleCount(imageHeader, readIdxHeader(labelsPath, 1), options.limit);
+        if (cacheUsable(options.cachePath, imagesPath, labelsPath, options, imageHeader, count)) {
+            MappedDataset cache(options.cachePath);
+            IdxDataset dataset;
+            dataset.numClasses = cache.labelSize();
+            dataset.statistics = sourceStatistics(imagesPath, options, count);
+            dataset.fromCache = true;
+            dataset.images.resize(count);
+            dataset.labels.resize(count);
+            ThreadPool::global().parallelFor((count + kChunkSize - 1) / kChunkSize, [&](size_t c) {
+                const size_t end = std::min(count, (c + 1) * kChunkSize);
+                for (size_t i = c * kChunkSize; i < end; ++i) {
+                    dataset.images[i] = cache.sample(i).toTensor();
+                    dataset.labels[i].assign(cache.label(i), cache.label(i) + cache.labelSize());
+                }
+            });
+            return dataset;
+        }
+    }
+
+    IdxDataset dataset = decodeIdx(imagesPath, labelsPath, options);
+    if (!options.cachePath.empty()) {
+        writeCache(options.cachePath, dataset, options);
+    }
+    return dataset;
+}
+
+std::string buildIdxCache(const std::string& imagesPath, const std::string& labelsPath,
+                          const IdxLoadOptions& options, IdxStatistics* statistics) {
+    if (options.cachePath.empty()) {
+        throw std::invalid_argument("buildIdxCache needs a cache path");
+    }
+    const IdxHeader imageHeader = readIdxHeader(imagesPath, 3);
+    const size_t count = sampleCount(imageHeader, readIdxHeader(labelsPath, 1), options.limit);
+    if (!cacheUsable(options.cachePath, imagesPath, labelsPath, options, imageHeader, count)) {
+        const IdxDataset dataset = decodeIdx(imagesPath, labelsPath, options);
+        writeCache(options.cachePath, dataset, options);
+        if (statistics) *statistics = dataset.statistics;
+    } else if (statistics) {
+        *statistics = sourceStatistics(imagesPath, options, count);
+    }
+    return options.cachePath;
+}
@@ -18,6 +18,23 @@ void LossChart::addDataPoint(int epoch, double loss) {
         dataPoints_.pop_front();
     }
 
+    updateRange();
+    update();
+}
+
+void LossChart::addDataPoints(const std::vector<LossPoint>& points) {
+    for (const LossPoint& point : points) {
+        dataPoints_.push_back({point.epoch, point.loss});
+    }
+    while (static_cast<int>(dataPoints_.size()) > maxPoints_) {
+        dataPoints_.pop_front();
+    }
+
+    updateRange();
+    update();
+}
+
+void LossChart::updateRange() {
     // 更新最大最小损失值
     if (!dataPoints_.empty()) {
         maxLoss_ = 0.0;
@@ -32,8 +49,6 @@ void LossChart::addDataPoint(int epoch, double loss) {
         maxLoss_ += range * 0.1;
         minLoss_ = std::max(0.0, minLoss_ - range * 0.1);
     }
-
-    update();
 }
 
 void LossChart::clear() {
@@ -1,7 +1,12 @@
 #include "mainwindow.h"
+#include "synthetic_datasets.h"
+#include "cnn/random.h"
 #include <QSplitter>
 #include <QScrollArea>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSignalBlocker>
 #include <cmath>
 
 MainWindow::MainWindow(QWidget* parent)
@@ -15,8 +20,8 @@ MainWindow::MainWindow(QWidget* parent)
     setMinimumSize(1200, 800);
 
     setupUI();
-    createNetwork();
     loadDataset(0);
+    createNetwork();
 }
 
 MainWindow::~MainWindow() {
@@ -45,6 +50,7 @@ void MainWindow::setupUI() {
     datasetComboBox_->addItem("AND Gate");
     datasetComboBox_->addItem("OR Gate");
     datasetComboBox_->addItem("Circle Classification");
+    datasetComboBox_->addItem("CSV File...");
     datasetComboBox_->setToolTip("Select a dataset to train the network on.");
     connect(datasetComboBox_, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onDatasetChanged, Qt::QueuedConnection);
@@ -248,8 +254,9 @@ void MainWindow::setupUI() {
 void MainWindow::createNetwork() {
     network_ = std::make_unique<NeuralNetwork>();
 
-    int inputSize = 2; // 根据数据集
-    int outputSize = 1;
+    // 根据数据集
+    int inputSize = trainData_.empty() ? 2 : static_cast<int>(trainData_.featureCount());
+    int outputSize = trainData_.empty() ? 1 : static_cast<int>(trainData_.targetCount());
 
     network_->setInputSize(inputSize);
 
@@ -282,44 +289,49 @@ void MainWindow::createNetwork() {
             .arg(inputSize).arg(hiddenLayers).arg(neuronsPerLayer).arg(outputSize));
 }
 
-void MainWindow::loadDataset(int datasetIndex) {
-    trainInputs_.clear();
-    trainTargets_.clear();
-
-    switch (datasetIndex) {
-        case 0:
-            trainInputs_ = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
-            trainTargets_ = {{0}, {1}, {1}, {0}};
-            log("Loaded XOR dataset");
-            break;
-
-        case 1:
-            trainInputs_ = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
-            trainTargets_ = {{0}, {0}, {0}, {1}};
-            log("Loaded AND dataset");
-            break;
-
-        case 2:
-            trainInputs_ = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
-            trainTargets_ = {{0}, {1}, {1}, {1}};
-            log("Loaded OR dataset");
-            break;
+bool MainWindow::loadDataset(int datasetIndex) {
+    static const TabularDataset datasets[] = {
+        TabularDataset::XOR, TabularDataset::AND, TabularDataset::OR, TabularDataset::Circle
+    };
+    static const char* const names[] = {
+        "XOR dataset", "AND dataset", "OR dataset", "Circle classification dataset (100 samples)"
+    };
+    if (datasetIndex == 4) return loadCsvDataset();
+    if (datasetIndex < 0 || datasetIndex > 3) return false;
+
+    TabularData data = makeTabularDataset(datasets[datasetIndex], getRng());
+    trainData_ = DataTable::fromRows(data.inputs, data.targets);
+    log(QString("Loaded %1").arg(names[datasetIndex]));
+    return true;
+}
 
-        case 3:
-            for (int i = 0; i < 100; ++i) {
-                double x = static_cast<double>(rand()) / RAND_MAX * 2.0 - 1.0;
-                double y = static_cast<double>(rand()) / RAND_MAX * 2.0 - 1.0;
-                double dist = std::sqrt(x * x + y * y);
-                trainInputs_.push_back({(x + 1.0) / 2.0, (y + 1.0) / 2.0});
-                trainTargets_.push_back({dist < 0.5 ? 1.0 : 0.0});
-            }
-            log("Loaded Circle classification dataset (100 samples)");
-            break;
+bool MainWindow::loadCsvDataset() {
+    const QString path = QFileDialog::getOpenFileName(this, "Open CSV Dataset", QString(),
+                                                      "CSV files (*.csv);;All files (*)");
+    if (path.isEmpty()) return false;
+
+    // 最后一列为目标，特征标准化后训练
+    CsvOptions options;
+    options.standardize = true;
+    try {
+        trainData_ = loadCsv(path.toStdString(), options);
+    } catch (const std::exception& e) {
+        QMessageBox::warning(this, "CSV Error", QString::fromStdString(e.what()));
+        log(QString("Failed to load %1: %2").arg(path, QString::fromStdString(e.what())));
+        return false;
     }
+    log(QString("Loaded %1 (%2 rows, %3 features, %4 targets)")
+            .arg(path).arg(trainData_.rows()).arg(trainData_.featureCount()).arg(trainData_.targetCount()));
+    return true;
 }
 
 void MainWindow::onDatasetChanged(int index) {
-    loadDataset(index);
+    if (!loadDataset(index)) {
+        QSignalBlocker blocker(datasetComboBox_);
+        datasetComboBox_->setCurrentIndex(datasetIndex_);
+        return;
+    }
+    datasetIndex_ = index;
     onResetNetwork();
 }
 
@@ -334,17 +346,17 @@ void MainWindow::onStartTraining() {
 
     trainingThread_ = std::make_unique<TrainingThread>();
     trainingThread_->setNetwork(network_.get());
-    trainingThread_->setTrainingData(trainInputs_, trainTargets_);
+    trainingThread_->setTrainingData(trainData_);
     trainingThread_->setParameters(totalEpochs_, learningRateSpinBox_->value());
 
-    connect(trainingThread_.get(), &TrainingThread::epochCompleted,
-            this, &MainWindow::onEpochCompleted, Qt::QueuedConnection);
+    connect(trainingThread_.get(), &TrainingThread::progressUpdated,
+            this, &MainWindow::onProgressUpdated, Qt::QueuedConnection);
     connect(trainingThread_.get(), &TrainingThread::trainingCompleted,
             this, &MainWindow::onTrainingCompleted, Qt::QueuedConnection);
     connect(trainingThread_.get(), &TrainingThread::weightsUpdated,
             this, &MainWindow::onWeightsUpdated, Qt::QueuedConnection);
 
-    trainingThread_->start();
+    trainingThread_->startTraining();
 
     startButton_->setEnabled(false);
     stopButton_->setEnabled(true);
@@ -398,14 +410,19 @@ void MainWindow::onResetNetwork() {
     log("Network reset");
 }
 
-void MainWindow::onEpochCompleted(int epoch, double loss) {
+void MainWindow::onProgressUpdated(const std::vector<LossPoint>& points) {
+    if (points.empty()) return;
+    const int previousEpoch = currentEpoch_;
+    const int epoch = points.back().epoch;
+    const double loss = points.back().loss;
     currentEpoch_ = epoch;
-    lossChart_->addDataPoint(epoch, loss);
+    lossChart_->addDataPoints(points);
 
     int progress = static_cast<int>(100.0 * epoch / totalEpochs_);
     progressBar_->setValue(progress);
 
-    if (epoch % 100 == 0 || epoch == totalEpochs_) {
+    // 一批可能跨过多个轮次，跨过 100 的整数倍时记录最新一轮
+    if (epoch / 100 != previousEpoch / 100 || epoch == totalEpochs_) {
         log(QString("Epoch %1/%2 - Loss: %3")
                 .arg(epoch).arg(totalEpochs_).arg(loss, 0, 'f', 6));
     }
@@ -424,16 +441,17 @@ void MainWindow::onTrainingCompleted() {
 
     // 测试结果
     log("--- Test Results ---");
-    for (size_t i = 0; i < trainInputs_.size() && i < 10; ++i) {
-        auto output = network_->forward(trainInputs_[i]);
+    for (size_t i = 0; i < trainData_.rows() && i < 10; ++i) {
+        const double* features = trainData_.features(i);
+        auto output = network_->forward(std::vector<double>(features, features + trainData_.featureCount()));
         QString inputStr;
-        for (double v : trainInputs_[i]) {
-            inputStr += QString::number(v, 'f', 2) + " ";
+        for (size_t k = 0; k < trainData_.featureCount(); ++k) {
+            inputStr += QString::number(features[k], 'f', 2) + " ";
         }
         log(QString("Input: [%1] -> Output: %2 (Expected: %3)")
                 .arg(inputStr.trimmed())
                 .arg(output[0], 0, 'f', 4)
-                .arg(trainTargets_[i][0], 0, 'f', 1));
+                .arg(trainData_.targets(i)[0], 0, 'f', 1));
     }
 }
 
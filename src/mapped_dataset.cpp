@@ -0,0 +1,308 @@
+#include "mapped_dataset.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'N', 'N', 'D', 'S', 'E', 'T', '\0', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kByteOrder = 0x01020304;
+const uint64_t kAlignment = 64;
+
+uint64_t alignUp(uint64_t value) {
+    return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+} // namespace
+
+// ==================== DatasetWriter ====================
+
+DatasetWriter::DatasetWriter(const std::string& path, size_t channels, size_t height, size_t width,
+                             size_t labelSize)
+    : path_(path), file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_) {
+        throw std::runtime_error("Cannot create dataset file: " + path);
+    }
+    if (channels == 0 || height == 0 || width == 0) {
+        throw std::invalid_argument("Dataset sample shape must be non-empty");
+    }
+
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+    header_.version = kVersion;
+    header_.byteOrder = kByteOrder;
+    header_.channels = static_cast<uint32_t>(channels);
+    header_.height = static_cast<uint32_t>(height);
+    header_.width = static_cast<uint32_t>(width);
+    header_.labelSize = static_cast<uint32_t>(labelSize);
+    header_.samplesOffset = alignUp(sizeof(DatasetFileHeader));
+
+    // 先写占位文件头，finish() 时回填样本数与标签区偏移
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    const std::vector<char> padding(header_.samplesOffset - sizeof(header_), 0);
+    file_.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+}
+
+DatasetWriter::~DatasetWriter() {
+    if (!finished_) {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+}
+
+void DatasetWriter::append(const TensorView& sample, const std::vector<double>& label) {
+    if (finished_) {
+        throw std::runtime_error("DatasetWriter: append after finish");
+    }
+    if (sample.channels() != header_.channels || sample.height() != header_.height ||
+        sample.width() != header_.width) {
+        throw std::invalid_argument("DatasetWriter: sample shape mismatch");
+    }
+    if (label.size() != header_.labelSize) {
+        throw std::invalid_argument("DatasetWriter: label size mismatch");
+    }
+
+    const double* data = nullptr;
+    if (sample.isContiguous()) {
+        data = &sample(0, 0, 0);
+    } else {
+        buffer_.resize(sample.size());
+        size_t idx = 0;
+        for (size_t c = 0; c < sample.channels(); ++c)
+            for (size_t h = 0; h < sample.height(); ++h)
+                for (size_t w = 0; w < sample.width(); ++w)
+                    buffer_[idx++] = sample(c, h, w);
+        data = buffer_.data();
+    }
+
+    file_.write(reinterpret_cast<const char*>(data),
+                static_cast<std::streamsize>(sample.size() * sizeof(double)));
+    labels_.insert(labels_.end(), label.begin(), label.end());
+    ++count_;
+}
+
+void DatasetWriter::finish() {
+    if (finished_) return;
+    finished_ = true;
+
+    const uint64_t sampleBytes = static_cast<uint64_t>(header_.channels) * header_.height *
+                                 header_.width * sizeof(double);
+    const uint64_t samplesEnd = header_.samplesOffset + count_ * sampleBytes;
+    header_.sampleCount = count_;
+    header_.labelsOffset = alignUp(samplesEnd);
+
+    const std::vector<char> padding(header_.labelsOffset - samplesEnd, 0);
+    file_.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    file_.write(reinterpret_cast<const char*>(labels_.data()),
+                static_cast<std::streamsize>(labels_.size() * sizeof(double)));
+
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    file_.close();
+    if (!file_) {
+        throw std::runtime_error("Failed to write dataset file: " + path_);
+    }
+    labels_.clear();
+    labels_.shrink_to_fit();
+}
+
+// ==================== MappedDataset ====================
+
+MappedDataset::MappedDataset(const std::string& path) {
+    uint64_t fileSize = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open dataset file: " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot stat dataset file: " + path);
+    }
+    fileSize = static_cast<uint64_t>(size.QuadPart);
+    if (fileSize < sizeof(DatasetFileHeader)) {
+        CloseHandle(file);
+        throw std::runtime_error("Dataset file too small: " + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Cannot map dataset file: " + path);
+    }
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    base_ = static_cast<const unsigned char*>(view);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open dataset file: " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat dataset file: " + path);
+    }
+    fileSize = static_cast<uint64_t>(st.st_size);
+    if (fileSize < sizeof(DatasetFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Dataset file too small: " + path);
+    }
+    void* view = ::mmap(nullptr, static_cast<size_t>(fileSize), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射建立后不再需要文件描述符
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Cannot map dataset file: " + path);
+    }
+    base_ = static_cast<const unsigned char*>(view);
+#endif
+    mappedBytes_ = static_cast<size_t>(fileSize);
+
+    std::memcpy(&header_, base_, sizeof(header_));
+    std::string error;
+    if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not a dataset file";
+    } else if (header_.byteOrder != kByteOrder) {
+        error = "byte order mismatch";
+    } else if (header_.version != kVersion) {
+        error = "unsupported version " + std::to_string(header_.version);
+    } else if (header_.samplesOffset % kAlignment != 0 || header_.labelsOffset % kAlignment != 0) {
+        error = "misaligned data sections";
+    } else {
+        const uint64_t sampleBytes = static_cast<uint64_t>(sampleSize()) * sizeof(double);
+        const uint64_t labelBytes = static_cast<uint64_t>(labelSize()) * sizeof(double);
+        const uint64_t n = header_.sampleCount;
+        const bool samplesFit = header_.samplesOffset >= sizeof(DatasetFileHeader) &&
+                                header_.samplesOffset <= fileSize &&
+                                (sampleBytes == 0 || n <= (fileSize - header_.samplesOffset) / sampleBytes) &&
+                                header_.samplesOffset + n * sampleBytes <= header_.labelsOffset;
+        const bool labelsFit = header_.labelsOffset <= fileSize &&
+                               (labelBytes == 0 || n <= (fileSize - header_.labelsOffset) / labelBytes);
+        if (sampleBytes == 0 || !samplesFit || !labelsFit) {
+            error = "truncated or corrupt file";
+        }
+    }
+    if (!error.empty()) {
+        unmap();
+        throw std::runtime_error("Invalid dataset file " + path + ": " + error);
+    }
+}
+
+MappedDataset::~MappedDataset() {
+    unmap();
+}
+
+void MappedDataset::unmap() {
+    if (!base_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    CloseHandle(static_cast<HANDLE>(fileHandle_));
+#else
+    ::munmap(const_cast<unsigned char*>(base_), mappedBytes_);
+#endif
+    base_ = nullptr;
+}
+
+void MappedDataset::checkIndex(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Dataset index " + std::to_string(index) + " out of range (size " +
+                                std::to_string(size()) + ")");
+    }
+}
+
+TensorView MappedDataset::sample(size_t index) const {
+    checkIndex(index);
+    const double* data = reinterpret_cast<const double*>(base_ + header_.samplesOffset);
+    return TensorView(data + index * sampleSize(), channels(), height(), width());
+}
+
+const double* MappedDataset::label(size_t index) const {
+    checkIndex(index);
+    const double* labels = reinterpret_cast<const double*>(base_ + header_.labelsOffset);
+    return labels + index * labelSize();
+}
+
+void MappedDataset::prefetch(size_t index) const {
+#ifdef _WIN32
+    (void)index; // Windows 上依赖按需分页
+#else
+    if (index >= size()) return;
+    static const uintptr_t pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    auto advise = [](const void* begin, size_t bytes) {
+        const uintptr_t start = reinterpret_cast<uintptr_t>(begin) & ~(pageSize - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(begin) + bytes;
+        ::madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+    };
+    advise(&sample(index)(0, 0, 0), sampleSize() * sizeof(double));
+    if (labelSize() > 0) {
+        advise(label(index), labelSize() * sizeof(double));
+    }
+#endif
+}
+
+void MappedDataset::adviseRandomAccess() const {
+#ifndef _WIN32
+    ::madvise(const_cast<unsigned char*>(base_), mappedBytes_, MADV_RANDOM);
+#endif
+}
+
+// ==================== DatasetBatchReader ====================
+
+DatasetBatchReader::DatasetBatchReader(const MappedDataset& dataset, size_t batchSize, uint64_t seed,
+                                       bool shuffle)
+    : dataset_(dataset), sampler_(dataset.size(), batchSize, PhiloxRng(seed), shuffle) {
+    if (shuffle) {
+        dataset_.adviseRandomAccess();
+    }
+    prefetchNext();
+}
+
+void DatasetBatchReader::startEpoch() {
+    sampler_.nextEpoch();
+    prefetchNext();
+}
+
+void DatasetBatchReader::prefetchNext() const {
+    const std::vector<size_t>& order = sampler_.order();
+    const size_t end = std::min(sampler_.position() + sampler_.batchSize(), order.size());
+    for (size_t i = sampler_.position(); i < end; ++i) {
+        dataset_.prefetch(order[i]);
+    }
+}
+
+bool DatasetBatchReader::next(DatasetBatch& batch) {
+    batch.inputs.clear();
+    batch.targets.clear();
+    if (!sampler_.next(batch.indices)) return false;
+
+    for (size_t index : batch.indices) {
+        batch.inputs.push_back(dataset_.sample(index));
+        batch.targets.push_back(dataset_.label(index));
+    }
+
+    // 预读下一批，页面读入与本批的训练重叠
+    prefetchNext();
+    return true;
+}
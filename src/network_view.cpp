@@ -13,16 +13,10 @@ NetworkView::NetworkView(QWidget* parent)
 
 void NetworkView::setNetwork(NeuralNetwork* network) {
     network_ = network;
-    if (network_) {
-        layerSizes_ = network_->getLayerSizes();
-    }
     update();
 }
 
 void NetworkView::updateView() {
-    if (network_) {
-        layerSizes_ = network_->getLayerSizes();
-    }
     update();
 }
 
@@ -32,14 +26,21 @@ void NetworkView::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    if (!network_ || layerSizes_.empty()) {
+    // 只读训练线程发布的最新快照，绘制期间不持有网络的锁
+    std::shared_ptr<const NetworkSnapshot> snapshot;
+    if (network_) {
+        snapshot = network_->latestSnapshot();
+    }
+    if (!snapshot || snapshot->layerSizes.empty()) {
         painter.setPen(Qt::white);
         painter.drawText(rect(), Qt::AlignCenter, "No network configured");
         return;
     }
+    const std::vector<int>& layerSizes = snapshot->layerSizes;
+    const std::vector<LayerSnapshot>& layers = snapshot->layers;
 
-    int numLayers = static_cast<int>(layerSizes_.size());
-    int maxNeurons = *std::max_element(layerSizes_.begin(), layerSizes_.end());
+    int numLayers = static_cast<int>(layerSizes.size());
+    int maxNeurons = *std::max_element(layerSizes.begin(), layerSizes.end());
 
     // 计算布局
     int totalWidth = width();
@@ -54,7 +55,7 @@ void NetworkView::paintEvent(QPaintEvent* event) {
 
     for (int l = 0; l < numLayers; ++l) {
         int x = layerSpacing_ * (l + 1);
-        int numNeurons = layerSizes_[l];
+        int numNeurons = layerSizes[l];
         int startY = (totalHeight - (numNeurons - 1) * neuronSpacing_) / 2;
 
         for (int n = 0; n < numNeurons; ++n) {
@@ -63,17 +64,14 @@ void NetworkView::paintEvent(QPaintEvent* event) {
         }
     }
 
-    // 获取权重信息
-    auto allWeights = network_->getAllWeights();
-
     // 绘制连接
-    for (int l = 0; l < numLayers - 1; ++l) {
-        const auto& weights = allWeights[l];
+    for (int l = 0; l < numLayers - 1 && l < static_cast<int>(layers.size()); ++l) {
+        const LayerSnapshot& layer = layers[l];
         for (int i = 0; i < static_cast<int>(positions[l].size()); ++i) {
             for (int j = 0; j < static_cast<int>(positions[l + 1].size()); ++j) {
                 double weight = 0.0;
-                if (j < static_cast<int>(weights.size()) && i < static_cast<int>(weights[j].size())) {
-                    weight = weights[j][i];
+                if (j < layer.outputSize && i < layer.inputSize) {
+                    weight = layer.weight(j, i);
                 }
                 drawConnection(painter,
                               positions[l][i].x(), positions[l][i].y(),
@@ -83,9 +81,6 @@ void NetworkView::paintEvent(QPaintEvent* event) {
         }
     }
 
-    // 获取激活值
-    auto layers = network_->getLayersSnapshot();
-
     // 绘制神经元
     for (int l = 0; l < numLayers; ++l) {
         for (int n = 0; n < static_cast<int>(positions[l].size()); ++n) {
@@ -111,7 +106,7 @@ void NetworkView::paintEvent(QPaintEvent* event) {
     QString sizesText;
     for (int i = 0; i < numLayers; ++i) {
         if (i > 0) sizesText += " → ";
-        sizesText += QString::number(layerSizes_[i]);
+        sizesText += QString::number(layerSizes[i]);
     }
     painter.drawText(10, legendY + 20, sizesText);
 
@@ -1,42 +1,83 @@
 #include "neural_network.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <numeric>
 #include <stdexcept>
 #include <mutex>
 
 // Layer 构造函数
-Layer::Layer(int inSize, int outSize, ActivationType act)
+namespace {
+
+// 网络随机流的划分：初始权重与样本顺序各用一个子流
+const uint64_t kInitStream = 0;
+const uint64_t kShuffleStream = 1;
+
+// 权重数达到此值时并行初始化
+const size_t kParallelInitWeights = 1 << 16;
+
+} // namespace
+
+Layer::Layer(int inSize, int outSize, ActivationType act, PhiloxRng rng)
     : inputSize(inSize), outputSize(outSize), activation(act) {
     weights.resize(static_cast<size_t>(outSize) * static_cast<size_t>(inSize));
     biases.resize(static_cast<size_t>(outSize), 0.0);
     output.resize(static_cast<size_t>(outSize), 0.0);
     input.resize(static_cast<size_t>(inSize), 0.0);
     delta.resize(static_cast<size_t>(outSize), 0.0);
-    initializeWeights();
+    initializeWeights(rng);
 }
 
-void Layer::initializeWeights() {
-    if (inputSize == 0 || outputSize == 0) {
+void Layer::initializeWeights(PhiloxRng rng) {
+    if (inputSize <= 0 || outputSize <= 0) {
         throw std::invalid_argument("Layer initialization: inputSize and outputSize must be greater than 0");
     }
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    double limit = std::sqrt(6.0 / (static_cast<double>(inputSize) + static_cast<double>(outputSize)));
-    std::uniform_real_distribution<> dis(-limit, limit);
-
-    for (auto& w : weights) {
-        w = dis(gen);
-    }
-    for (auto& b : biases) {
-        b = dis(gen) * 0.1;
+    const double limit = std::sqrt(6.0 / (static_cast<double>(inputSize) + static_cast<double>(outputSize)));
+    const size_t in = static_cast<size_t>(inputSize);
+
+    auto initRow = [&](size_t j) {
+        PhiloxRng rowRng = rng.stream(j);
+        double* row = weights.data() + j * in;
+        for (size_t i = 0; i < in; ++i) {
+            row[i] = rowRng.uniform(-limit, limit);
+        }
+        biases[j] = rowRng.uniform(-limit, limit) * 0.1;
+    };
+    const size_t rows = static_cast<size_t>(outputSize);
+    if (weights.size() >= kParallelInitWeights) {
+        ThreadPool::global().parallelFor(rows, initRow);
+    } else {
+        for (size_t j = 0; j < rows; ++j) initRow(j);
     }
 }
 
+void LayerSnapshot::capture(const Layer& layer) {
+    inputSize = layer.inputSize;
+    outputSize = layer.outputSize;
+    activation = layer.activation;
+    // assign 复用回收快照的容量
+    weights.assign(layer.weights.begin(), layer.weights.end());
+    biases.assign(layer.biases.begin(), layer.biases.end());
+    output.assign(layer.output.begin(), layer.output.end());
+}
+
 // NeuralNetwork 实现
 NeuralNetwork::NeuralNetwork()
-    : inputSize_(0), isBuilt_(false) {
-    std::random_device rd;
-    rng_ = std::mt19937(rd());
+    : inputSize_(0), isBuilt_(false), rng_(nextRandomStream()) {}
+
+void NeuralNetwork::setSeed(uint64_t seed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rng_ = PhiloxRng(seed);
+    epoch_ = 0;
+}
+
+void NeuralNetwork::setShuffle(bool shuffle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shuffle_ = shuffle;
+}
+
+bool NeuralNetwork::shuffle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shuffle_;
 }
 
 void NeuralNetwork::setInputSize(int size) {
@@ -55,66 +96,28 @@ void NeuralNetwork::build() {
 
     layers_.clear();
     int prevSize = inputSize_;
+    const PhiloxRng initRng = rng_.stream(kInitStream);
 
     for (size_t i = 0; i < layerSizes_.size(); ++i) {
-        layers_.emplace_back(prevSize, layerSizes_[i], activations_[i]);
+        layers_.emplace_back(prevSize, layerSizes_[i], activations_[i], initRng.stream(i));
         prevSize = layerSizes_[i];
     }
 
     isBuilt_ = true;
-}
-
-double NeuralNetwork::activate(double x, ActivationType type) {
-    switch (type) {
-        case ActivationType::Sigmoid:
-            return 1.0 / (1.0 + std::exp(-std::clamp(x, -500.0, 500.0)));
-        case ActivationType::ReLU:
-            return std::max(0.0, x);
-        case ActivationType::Tanh:
-            return std::tanh(x);
-        default:
-            return x;
-    }
-}
-
-double NeuralNetwork::activateDerivative(double x, ActivationType type) {
-    switch (type) {
-        case ActivationType::Sigmoid: {
-            double s = activate(x, ActivationType::Sigmoid);
-            return s * (1.0 - s);
-        }
-        case ActivationType::ReLU:
-            return x > 0 ? 1.0 : 0.0;
-        case ActivationType::Tanh: {
-            double t = std::tanh(x);
-            return 1.0 - t * t;
-        }
-        default:
-            return 1.0;
-    }
-}
-
-double NeuralNetwork::activateDerivativeOutput(double y, ActivationType type) {
-    switch (type) {
-        case ActivationType::Sigmoid:
-            return y * (1.0 - y);
-        case ActivationType::ReLU:
-            return y > 0.0 ? 1.0 : 0.0;
-        case ActivationType::Tanh:
-            return 1.0 - y * y;
-        default:
-            return 1.0;
-    }
+    publishSnapshot();
 }
 
 std::vector<double> NeuralNetwork::forward(const std::vector<double>& input) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return forwardInternal(input);
+    checkInputSize(input.size());
+    forwardInternal(input.data());
+    return layers_.back().output;
 }
 
 void NeuralNetwork::backward(const std::vector<double>& target) {
     std::lock_guard<std::mutex> lock(mutex_);
-    backwardInternal(target);
+    checkTargetSize(target.size());
+    backwardInternal(target.data());
 }
 
 void NeuralNetwork::updateWeights(double learningRate) {
@@ -124,7 +127,8 @@ void NeuralNetwork::updateWeights(double learningRate) {
 
 double NeuralNetwork::train(const std::vector<std::vector<double>>& inputs,
                             const std::vector<std::vector<double>>& targets,
-                            double learningRate) {
+                            double learningRate,
+                            const TrainingControl* control) {
     if (inputs.empty() || targets.empty()) {
         throw std::invalid_argument("Training data cannot be empty");
     }
@@ -137,21 +141,72 @@ double NeuralNetwork::train(const std::vector<std::vector<double>>& inputs,
 
     std::lock_guard<std::mutex> lock(mutex_);
     double totalLoss = 0.0;
+    size_t trained = 0;
+
+    for (size_t i : epochOrder(inputs.size())) {
+        if (control && control->stopRequested()) break;
+        checkInputSize(inputs[i].size());
+        checkTargetSize(targets[i].size());
+        totalLoss += trainSampleInternal(inputs[i].data(), targets[i].data(), learningRate);
+        ++trained;
+    }
+
+    return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+}
+
+double NeuralNetwork::train(const DataTable& data, double learningRate, const TrainingControl* control) {
+    if (data.empty()) {
+        throw std::invalid_argument("Training data cannot be empty");
+    }
+    if (!isBuilt_) {
+        throw std::runtime_error("Network not built");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    checkInputSize(data.featureCount());
+    checkTargetSize(data.targetCount());
+    double totalLoss = 0.0;
+    size_t trained = 0;
 
-    for (size_t i = 0; i < inputs.size(); ++i) {
-        std::vector<double> output = forwardInternal(inputs[i]);
-        totalLoss += calculateLossInternal(output, targets[i]);
-        backwardInternal(targets[i]);
-        updateWeightsInternal(learningRate);
+    for (size_t i : epochOrder(data.rows())) {
+        if (control && control->stopRequested()) break;
+        totalLoss += trainSampleInternal(data.features(i), data.targets(i), learningRate);
+        ++trained;
     }
 
-    return totalLoss / static_cast<double>(inputs.size());
+    return trained > 0 ? totalLoss / static_cast<double>(trained) : 0.0;
+}
+
+const std::vector<size_t>& NeuralNetwork::epochOrder(size_t count) {
+    if (shuffle_) {
+        shufflePermutation(order_, count, rng_.stream(kShuffleStream).stream(epoch_++));
+    } else {
+        order_.resize(count);
+        std::iota(order_.begin(), order_.end(), size_t(0));
+    }
+    return order_;
 }
 
 double NeuralNetwork::calculateLoss(const std::vector<double>& output,
                                     const std::vector<double>& target) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return calculateLossInternal(output, target);
+    if (output.empty()) {
+        throw std::invalid_argument("Output cannot be empty for loss calculation");
+    }
+    if (target.size() != output.size()) {
+        throw std::invalid_argument("Target size mismatch");
+    }
+    return calculateLossInternal(output.data(), target.data(), output.size());
+}
+
+void NeuralNetwork::setMathPrecision(MathPrecision precision) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    precision_ = precision;
+}
+
+MathPrecision NeuralNetwork::mathPrecision() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return precision_;
 }
 
 std::vector<int> NeuralNetwork::getLayerSizes() const {
@@ -187,18 +242,53 @@ std::vector<std::vector<std::vector<double>>> NeuralNetwork::getAllWeights() con
     return allWeights;
 }
 
-std::vector<double> NeuralNetwork::forwardInternal(const std::vector<double>& input) {
+void NeuralNetwork::publishSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<NetworkSnapshot> snapshot = snapshots_.acquire();
+
+    snapshot->layerSizes.assign(1, inputSize_);
+    snapshot->layers.resize(layers_.size());
+    for (size_t l = 0; l < layers_.size(); ++l) {
+        snapshot->layerSizes.push_back(layers_[l].outputSize);
+        snapshot->layers[l].capture(layers_[l]);
+    }
+
+    snapshots_.publish(std::move(snapshot));
+}
+
+void NeuralNetwork::checkInputSize(size_t size) const {
     if (!isBuilt_) {
         throw std::runtime_error("Network not built");
     }
-    if (static_cast<int>(input.size()) != inputSize_) {
+    if (static_cast<int>(size) != inputSize_) {
         throw std::invalid_argument("Input size mismatch");
     }
+}
+
+void NeuralNetwork::checkTargetSize(size_t size) const {
+    if (layers_.empty()) {
+        throw std::runtime_error("Network not built");
+    }
+    if (size != static_cast<size_t>(layers_.back().outputSize)) {
+        throw std::invalid_argument("Target size mismatch");
+    }
+}
 
-    std::vector<double> currentInput = input;
+double NeuralNetwork::trainSampleInternal(const double* input, const double* target, double learningRate) {
+    forwardInternal(input);
+    const Layer& outputLayer = layers_.back();
+    const double loss = calculateLossInternal(outputLayer.output.data(), target, outputLayer.output.size());
+    backwardInternal(target);
+    updateWeightsInternal(learningRate);
+    return loss;
+}
+
+void NeuralNetwork::forwardInternal(const double* input) {
+    const double* currentInput = input;
 
     for (auto& layer : layers_) {
-        layer.input = currentInput;
+        // 层的 input 缓冲在 build() 时已按 inputSize 分配，这里只复制不重新分配
+        layer.input.assign(currentInput, currentInput + layer.inputSize);
 
         for (int j = 0; j < layer.outputSize; ++j) {
             const size_t jIdx = static_cast<size_t>(j);
@@ -209,29 +299,30 @@ std::vector<double> NeuralNetwork::forwardInternal(const std::vector<double>& in
                 const size_t iIdx = static_cast<size_t>(i);
                 sum += w[iIdx] * currentInput[iIdx];
             }
-            layer.output[jIdx] = activate(sum, layer.activation);
+            layer.output[jIdx] = sum;
         }
 
-        currentInput = layer.output;
-    }
+        double* out = layer.output.data();
+        visitActivation(layer.activation, precision_, [&](auto kernel) {
+            activationForward<decltype(kernel)>(out, out, layer.output.size());
+        });
 
-    return layers_.back().output;
+        currentInput = layer.output.data();
+    }
 }
 
-void NeuralNetwork::backwardInternal(const std::vector<double>& target) {
-    if (layers_.empty()) {
-        throw std::runtime_error("Network not built");
-    }
+void NeuralNetwork::backwardInternal(const double* target) {
     Layer& outputLayer = layers_.back();
-    if (target.size() != static_cast<size_t>(outputLayer.outputSize)) {
-        throw std::invalid_argument("Target size mismatch");
-    }
 
     for (int j = 0; j < outputLayer.outputSize; ++j) {
         const size_t jIdx = static_cast<size_t>(j);
-        double error = target[jIdx] - outputLayer.output[jIdx];
-        outputLayer.delta[jIdx] = error * activateDerivativeOutput(outputLayer.output[jIdx], outputLayer.activation);
+        outputLayer.delta[jIdx] = target[jIdx] - outputLayer.output[jIdx];
     }
+    visitActivation(outputLayer.activation, precision_, [&](auto kernel) {
+        activationBackwardFromOutput<decltype(kernel)>(
+            outputLayer.output.data(), outputLayer.delta.data(), outputLayer.delta.data(),
+            outputLayer.delta.size());
+    });
 
     for (int l = static_cast<int>(layers_.size()) - 2; l >= 0; --l) {
         const size_t lIdx = static_cast<size_t>(l);
@@ -245,8 +336,13 @@ void NeuralNetwork::backwardInternal(const std::vector<double>& target) {
                 const size_t jIdx = static_cast<size_t>(j);
                 error += nextLayer.weight(j, i) * nextLayer.delta[jIdx];
             }
-            currentLayer.delta[iIdx] = error * activateDerivativeOutput(currentLayer.output[iIdx], currentLayer.activation);
+            currentLayer.delta[iIdx] = error;
         }
+        visitActivation(currentLayer.activation, precision_, [&](auto kernel) {
+            activationBackwardFromOutput<decltype(kernel)>(
+                currentLayer.output.data(), currentLayer.delta.data(), currentLayer.delta.data(),
+                currentLayer.delta.size());
+        });
     }
 }
 
@@ -266,18 +362,11 @@ void NeuralNetwork::updateWeightsInternal(double learningRate) {
     }
 }
 
-double NeuralNetwork::calculateLossInternal(const std::vector<double>& output,
-                                            const std::vector<double>& target) {
-    if (output.empty()) {
-        throw std::invalid_argument("Output cannot be empty for loss calculation");
-    }
-    if (target.size() != output.size()) {
-        throw std::invalid_argument("Target size mismatch");
-    }
+double NeuralNetwork::calculateLossInternal(const double* output, const double* target, size_t size) const {
     double loss = 0.0;
-    for (size_t i = 0; i < output.size(); ++i) {
+    for (size_t i = 0; i < size; ++i) {
         double diff = target[i] - output[i];
         loss += diff * diff;
     }
-    return loss / static_cast<double>(output.size());
+    return loss / static_cast<double>(size);
 }
@@ -0,0 +1,63 @@
+#include "progress_throttle.h"
+#include <algorithm>
+
+ProgressThrottle::ProgressThrottle(double rateHz, size_t maxPointsPerBatch)
+    : maxPoints_(std::max<size_t>(1, maxPointsPerBatch)) {
+    setRate(rateHz);
+    pending_.reserve(2 * maxPoints_);
+}
+
+void ProgressThrottle::setRate(double rateHz) {
+    rateHz_ = rateHz;
+    if (rateHz > 0.0) {
+        interval_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateHz));
+    } else {
+        interval_ = Clock::duration::zero();
+    }
+}
+
+bool ProgressThrottle::record(int epoch, double loss, Clock::time_point now) {
+    latest_ = {epoch, loss};
+    hasLatest_ = true;
+
+    if (++sinceKept_ >= stride_) {
+        sinceKept_ = 0;
+        pending_.push_back(latest_);
+        if (pending_.size() >= 2 * maxPoints_) {
+            // 2 抽 1，保留奇数下标，使最后一个保留点仍在末尾
+            size_t kept = 0;
+            for (size_t i = 1; i < pending_.size(); i += 2) {
+                pending_[kept++] = pending_[i];
+            }
+            pending_.resize(kept);
+            stride_ *= 2;
+        }
+    }
+
+    return !flushed_ || now - lastFlush_ >= interval_;
+}
+
+std::vector<LossPoint> ProgressThrottle::takeBatch(Clock::time_point now) {
+    std::vector<LossPoint> batch;
+    batch.reserve(pending_.size() + 1);
+    batch.assign(pending_.begin(), pending_.end());
+    if (hasLatest_ && (batch.empty() || batch.back().epoch != latest_.epoch)) {
+        batch.push_back(latest_);
+    }
+
+    pending_.clear();
+    hasLatest_ = false;
+    stride_ = 1;
+    sinceKept_ = 0;
+    lastFlush_ = now;
+    flushed_ = true;
+    return batch;
+}
+
+void ProgressThrottle::reset() {
+    pending_.clear();
+    hasLatest_ = false;
+    stride_ = 1;
+    sinceKept_ = 0;
+    flushed_ = false;
+}
@@ -0,0 +1,112 @@
+#include "synthetic_datasets.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+TabularData makeTabularDataset(TabularDataset dataset, PhiloxRng& gen, int circleSamples) {
+    TabularData data;
+    switch (dataset) {
+        case TabularDataset::XOR:
+            data.inputs = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+            data.targets = {{0}, {1}, {1}, {0}};
+            break;
+
+        case TabularDataset::AND:
+            data.inputs = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+            data.targets = {{0}, {0}, {0}, {1}};
+            break;
+
+        case TabularDataset::OR:
+            data.inputs = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+            data.targets = {{0}, {1}, {1}, {1}};
+            break;
+
+        case TabularDataset::Circle: {
+            for (int i = 0; i < circleSamples; ++i) {
+                double x = gen.uniform(-1.0, 1.0);
+                double y = gen.uniform(-1.0, 1.0);
+                double dist = std::sqrt(x * x + y * y);
+                data.inputs.push_back({(x + 1.0) / 2.0, (y + 1.0) / 2.0});
+                data.targets.push_back({dist < 0.5 ? 1.0 : 0.0});
+            }
+            break;
+        }
+    }
+    return data;
+}
+
+TabularDataset tabularDatasetFromName(const std::string& name) {
+    if (name == "xor") return TabularDataset::XOR;
+    if (name == "and") return TabularDataset::AND;
+    if (name == "or") return TabularDataset::OR;
+    if (name == "circle") return TabularDataset::Circle;
+    throw std::invalid_argument("Unknown tabular dataset: " + name);
+}
+
+Tensor makeShapeImage(int shapeClass, int size, PhiloxRng& gen) {
+    Tensor image(1, size, size, 0.0);
+
+    double centerX = gen.uniform(0.2, 0.8);
+    double centerY = gen.uniform(0.2, 0.8);
+    double radius = gen.uniform(0.15, 0.35);
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            double nx = static_cast<double>(x) / size;
+            double ny = static_cast<double>(y) / size;
+            double dx = nx - centerX;
+            double dy = ny - centerY;
+
+            double value = 0.0;
+
+            switch (shapeClass % 3) {
+                case 0: // 圆形
+                    if (std::sqrt(dx*dx + dy*dy) < radius) {
+                        value = 1.0;
+                    }
+                    break;
+                case 1: // 方形
+                    if (std::abs(dx) < radius && std::abs(dy) < radius) {
+                        value = 1.0;
+                    }
+                    break;
+                case 2: // 十字形
+                    if ((std::abs(dx) < radius/3 && std::abs(dy) < radius) ||
+                        (std::abs(dy) < radius/3 && std::abs(dx) < radius)) {
+                        value = 1.0;
+                    }
+                    break;
+            }
+
+            value += gen.normal(0.0, 0.05);
+            image(0, y, x) = std::clamp(value, 0.0, 1.0);
+        }
+    }
+    return image;
+}
+
+void makeShapeDataset(int size, int numClasses, int samplesPerClass, PhiloxRng& gen,
+                      std::vector<Tensor>& images, std::vector<std::vector<double>>& labels) {
+    const size_t total = static_cast<size_t>(numClasses) * static_cast<size_t>(samplesPerClass);
+    images.assign(total, Tensor());
+    labels.assign(total, std::vector<double>(static_cast<size_t>(numClasses), 0.0));
+
+    // 第 k 张图像取自 base.stream(k)，各图像并行合成，结果与线程数无关
+    const PhiloxRng base = gen.stream(gen());
+    ThreadPool::global().parallelFor(total, [&](size_t k) {
+        const int c = static_cast<int>(k / static_cast<size_t>(samplesPerClass));
+        PhiloxRng sampleRng = base.stream(k);
+        images[k] = makeShapeImage(c, size, sampleRng);
+        labels[k][static_cast<size_t>(c)] = 1.0;
+    });
+}
+
+void makeSortSample(size_t seqLen, PhiloxRng& gen, Tensor& input, Tensor& target) {
+    std::vector<double> data(seqLen);
+    for (auto& v : data) v = gen.uniform();
+
+    input = Tensor::fromVector(data, 1, seqLen, 1);
+    std::sort(data.begin(), data.end());
+    target = Tensor::fromVector(data, 1, seqLen, 1);
+}
@@ -0,0 +1,39 @@
+#include "training_control.h"
+
+void TrainingControl::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_.store(false, std::memory_order_release);
+    stop_.store(false, std::memory_order_release);
+}
+
+void TrainingControl::pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_.store(true, std::memory_order_release);
+}
+
+void TrainingControl::resume() {
+    {
+        // 在锁内修改状态，避免训练线程检查谓词后、进入等待前错过唤醒
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_.store(false, std::memory_order_release);
+    }
+    cv_.notify_all();
+}
+
+void TrainingControl::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true, std::memory_order_release);
+        paused_.store(false, std::memory_order_release);
+    }
+    cv_.notify_all();
+}
+
+bool TrainingControl::checkpoint() {
+    if (!isPaused()) {
+        return !stopRequested();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !isPaused() || stopRequested(); });
+    return !stopRequested();
+}
@@ -6,9 +6,8 @@ TrainingThread::TrainingThread(QObject* parent)
     , network_(nullptr)
     , epochs_(100)
     , learningRate_(0.1)
-    , running_(false)
-    , paused_(false)
-    , stopRequested_(false) {
+    , running_(false) {
+    registerProgressMetaTypes();
 }
 
 TrainingThread::~TrainingThread() {
@@ -21,11 +20,9 @@ void TrainingThread::setNetwork(NeuralNetwork* network) {
     network_ = network;
 }
 
-void TrainingThread::setTrainingData(const std::vector<std::vector<double>>& inputs,
-                                     const std::vector<std::vector<double>>& targets) {
+void TrainingThread::setTrainingData(DataTable data) {
     QMutexLocker locker(&mutex_);
-    inputs_ = inputs;
-    targets_ = targets;
+    data_ = std::move(data);
 }
 
 void TrainingThread::setParameters(int epochs, double learningRate) {
@@ -34,46 +31,70 @@ void TrainingThread::setParameters(int epochs, double learningRate) {
     learningRate_ = learningRate;
 }
 
+void TrainingThread::setUpdateRate(double rateHz) {
+    QMutexLocker locker(&mutex_);
+    updateRateHz_ = rateHz;
+}
+
+void TrainingThread::startTraining() {
+    control_.reset();
+    start();
+}
+
 void TrainingThread::stopTraining() {
-    stopRequested_ = true;
-    paused_ = false;
+    control_.stop();
 }
 
 void TrainingThread::pauseTraining() {
-    paused_ = true;
+    control_.pause();
 }
 
 void TrainingThread::resumeTraining() {
-    paused_ = false;
+    control_.resume();
 }
 
 void TrainingThread::run() {
     if (!network_) return;
 
     running_ = true;
-    stopRequested_ = false;
 
-    for (int epoch = 0; epoch < epochs_ && !stopRequested_; ++epoch) {
-        // 检查暂停
-        while (paused_ && !stopRequested_) {
-            msleep(100);
-        }
+    ProgressThrottle throttle;
+    {
+        QMutexLocker locker(&mutex_);
+        throttle.setRate(updateRateHz_);
+    }
 
-        if (stopRequested_) break;
+    for (int epoch = 0; epoch < epochs_; ++epoch) {
+        if (control_.isPaused() && throttle.hasPending()) {
+            flushProgress(throttle); // 暂停时界面显示到最新一轮
+        }
+        // 暂停时在条件变量上等待，不占用 CPU；恢复或取消会立即唤醒
+        if (!control_.checkpoint()) break;
 
         double loss;
         {
             QMutexLocker locker(&mutex_);
-            loss = network_->train(inputs_, targets_, learningRate_);
+            loss = network_->train(data_, learningRate_, &control_);
         }
+        if (control_.stopRequested()) break; // 本轮在样本之间被取消，不计入进度
 
-        emit epochCompleted(epoch + 1, loss);
-        emit weightsUpdated();
+        // 训练全速进行，界面按帧率接收合并后的进度
+        if (throttle.record(epoch + 1, loss)) {
+            flushProgress(throttle);
+        }
+    }
 
-        // 添加小延迟以便可视化
-        msleep(10);
+    if (throttle.hasPending()) {
+        flushProgress(throttle);
     }
 
     running_ = false;
     emit trainingCompleted();
 }
+
+void TrainingThread::flushProgress(ProgressThrottle& throttle) {
+    // 发布快照后再通知界面，界面绘制时只读快照，不再争用网络的锁
+    network_->publishSnapshot();
+    emit progressUpdated(throttle.takeBatch());
+    emit weightsUpdated();
+}
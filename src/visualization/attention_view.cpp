@@ -4,6 +4,19 @@
 #include <algorithm>
 #include <cmath>
 
+// Short description of the attention pattern for heatmap titles
+static QString patternLabel(const AttentionSnapshot& snapshot) {
+    const AttentionPattern& p = snapshot.pattern;
+    QString label;
+    auto append = [&label](const QString& part) { label += (label.isEmpty() ? "" : ", ") + part; };
+    if (snapshot.type == AttentionType::Linear) append("linear");
+    if (p.window > 0) append(QString("window %1").arg(p.window));
+    if (p.dilation > 1) append(QString("dilation %1").arg(p.dilation));
+    if (!p.isDense() && p.globalTokens > 0) append(QString("global %1").arg(p.globalTokens));
+    if (snapshot.causal) append("causal");
+    return label.isEmpty() ? label : " (" + label + ")";
+}
+
 AttentionView::AttentionView(QWidget* parent) : QWidget(parent), network_(nullptr) {
     setMinimumSize(800, 600);
 }
@@ -28,25 +41,21 @@ void AttentionView::paintEvent(QPaintEvent* event) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(network_->getMutex());
-
-    if (network_->getBlocks().empty()) {
+    // Latest published snapshot; painting never takes the network mutex
+    std::shared_ptr<const AttentionSnapshot> snapshot = network_->latestSnapshot();
+    if (!snapshot || snapshot->numHeads == 0) {
         painter.setPen(Qt::white);
         painter.drawText(rect(), Qt::AlignCenter, "No Blocks Available");
         return;
     }
 
-    const auto& block = network_->getBlocks()[0];
-    const auto& attn = block.getAttention();
-
-    Tensor Q = attn.getQ();
-    Tensor K = attn.getK();
-    Tensor V = attn.getV();
-    Tensor W = attn.getWeights();
+    TensorView Q = snapshot->Q;
+    TensorView K = snapshot->K;
+    TensorView V = snapshot->V;
 
     // Also Input and Output
-    Tensor input = network_->getInput();
-    Tensor output = network_->getOutput();
+    TensorView input = snapshot->input;
+    TensorView output = snapshot->output;
 
     if (Q.empty()) return;
 
@@ -76,10 +85,25 @@ void AttentionView::paintEvent(QPaintEvent* event) {
     drawMatrix(painter, Q, rectQ, "Query (Q) - [Seq x D_k]");
     drawMatrix(painter, K, rectK, "Key (K) - [Seq x D_k]");
     drawMatrix(painter, V, rectV, "Value (V) - [Seq x D_k]");
-    drawMatrix(painter, W, rectW, "Attention Weights - [Seq x Seq]");
+    // One heatmap per head, side by side
+    const TensorView weights = snapshot->weights;
+    const int heads = static_cast<int>(snapshot->numHeads);
+    const QString pattern = patternLabel(*snapshot);
+    if (heads == 1) {
+        drawMatrix(painter, weights.channel(0), rectW, "Attention Weights - [Seq x Seq]" + pattern);
+        drawMaskOverlay(painter, *snapshot, rectW);
+    } else {
+        const int gap = 10;
+        const int headW = (rectW.width() - (heads - 1) * gap) / heads;
+        for (int i = 0; i < heads; ++i) {
+            QRect rectHead(rectW.left() + i * (headW + gap), rectW.top(), headW, rectW.height());
+            drawMatrix(painter, weights.channel(i), rectHead, QString("Head %1 Weights").arg(i + 1) + pattern);
+            drawMaskOverlay(painter, *snapshot, rectHead);
+        }
+    }
 }
 
-void AttentionView::drawMatrix(QPainter& painter, const Tensor& tensor, const QRect& rect, const QString& title) {
+void AttentionView::drawMatrix(QPainter& painter, const TensorView& tensor, const QRect& rect, const QString& title) {
     painter.setPen(Qt::white);
     painter.drawText(rect.left(), rect.top() - 5, title);
 
@@ -124,7 +148,26 @@ void AttentionView::drawMatrix(QPainter& painter, const Tensor& tensor, const QR
     }
 }
 
-void AttentionView::drawSequence(QPainter& painter, const Tensor& seq, const QRect& rect, const QString& title) {
+void AttentionView::drawMaskOverlay(QPainter& painter, const AttentionSnapshot& snapshot, const QRect& rect) {
+    if (snapshot.pattern.isDense() && !snapshot.causal) return;
+
+    const int len = static_cast<int>(snapshot.Q.height());
+    if (len == 0) return;
+
+    double cellW = (double)rect.width() / len;
+    double cellH = (double)rect.height() / len;
+    const QColor masked(70, 70, 95);
+
+    for (int r = 0; r < len; ++r) {
+        for (int c = 0; c < len; ++c) {
+            if (!snapshot.attends(r, c)) {
+                painter.fillRect(QRectF(rect.left() + c * cellW, rect.top() + r * cellH, cellW, cellH), masked);
+            }
+        }
+    }
+}
+
+void AttentionView::drawSequence(QPainter& painter, const TensorView& seq, const QRect& rect, const QString& title) {
     painter.setPen(Qt::white);
     painter.drawText(rect.left(), rect.top() - 5, title);
 
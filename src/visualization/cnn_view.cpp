@@ -1,7 +1,7 @@
 #include "visualization/cnn_view.h"
+#include "cnn/tensor_view.h"
 #include <cmath>
 #include <algorithm>
-#include <mutex>
 
 CNNView::CNNView(QWidget* parent)
     : QWidget(parent) {
@@ -24,7 +24,12 @@ void CNNView::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    if (!network_) {
+    // 只读训练线程发布的最新快照，绘制期间不持有网络的锁
+    std::shared_ptr<const CNNSnapshot> snapshot;
+    if (network_) {
+        snapshot = network_->latestSnapshot();
+    }
+    if (!snapshot) {
         painter.setPen(Qt::gray);
         painter.drawText(rect(), Qt::AlignCenter, "No CNN Network");
         return;
@@ -32,9 +37,8 @@ void CNNView::paintEvent(QPaintEvent* event) {
 
     layerRects_.clear();
 
-    std::lock_guard<std::mutex> lock(network_->getMutex());
-    const auto& cnnLayers = network_->getCNNLayers();
-    const auto& denseLayers = network_->getDenseLayers();
+    const auto& cnnLayers = snapshot->cnnLayers;
+    const auto& denseLayers = snapshot->denseLayers;
 
     int totalLayers = 1 + static_cast<int>(cnnLayers.size()) + static_cast<int>(denseLayers.size());
     layerSpacing_ = std::max(80, (width() - 100) / (totalLayers + 1));
@@ -43,7 +47,7 @@ void CNNView::paintEvent(QPaintEvent* event) {
     int currentX = 50;
 
     // 绘制输入层
-    drawInputLayer(painter, currentX, centerY);
+    drawInputLayer(painter, *snapshot, currentX, centerY);
     layerRects_.push_back(QRect(currentX - 30, centerY - 60, 60, 120));
     currentX += layerSpacing_;
 
@@ -53,7 +57,7 @@ void CNNView::paintEvent(QPaintEvent* event) {
         drawConnection(painter, currentX - layerSpacing_ + 30, centerY,
                       currentX - 30, centerY);
 
-        drawCNNLayer(painter, static_cast<int>(i), currentX, centerY);
+        drawCNNLayer(painter, cnnLayers[i], currentX, centerY);
         layerRects_.push_back(QRect(currentX - 30, centerY - 60, 60, 120));
         currentX += layerSpacing_;
     }
@@ -63,13 +67,13 @@ void CNNView::paintEvent(QPaintEvent* event) {
         drawConnection(painter, currentX - layerSpacing_ + 30, centerY,
                       currentX - 20, centerY);
 
-        drawDenseLayer(painter, static_cast<int>(i), currentX, centerY);
+        drawDenseLayer(painter, denseLayers[i], currentX, centerY);
         layerRects_.push_back(QRect(currentX - 20, centerY - 50, 40, 100));
         currentX += layerSpacing_;
     }
 }
 
-void CNNView::drawInputLayer(QPainter& painter, int x, int y) {
+void CNNView::drawInputLayer(QPainter& painter, const CNNSnapshot& snapshot, int x, int y) {
     int w = 50;
     int h = 60;
     int d = 10;
@@ -83,28 +87,26 @@ void CNNView::drawInputLayer(QPainter& painter, int x, int y) {
         painter.setFont(font);
 
         QString info = QString("%1x%2x%3")
-            .arg(network_->inputChannels())
-            .arg(network_->inputHeight())
-            .arg(network_->inputWidth());
+            .arg(snapshot.inputChannels)
+            .arg(snapshot.inputHeight)
+            .arg(snapshot.inputWidth);
         painter.drawText(x - 30, y + h/2 + 15, 60, 20, Qt::AlignCenter, info);
         painter.drawText(x - 30, y - h/2 - 20, 60, 20, Qt::AlignCenter, "Input");
     }
 }
 
-void CNNView::drawCNNLayer(QPainter& painter, int layerIndex, int x, int y) {
-    const auto& layer = network_->getCNNLayers()[layerIndex];
-
+void CNNView::drawCNNLayer(QPainter& painter, const CNNLayerSnapshot& layer, int x, int y) {
     // 根据输出尺寸计算3D盒子大小
-    int channels = static_cast<int>(layer->outputChannels());
-    int h = static_cast<int>(layer->outputHeight());
-    int w = static_cast<int>(layer->outputWidth());
+    int channels = static_cast<int>(layer.outputChannels);
+    int h = static_cast<int>(layer.outputHeight);
+    int w = static_cast<int>(layer.outputWidth);
 
     // 缩放到可视化尺寸
     int boxW = std::max(20, std::min(60, w * 2));
     int boxH = std::max(30, std::min(80, h * 2));
     int boxD = std::max(10, std::min(30, channels / 2));
 
-    QColor color = getLayerColor(layer->type());
+    QColor color = getLayerColor(layer.type);
     draw3DBox(painter, x - boxW/2, y - boxH/2, boxW, boxH, boxD, color);
 
     if (showLayerInfo_) {
@@ -117,30 +119,31 @@ void CNNView::drawCNNLayer(QPainter& painter, int layerIndex, int x, int y) {
             .arg(channels).arg(h).arg(w);
         painter.drawText(x - 40, y + boxH/2 + 15, 80, 20, Qt::AlignCenter, info);
 
-        QString name = QString::fromStdString(layer->name());
+        QString name = QString::fromStdString(layer.name);
         painter.drawText(x - 40, y - boxH/2 - 20, 80, 20, Qt::AlignCenter, name);
     }
 
     // 绘制特征图缩略图
-    if (showFeatureMaps_ && !layer->getOutput().empty()) {
-        const Tensor& output = layer->getOutput();
+    if (showFeatureMaps_ && !layer.output.empty()) {
+        const TensorView output = layer.output;
         int thumbSize = 12;
         int maxThumbs = std::min(4, static_cast<int>(output.channels()));
 
+        double maxVal = output.max();
+        double minVal = output.min();
+        double range = (maxVal - minVal > 0.001) ? (maxVal - minVal) : 1.0;
+
         for (int c = 0; c < maxThumbs; ++c) {
             int tx = x + boxW/2 + 5 + (c % 2) * (thumbSize + 2);
             int ty = y - boxH/4 + (c / 2) * (thumbSize + 2);
 
             // 绘制特征图缩略图
-            double maxVal = output.max();
-            double minVal = output.min();
-            double range = (maxVal - minVal > 0.001) ? (maxVal - minVal) : 1.0;
-
+            const TensorView channel = output.channel(static_cast<size_t>(c));
             for (int i = 0; i < thumbSize; ++i) {
                 for (int j = 0; j < thumbSize; ++j) {
-                    int oh = i * output.height() / thumbSize;
-                    int ow = j * output.width() / thumbSize;
-                    double val = (output(c, oh, ow) - minVal) / range;
+                    int oh = i * static_cast<int>(channel.height()) / thumbSize;
+                    int ow = j * static_cast<int>(channel.width()) / thumbSize;
+                    double val = (channel(0, oh, ow) - minVal) / range;
                     QColor pixelColor = getActivationColor(val);
                     painter.setPen(pixelColor);
                     painter.drawPoint(tx + j, ty + i);
@@ -153,9 +156,7 @@ void CNNView::drawCNNLayer(QPainter& painter, int layerIndex, int x, int y) {
     }
 }
 
-void CNNView::drawDenseLayer(QPainter& painter, int layerIndex, int x, int y) {
-    const auto& layer = network_->getDenseLayers()[layerIndex];
-
+void CNNView::drawDenseLayer(QPainter& painter, const LayerSnapshot& layer, int x, int y) {
     int neurons = layer.outputSize;
     int displayNeurons = std::min(10, neurons);
     int radius = 8;
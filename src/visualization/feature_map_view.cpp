@@ -21,6 +21,10 @@ void FeatureMapView::setFeatureMap(const Tensor& featureMap, const QString& laye
     update();
 }
 
+void FeatureMapView::setFeatureMap(const TensorView& featureMap, const QString& layerName) {
+    setFeatureMap(featureMap.toTensor(), layerName);
+}
+
 void FeatureMapView::clear() {
     featureMap_ = Tensor();
     layerName_.clear();
@@ -73,8 +77,9 @@ void FeatureMapView::paintEvent(QPaintEvent* event) {
         cellRect.translate(0, startY);
 
         // 绘制特征图像素
-        int h = static_cast<int>(featureMap_.height());
-        int w = static_cast<int>(featureMap_.width());
+        const TensorView channel = TensorView(featureMap_).channel(c);
+        int h = static_cast<int>(channel.height());
+        int w = static_cast<int>(channel.width());
 
         QImage image(thumbnailSize_, thumbnailSize_, QImage::Format_RGB32);
 
@@ -82,7 +87,7 @@ void FeatureMapView::paintEvent(QPaintEvent* event) {
             for (int px = 0; px < thumbnailSize_; ++px) {
                 int fy = py * h / thumbnailSize_;
                 int fx = px * w / thumbnailSize_;
-                double val = (featureMap_(c, fy, fx) - minVal) / range;
+                double val = (channel(0, fy, fx) - minVal) / range;
                 QColor color = valueToColor(val);
                 image.setPixelColor(px, py, color);
             }
@@ -0,0 +1,64 @@
+#include "attention/attention_layer.h"
+#include "attention/linear_attention_layer.h"
+#include "cnn/tensor.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+
+// Softmax vs linear attention: time one forward + backward of a single layer
+// for growing sequence lengths and report where linear attention overtakes.
+static double timeLayer(AttentionLayerBase& layer, const Tensor& input, const Tensor& grad, int reps) {
+    // Warmup
+    layer.forward(input);
+    layer.backward(grad, 0.0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        layer.forward(input);
+        layer.backward(grad, 0.0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> diff = end - start;
+    return diff.count() / reps;
+}
+
+int main() {
+    std::cout << "Starting Attention Benchmark (softmax vs linear)..." << std::endl;
+
+    const size_t d_model = 32;
+    const size_t d_k = 32;
+    const size_t heads = 4;
+    const std::vector<size_t> lengths = {16, 32, 64, 128, 256, 512, 1024, 2048};
+
+    std::cout << "D_model=" << d_model << ", D_k=" << d_k << ", Heads=" << heads
+              << " (forward + backward, ms per step)" << std::endl;
+    std::cout << std::setw(8) << "SeqLen" << std::setw(14) << "Softmax" << std::setw(14) << "Linear"
+              << std::setw(10) << "Speedup" << std::endl;
+
+    size_t crossover = 0;
+    for (size_t L : lengths) {
+        Tensor input(1, L, d_model);
+        input.randomInit(-1.0, 1.0);
+        Tensor grad(1, L, d_model);
+        grad.randomInit(-1.0, 1.0);
+
+        const int reps = L <= 256 ? 20 : 3;
+        AttentionLayer softmax(d_model, d_k, heads);
+        LinearAttentionLayer linear(d_model, d_k, heads);
+        const double softmaxMs = timeLayer(softmax, input, grad, reps);
+        const double linearMs = timeLayer(linear, input, grad, reps);
+        if (crossover == 0 && linearMs < softmaxMs) crossover = L;
+
+        std::cout << std::setw(8) << L << std::fixed << std::setprecision(3)
+                  << std::setw(14) << softmaxMs << std::setw(14) << linearMs
+                  << std::setw(9) << softmaxMs / linearMs << "x" << std::endl;
+    }
+
+    if (crossover > 0) {
+        std::cout << "Linear attention is faster from SeqLen " << crossover << std::endl;
+    } else {
+        std::cout << "Linear attention did not overtake softmax attention in the tested range" << std::endl;
+    }
+    return 0;
+}
@@ -1,10 +1,41 @@
+// Release（NDEBUG）构建中断言同样生效：测试照常检查，只供断言使用的变量也不会告警
+#undef NDEBUG
 #include <iostream>
 #include <vector>
 #include <cassert>
 #include "neural_network.h"
 #include "cnn/cnn_network.h"
 #include "cnn/tensor.h"
+#include "cnn/tensor_view.h"
+#include "cnn/augmentation.h"
 #include "attention/attention_network.h"
+#include "attention/positional_encoding.h"
+#include "attention/attention_layer.h"
+#include "attention/linear_attention_layer.h"
+#include "attention/streaming_engine.h"
+#include "activation_kernels.h"
+#include "fast_math.h"
+#include "thread_pool.h"
+#include "cnn/random.h"
+#include "snapshot_publisher.h"
+#include "progress_throttle.h"
+#include "training_control.h"
+#include "data_pipeline.h"
+#include "mapped_dataset.h"
+#include "idx_dataset.h"
+#include "data_table.h"
+#include "synthetic_datasets.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <chrono>
+#include <set>
+#include <thread>
 
 // 自动化功能测试
 
@@ -229,6 +260,1887 @@ void testTensorOperations() {
     }
 }
 
+void testTensorReshapeView() {
+    std::cout << "\n=== 测试 Tensor reshape 视图 ===" << std::endl;
+
+    Tensor t(2, 3, 4);
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<double>(i);
+    }
+
+    Tensor flat = t.reshape(1, 1, 24);
+    assert(flat.sharesStorageWith(t));
+    assert(flat(0, 0, 13) == t(1, 0, 1));
+    flat(0, 0, 5) = -1.0;
+    assert(t(0, 1, 1) == -1.0);
+    std::cout << "✓ reshape 视图共享存储" << std::endl;
+
+    // 拷贝仍为深拷贝
+    Tensor copy = flat;
+    assert(!copy.sharesStorageWith(t));
+    copy(0, 0, 0) = 42.0;
+    assert(t(0, 0, 0) == 0.0);
+    std::cout << "✓ 拷贝与视图解耦" << std::endl;
+
+    try {
+        t.reshape(1, 1, 25);
+        std::cerr << "✗ 应该抛出 reshape 尺寸异常但没有" << std::endl;
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        std::cout << "✓ 正确捕获 reshape 尺寸异常: " << e.what() << std::endl;
+    }
+
+    // const 张量只能得到只读视图
+    const Tensor& constT = t;
+    TensorView readOnly = constT.reshape(1, 1, 24);
+    assert(readOnly.width() == 24 && readOnly(0, 0, 13) == t(1, 0, 1));
+
+    FlattenLayer flatten(2, 3, 4);
+    Tensor out = flatten.forward(t);
+    assert(out.width() == 24 && !out.sharesStorageWith(t) && out(0, 0, 13) == t(1, 0, 1));
+    out(0, 0, 13) = 7.0;
+    assert(t(1, 0, 1) == 13.0);
+    assert(out.sharesStorageWith(flatten.getOutput()));
+    Tensor grad = flatten.backward(out);
+    assert(grad.channels() == 2 && grad.height() == 3 && grad.width() == 4);
+    assert(!grad.sharesStorageWith(out) && grad(1, 0, 1) == 7.0);
+    std::cout << "✓ FlattenLayer 不与 const 输入/梯度共享可写存储" << std::endl;
+
+    // 交出所有权时前向与反向都是 O(1)：输出与输入共享同一存储
+    Tensor owned = t;
+    const double* ownedData = owned.rawData();
+    Tensor flatOwned = flatten.forwardOwned(std::move(owned));
+    assert(flatOwned.rawData() == ownedData && flatOwned.width() == 24 && flatOwned(0, 0, 13) == t(1, 0, 1));
+    assert(flatOwned.sharesStorageWith(flatten.getOutput()));
+    Tensor gradOwned = flatOwned;
+    const double* gradData = gradOwned.rawData();
+    Tensor gradBack = flatten.backwardOwned(std::move(gradOwned));
+    assert(gradBack.rawData() == gradData && gradBack.channels() == 2 && gradBack(1, 0, 1) == t(1, 0, 1));
+    std::cout << "✓ FlattenLayer 接管张量时前向/反向不复制数据" << std::endl;
+}
+
+void testTensorViewSlicing() {
+    std::cout << "\n=== 测试 TensorView 跨步视图 ===" << std::endl;
+
+    Tensor t(2, 3, 4);
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<double>(i);
+    }
+
+    TensorView ch = TensorView(t).channel(1);
+    assert(ch.channels() == 1 && ch(0, 2, 3) == t(1, 2, 3));
+    std::cout << "✓ 通道切片" << std::endl;
+
+    TensorView tr = TensorView(t).transposed();
+    assert(tr.height() == 4 && tr.width() == 3 && !tr.isContiguous());
+    assert(tr(1, 3, 2) == t(1, 2, 3));
+    Tensor trCopy = t.transpose();
+    for (size_t c = 0; c < 2; ++c)
+        for (size_t h = 0; h < 4; ++h)
+            for (size_t w = 0; w < 3; ++w)
+                assert(trCopy(c, h, w) == tr(c, h, w));
+    std::cout << "✓ 步长转置" << std::endl;
+
+    TensorView win = TensorView(t).window(1, 1, 2, 2);
+    assert(win(0, 0, 0) == t(0, 1, 1) && win(1, 1, 1) == t(1, 2, 2));
+    assert(win.min() == t(0, 1, 1) && win.max() == t(1, 2, 2));
+    std::cout << "✓ 子窗口视图" << std::endl;
+
+    // 转置视图参与矩阵乘法与显式转置结果一致
+    Tensor a(1, 3, 2);
+    Tensor b(1, 3, 4);
+    for (size_t i = 0; i < a.size(); ++i) a.data()[i] = 0.5 * static_cast<double>(i) - 1.0;
+    for (size_t i = 0; i < b.size(); ++i) b.data()[i] = 0.25 * static_cast<double>(i);
+    Tensor viaView = matmul(TensorView(a).transposed(), b);
+    Tensor viaCopy = a.transpose().matmul(b);
+    for (size_t i = 0; i < viaView.size(); ++i) {
+        assert(std::abs(viaView.data()[i] - viaCopy.data()[i]) < 1e-12);
+    }
+    std::cout << "✓ 视图矩阵乘法" << std::endl;
+
+    try {
+        TensorView(t).window(2, 2, 2, 3);
+        std::cerr << "✗ 应该抛出窗口越界异常但没有" << std::endl;
+        assert(false);
+    } catch (const std::out_of_range& e) {
+        std::cout << "✓ 正确捕获窗口越界异常" << std::endl;
+    }
+}
+
+void testTensorExpressionTemplates() {
+    std::cout << "\n=== 测试 Tensor 表达式模板 ===" << std::endl;
+
+    Tensor a(1, 2, 3), b(1, 2, 3), c(1, 2, 3);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a.data()[i] = static_cast<double>(i);
+        b.data()[i] = 2.0 * static_cast<double>(i);
+        c.data()[i] = 1.0;
+    }
+
+    Tensor r = a + b - c * 0.5 + 2.0 * hadamard(a, c);
+    for (size_t i = 0; i < r.size(); ++i) {
+        double expected = a.data()[i] + b.data()[i] - 0.5 + 2.0 * a.data()[i];
+        assert(std::abs(r.data()[i] - expected) < 1e-12);
+    }
+    assert(r.channels() == 1 && r.height() == 2 && r.width() == 3);
+    std::cout << "✓ 融合表达式求值" << std::endl;
+
+    Tensor w = a;
+    w -= (b - a) * 0.1;
+    for (size_t i = 0; i < w.size(); ++i) {
+        assert(std::abs(w.data()[i] - 0.9 * a.data()[i]) < 1e-12);
+    }
+    std::cout << "✓ 复合赋值" << std::endl;
+
+    // 自引用表达式与视图赋值
+    Tensor x = a;
+    x = x + x;
+    assert(x(0, 1, 2) == 2.0 * a(0, 1, 2));
+    Tensor view = a.reshape(1, 1, 6);
+    view = -view;
+    assert(a(0, 1, 2) == 5.0 && view(0, 0, 5) == -5.0);
+    std::cout << "✓ 自引用与视图赋值" << std::endl;
+
+    try {
+        Tensor bad = a + Tensor(1, 1, 2);
+        std::cerr << "✗ 应该抛出尺寸不匹配异常但没有" << std::endl;
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        std::cout << "✓ 正确捕获尺寸不匹配异常" << std::endl;
+    }
+}
+
+template <typename Kernel>
+void checkActivationKernel(const char* name) {
+    const double xs[] = {-3.0, -0.7, -0.1, 0.2, 0.9, 2.5};
+    const double h = 1e-6;
+    for (double x : xs) {
+        double numeric = (Kernel::f(x + h) - Kernel::f(x - h)) / (2.0 * h);
+        assert(std::abs(numeric - Kernel::df(x)) < 1e-5);
+        if constexpr (Kernel::hasOutputDerivative) {
+            assert(std::abs(Kernel::dfFromOutput(Kernel::f(x)) - Kernel::df(x)) < 1e-12);
+        }
+    }
+
+    double in[6], out[6], grad[6], dx[6];
+    for (size_t i = 0; i < 6; ++i) {
+        in[i] = xs[i];
+        grad[i] = 0.5;
+    }
+    activationForward<Kernel>(in, out, 6);
+    activationBackward<Kernel>(in, grad, dx, 6);
+    for (size_t i = 0; i < 6; ++i) {
+        assert(out[i] == Kernel::f(xs[i]));
+        assert(dx[i] == 0.5 * Kernel::df(xs[i]));
+    }
+    std::cout << "✓ " << name << " 内核前向/导数正确" << std::endl;
+}
+
+void testActivationKernels() {
+    std::cout << "\n=== 测试激活函数内核 ===" << std::endl;
+
+    checkActivationKernel<ReLUKernel>("ReLU");
+    checkActivationKernel<LeakyReLUKernel>("LeakyReLU");
+    checkActivationKernel<SigmoidKernel>("Sigmoid");
+    checkActivationKernel<TanhKernel>("Tanh");
+    checkActivationKernel<GELUKernel>("GELU");
+
+    Tensor t(1, 1, 4);
+    t.data() = {-2.0, -1.0, 1.0, 2.0};
+    Tensor squared = t.map([](double x) { return x * x; });
+    t.apply([](double x) { return ReLUKernel::f(x); });
+    assert(squared(0, 0, 0) == 4.0 && t(0, 0, 0) == 0.0 && t(0, 0, 3) == 2.0);
+    std::cout << "✓ 模板 apply/map" << std::endl;
+
+    CNNNetwork network;
+    network.setInputSize(1, 6, 6);
+    network.addConvLayer(2, 3, 1, 1, CNNActivationType::GELU);
+    network.addDenseLayer(2, ActivationType::Sigmoid);
+    network.build();
+    Tensor input(1, 6, 6, 0.3);
+    double loss = network.train({input}, {{1.0, 0.0}}, 0.05);
+    assert(loss >= 0.0);
+    std::cout << "✓ GELU 卷积层训练成功，损失: " << loss << std::endl;
+}
+
+template <MathPrecision P>
+void checkFastMathBudget(const char* name, double budget) {
+    double maxExpRel = 0.0, maxSigmoidAbs = 0.0, maxTanhAbs = 0.0;
+    for (double x = -700.0; x <= 700.0; x += 0.0137) {
+        double ref = std::exp(x);
+        maxExpRel = std::max(maxExpRel, std::abs(expApprox<P>(x) - ref) / ref);
+    }
+    for (double x = -40.0; x <= 40.0; x += 0.0007) {
+        maxSigmoidAbs = std::max(maxSigmoidAbs, std::abs(sigmoidApprox<P>(x) - 1.0 / (1.0 + std::exp(-x))));
+        maxTanhAbs = std::max(maxTanhAbs, std::abs(tanhApprox<P>(x) - std::tanh(x)));
+    }
+    assert(maxExpRel < budget && maxSigmoidAbs < budget && maxTanhAbs < budget);
+    std::cout << "✓ " << name << " exp 相对误差 " << maxExpRel
+              << ", sigmoid 绝对误差 " << maxSigmoidAbs
+              << ", tanh 绝对误差 " << maxTanhAbs << " (预算 " << budget << ")" << std::endl;
+}
+
+void testFastMath() {
+    std::cout << "\n=== 测试快速数学函数误差预算 ===" << std::endl;
+
+    checkFastMathBudget<MathPrecision::High>("High", 1e-7);
+    checkFastMathBudget<MathPrecision::Fast>("Fast", 1e-4);
+
+    // 批量版本与标量版本一致
+    double xs[5] = {-3.0, -0.5, 0.0, 0.5, 3.0};
+    double ys[5];
+    expApprox<MathPrecision::Fast>(xs, ys, 5);
+    for (size_t i = 0; i < 5; ++i) {
+        assert(ys[i] == expApprox<MathPrecision::Fast>(xs[i]));
+    }
+    std::cout << "✓ 批量版本一致" << std::endl;
+
+    // 按网络切换精度
+    NeuralNetwork network;
+    network.setInputSize(3);
+    network.addLayer(8, ActivationType::Tanh);
+    network.addLayer(2, ActivationType::Sigmoid);
+    network.build();
+    std::vector<double> input = {0.3, -0.7, 1.2};
+    std::vector<double> exact = network.forward(input);
+    network.setMathPrecision(MathPrecision::Fast);
+    assert(network.mathPrecision() == MathPrecision::Fast);
+    std::vector<double> fast = network.forward(input);
+    for (size_t i = 0; i < exact.size(); ++i) {
+        assert(std::abs(exact[i] - fast[i]) < 1e-3);
+    }
+    std::cout << "✓ MLP 切换到 Fast 精度，输出偏差 < 1e-3" << std::endl;
+
+    Tensor scores(1, 2, 4);
+    for (size_t i = 0; i < scores.size(); ++i) scores.data()[i] = 0.3 * static_cast<double>(i) - 1.0;
+    Tensor approx = scores;
+    scores.softmax();
+    approx.softmax(MathPrecision::High);
+    for (size_t i = 0; i < scores.size(); ++i) {
+        assert(std::abs(scores.data()[i] - approx.data()[i]) < 1e-7);
+    }
+    std::cout << "✓ softmax High 精度" << std::endl;
+}
+
+// 数值梯度校验: loss = sum(output * G)，比较 backward 返回的 dInput 与中心差分
+double maxAttentionGradError(size_t d_model, size_t heads, size_t seqLen,
+                             bool causal = false, bool rotary = false,
+                             const AttentionPattern& pattern = AttentionPattern::dense()) {
+    AttentionLayer layer(d_model, d_model, heads);
+    layer.setCausal(causal);
+    layer.setRotary(rotary);
+    layer.setPattern(pattern);
+    Tensor input(1, seqLen, d_model);
+    input.randomInit(-1.0, 1.0);
+    Tensor G(1, seqLen, d_model);
+    G.randomInit(-1.0, 1.0);
+
+    layer.forward(input);
+    Tensor dInput = layer.backward(G, 0.0);
+
+    auto lossAt = [&](const Tensor& x) {
+        Tensor out = layer.forward(x);
+        double loss = 0.0;
+        for (size_t i = 0; i < out.size(); ++i) loss += out.data()[i] * G.data()[i];
+        return loss;
+    };
+
+    const double eps = 1e-5;
+    double maxError = 0.0;
+    for (size_t i = 0; i < input.size(); i += 13) {
+        Tensor plus = input, minus = input;
+        plus.data()[i] += eps;
+        minus.data()[i] -= eps;
+        double numeric = (lossAt(plus) - lossAt(minus)) / (2.0 * eps);
+        maxError = std::max(maxError, std::abs(numeric - dInput.data()[i]));
+    }
+    return maxError;
+}
+
+void testMultiHeadAttention() {
+    std::cout << "\n=== 测试多头注意力 ===" << std::endl;
+
+    // 线程池（显式指定工作线程数，单核机器上也会走多线程路径）
+    ThreadPool pool(3);
+    std::vector<int> hits(1000, 0);
+    pool.parallelFor(hits.size(), [&](size_t i) { hits[i]++; });
+    for (int h : hits) assert(h == 1);
+    std::atomic<int> nested{0};
+    pool.parallelFor(4, [&](size_t) {
+        pool.parallelFor(8, [&](size_t) { nested++; });
+    });
+    assert(nested == 32);
+    bool rethrown = false;
+    try {
+        pool.parallelFor(16, [](size_t i) { if (i == 5) throw std::runtime_error("task failed"); });
+    } catch (const std::runtime_error&) {
+        rethrown = true;
+    }
+    assert(rethrown);
+    std::cout << "✓ 线程池 parallelFor（嵌套调用、异常传播）" << std::endl;
+
+    // 形状与每个头的 softmax 归一化
+    AttentionLayer layer(8, 8, 2);
+    Tensor input(1, 5, 8);
+    input.randomInit(-1.0, 1.0);
+    Tensor out = layer.forward(input);
+    assert(out.height() == 5 && out.width() == 8);
+    assert(layer.getWeights().channels() == 2 && layer.getWeights().height() == 5);
+    assert(layer.getQ().width() == 8 && layer.getQ().height() == 5);
+    for (size_t h = 0; h < 2; ++h) {
+        TensorView w = layer.getHeadWeights(h);
+        for (size_t r = 0; r < 5; ++r) {
+            double sum = 0.0;
+            for (size_t c = 0; c < 5; ++c) sum += w(0, r, c);
+            assert(std::abs(sum - 1.0) < 1e-9);
+        }
+    }
+    std::cout << "✓ 每个头的注意力权重按行归一化" << std::endl;
+
+    // 反向传播梯度（串行与线程池并行两种路径）
+    double serialError = maxAttentionGradError(8, 2, 5);
+    double parallelError = maxAttentionGradError(64, 4, 32);
+    assert(serialError < 1e-6 && parallelError < 1e-6);
+    std::cout << "✓ dInput 与数值梯度一致 (误差 " << serialError << ", " << parallelError << ")" << std::endl;
+
+    bool threw = false;
+    try {
+        AttentionLayer bad(8, 8, 3);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "✓ d_k 不能被头数整除时抛出异常" << std::endl;
+
+    // 网络级别
+    AttentionNetwork network(6, 16, 16, 32, 2, 4);
+    assert(network.getNumHeads() == 4);
+    Tensor seq(1, 6, 1);
+    for (size_t i = 0; i < 6; ++i) seq(0, i, 0) = 0.1 * static_cast<double>(i);
+    network.forward(seq);
+    double loss = network.backward(seq, 0.01);
+    assert(std::isfinite(loss));
+    std::cout << "✓ 4 头 AttentionNetwork 前向/反向, loss = " << loss << std::endl;
+}
+
+void testTiledAttention() {
+    std::cout << "\n=== 测试分块 (flash-style) 注意力 ===" << std::endl;
+
+    // 序列长度跨越多个分块且不是分块大小的整数倍
+    const size_t L = 2 * AttentionLayer::kTile + 7;
+    AttentionLayer layer(8, 8, 2);
+    Tensor input(1, L, 8);
+    input.randomInit(-2.0, 2.0);
+    layer.forward(input);
+
+    // 按需物化的权重与朴素 softmax(QK^T / sqrt(d)) 一致
+    double maxError = 0.0;
+    for (size_t h = 0; h < layer.numHeads(); ++h) {
+        TensorView Q = layer.getQ().window(0, h * layer.headDim(), L, layer.headDim());
+        TensorView K = layer.getK().window(0, h * layer.headDim(), L, layer.headDim());
+        Tensor reference = matmul(Q, K.transposed());
+        reference *= 1.0 / std::sqrt(static_cast<double>(layer.headDim()));
+        reference.softmax();
+        TensorView weights = layer.getHeadWeights(h);
+        for (size_t i = 0; i < L; ++i) {
+            for (size_t j = 0; j < L; ++j) {
+                maxError = std::max(maxError, std::abs(weights(0, i, j) - reference(0, i, j)));
+            }
+        }
+    }
+    assert(maxError < 1e-12);
+    std::cout << "✓ 物化权重与朴素 softmax 一致 (误差 " << maxError << ")" << std::endl;
+
+    double gradError = maxAttentionGradError(8, 2, L);
+    assert(gradError < 1e-6);
+    std::cout << "✓ 逐块重算的反向传播与数值梯度一致 (误差 " << gradError << ")" << std::endl;
+}
+
+void testIncrementalDecoding() {
+    std::cout << "\n=== 测试 KV 缓存增量解码 ===" << std::endl;
+
+    const size_t L = AttentionLayer::kTile + 9;
+    AttentionNetwork network(L, 16, 16, 32, 2, 2);
+    network.setCausal(true);
+
+    Tensor seq(1, L, 1);
+    seq.randomInit(0.0, 1.0);
+    Tensor full = network.forward(seq);
+
+    // 逐个追加 token，再一次追加多个 token
+    network.resetIncremental();
+    double maxError = 0.0;
+    const size_t split = L - 5;
+    for (size_t t = 0; t < split; ++t) {
+        Tensor token(1, 1, 1, seq(0, t, 0));
+        Tensor out = network.forwardIncremental(token);
+        maxError = std::max(maxError, std::abs(out(0, 0, 0) - full(0, t, 0)));
+    }
+    Tensor tail(1, L - split, 1);
+    for (size_t t = split; t < L; ++t) tail(0, t - split, 0) = seq(0, t, 0);
+    Tensor tailOut = network.forwardIncremental(tail);
+    for (size_t t = split; t < L; ++t) {
+        maxError = std::max(maxError, std::abs(tailOut(0, t - split, 0) - full(0, t, 0)));
+    }
+    assert(network.incrementalLength() == L);
+    assert(maxError < 1e-10);
+    std::cout << "✓ 增量解码与因果完整前向一致 (误差 " << maxError << ")" << std::endl;
+
+    // 因果掩码下的权重为下三角，反向梯度仍然正确
+    AttentionLayer layer(8, 8, 2);
+    layer.setCausal(true);
+    Tensor input(1, 6, 8);
+    input.randomInit(-1.0, 1.0);
+    layer.forward(input);
+    TensorView w = layer.getHeadWeights(1);
+    for (size_t i = 0; i < 6; ++i) {
+        double sum = 0.0;
+        for (size_t j = 0; j < 6; ++j) {
+            if (j > i) assert(w(0, i, j) == 0.0);
+            sum += w(0, i, j);
+        }
+        assert(std::abs(sum - 1.0) < 1e-9);
+    }
+    std::cout << "✓ 因果注意力权重为下三角且按行归一化" << std::endl;
+
+    double gradError = maxAttentionGradError(8, 2, AttentionLayer::kTile + 5, true);
+    assert(gradError < 1e-6);
+    std::cout << "✓ 因果反向传播与数值梯度一致 (误差 " << gradError << ")" << std::endl;
+
+    network.backward(seq, 0.0);
+    network.resetIncremental();
+    assert(network.incrementalLength() == 0);
+    std::cout << "✓ 重置增量状态" << std::endl;
+}
+
+void testBatchedAttention() {
+    std::cout << "\n=== 测试变长批处理与填充掩码 ===" << std::endl;
+
+    AttentionNetwork network(5, 16, 16, 32, 2, 2);
+    const size_t lengths[] = {5, 2, 9, 3, 8, 2};
+    std::vector<Tensor> seqs;
+    for (size_t len : lengths) {
+        Tensor seq(1, len, 1);
+        seq.randomInit(0.0, 1.0);
+        seqs.push_back(seq);
+    }
+
+    // 批处理结果与逐条前向一致（填充位置被掩码）
+    std::vector<Tensor> batched = network.forwardBatch(seqs);
+    std::vector<Tensor> bucketed = network.forwardBucketed(seqs, 2);
+    double maxError = 0.0;
+    for (size_t b = 0; b < seqs.size(); ++b) {
+        Tensor single = network.forward(seqs[b]);
+        assert(batched[b].height() == lengths[b] && bucketed[b].height() == lengths[b]);
+        for (size_t i = 0; i < lengths[b]; ++i) {
+            maxError = std::max(maxError, std::abs(batched[b](0, i, 0) - single(0, i, 0)));
+            maxError = std::max(maxError, std::abs(bucketed[b](0, i, 0) - single(0, i, 0)));
+        }
+    }
+    assert(maxError < 1e-12);
+    std::cout << "✓ forwardBatch / forwardBucketed 与逐条前向一致 (误差 " << maxError << ")" << std::endl;
+
+    auto buckets = AttentionNetwork::bucketByLength(seqs, 2);
+    assert(buckets.size() == 3);
+    assert(seqs[buckets[0][0]].height() == 2 && seqs[buckets[0][1]].height() == 2);
+    assert(seqs[buckets[2][0]].height() == 8 && seqs[buckets[2][1]].height() == 9);
+    std::cout << "✓ 按长度分桶" << std::endl;
+
+    // 全填充的序列不产生梯度：与单条训练的更新结果相同
+    setGlobalSeed(1234);
+    AttentionNetwork single(5, 16, 16, 32, 1, 2);
+    setGlobalSeed(1234);
+    AttentionNetwork padded(5, 16, 16, 32, 1, 2);
+    const Tensor& seq = seqs[2];
+    single.forward(seq);
+    double singleLoss = single.backward(seq, 0.05);
+    padded.forwardBatch({seq, Tensor(1, 0, 1)});
+    double paddedLoss = padded.backwardBatch({seq, Tensor(1, 0, 1)}, 0.05);
+    assert(std::abs(singleLoss - paddedLoss) < 1e-12);
+    Tensor after1 = single.forward(seq);
+    Tensor after2 = padded.forward(seq);
+    for (size_t i = 0; i < seq.height(); ++i) {
+        assert(std::abs(after1(0, i, 0) - after2(0, i, 0)) < 1e-12);
+    }
+    std::cout << "✓ 填充位置梯度为零，批量训练与单条训练一致" << std::endl;
+}
+
+void testPositionalEncodings() {
+    std::cout << "\n=== 测试位置编码缓存与 Learned / RoPE ===" << std::endl;
+
+    // 共享表：前缀视图零拷贝，增长后旧视图仍然有效
+    TensorView small = PositionalEncodingCache::sinusoidal(12, 10);
+    TensorView prefix = PositionalEncodingCache::sinusoidal(12, 5);
+    assert(&prefix(0, 0, 0) == &small(0, 0, 0));
+    for (size_t pos = 0; pos < 10; ++pos) {
+        for (size_t i = 0; i < 12; ++i) {
+            double expected = (i % 2 == 0) ? std::sin(pos / std::pow(10000.0, (double)i / 12))
+                                           : std::cos(pos / std::pow(10000.0, (double)(i - 1) / 12));
+            assert(std::abs(small(0, pos, i) - expected) < 1e-12);
+        }
+    }
+    TensorView large = PositionalEncodingCache::sinusoidal(12, 5000);
+    assert(large.height() == 5000);
+    assert(std::abs(large(0, 9, 3) - small(0, 9, 3)) < 1e-15);
+    assert(std::abs(large(0, 4999, 0) - std::sin(4999.0)) < 1e-9);
+    std::cout << "✓ 按 d_model 共享的正弦表，几何增长 + 前缀视图" << std::endl;
+
+    // Learned 初始值等于正弦编码，训练后会更新
+    Tensor seq(1, 6, 1);
+    seq.randomInit(0.0, 1.0);
+    setGlobalSeed(99);
+    AttentionNetwork sinusoidal(6, 16, 16, 32, 1, 2, PositionalEncodingType::Sinusoidal);
+    setGlobalSeed(99);
+    AttentionNetwork learned(6, 16, 16, 32, 1, 2, PositionalEncodingType::Learned);
+    Tensor a = sinusoidal.forward(seq);
+    Tensor b = learned.forward(seq);
+    for (size_t i = 0; i < 6; ++i) assert(std::abs(a(0, i, 0) - b(0, i, 0)) < 1e-12);
+    learned.backward(seq, 0.1);
+    sinusoidal.backward(seq, 0.1);
+    a = sinusoidal.forward(seq);
+    b = learned.forward(seq);
+    double diff = 0.0;
+    for (size_t i = 0; i < 6; ++i) diff += std::abs(a(0, i, 0) - b(0, i, 0));
+    assert(diff > 0.0);
+    std::cout << "✓ Learned 编码以正弦表初始化并参与训练" << std::endl;
+
+    // RoPE：反向梯度正确，增量解码与完整前向一致
+    double gradError = maxAttentionGradError(8, 2, 9, true, true);
+    assert(gradError < 1e-6);
+    AttentionNetwork rope(8, 16, 16, 32, 2, 2, PositionalEncodingType::Rotary);
+    rope.setCausal(true);
+    Tensor longSeq(1, 8, 1);
+    longSeq.randomInit(0.0, 1.0);
+    Tensor full = rope.forward(longSeq);
+    double maxError = 0.0;
+    for (size_t t = 0; t < 8; ++t) {
+        Tensor out = rope.forwardIncremental(Tensor(1, 1, 1, longSeq(0, t, 0)));
+        maxError = std::max(maxError, std::abs(out(0, 0, 0) - full(0, t, 0)));
+    }
+    assert(maxError < 1e-10);
+    std::cout << "✓ RoPE 梯度 (误差 " << gradError << ") 与增量解码 (误差 " << maxError << ")" << std::endl;
+
+    bool threw = false;
+    try {
+        AttentionLayer odd(6, 6, 2);
+        odd.setRotary(true);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "✓ 奇数头维度拒绝 RoPE" << std::endl;
+}
+
+// TransformerBlock 的 dInput 数值梯度校验（lr = 0，不更新参数）
+double maxBlockGradError(TransformerBlock& block, const Tensor& input) {
+    Tensor G(input.channels(), input.height(), input.width());
+    G.randomInit(-1.0, 1.0);
+    block.forward(input);
+    Tensor dInput = block.backward(G, 0.0);
+
+    auto lossAt = [&](const Tensor& x) {
+        Tensor out = block.forward(x);
+        double loss = 0.0;
+        for (size_t i = 0; i < out.size(); ++i) loss += out.data()[i] * G.data()[i];
+        return loss;
+    };
+
+    const double eps = 1e-5;
+    double maxError = 0.0;
+    for (size_t i = 0; i < input.size(); i += 3) {
+        Tensor plus = input, minus = input;
+        plus.data()[i] += eps;
+        minus.data()[i] -= eps;
+        double numeric = (lossAt(plus) - lossAt(minus)) / (2.0 * eps);
+        maxError = std::max(maxError, std::abs(numeric - dInput.data()[i]));
+    }
+    return maxError;
+}
+
+void testFusedAddLayerNorm() {
+    std::cout << "\n=== 测试融合残差 + LayerNorm ===" << std::endl;
+
+    TransformerBlock block(8, 8, 16, 2);
+    Tensor input(1, 5, 8);
+    input.randomInit(-1.0, 1.0);
+
+    // 初始 gamma = 1, beta = 0：每行输出均值 0、方差 1
+    Tensor out = block.forward(input);
+    for (size_t h = 0; h < out.height(); ++h) {
+        double mean = 0.0, var = 0.0;
+        for (size_t w = 0; w < 8; ++w) mean += out(0, h, w) / 8.0;
+        for (size_t w = 0; w < 8; ++w) var += (out(0, h, w) - mean) * (out(0, h, w) - mean) / 8.0;
+        assert(std::abs(mean) < 1e-9 && std::abs(var - 1.0) < 1e-6);
+    }
+    std::cout << "✓ 输出按行标准化" << std::endl;
+
+    double gradError = maxBlockGradError(block, input);
+    assert(gradError < 1e-6);
+    std::cout << "✓ 使用缓存统计量的反向传播与数值梯度一致 (误差 " << gradError << ")" << std::endl;
+}
+
+void testFusedFeedForward() {
+    std::cout << "\n=== 测试融合 FFN (GEMM + 偏置 + 激活) ===" << std::endl;
+
+    for (FFNActivation act : {FFNActivation::ReLU, FFNActivation::GELU}) {
+        const char* name = (act == FFNActivation::ReLU) ? "ReLU" : "GELU";
+        setGlobalSeed(5);
+        FeedForward ffn(6, 10, act);
+        Tensor x(2, 3, 6);
+        x.randomInit(-1.0, 1.0);
+
+        // 与逐元素实现比较：act(x W1 + b1) W2 + b2（偏置为 0，W 由相同种子重建）
+        setGlobalSeed(5);
+        Tensor W1(1, 6, 10); W1.xavierInit(6, 10);
+        Tensor W2(1, 10, 6); W2.xavierInit(10, 6);
+        Tensor hidden = x.asRows().matmul(W1);
+        for (size_t i = 0; i < hidden.size(); ++i) {
+            double& v = hidden.data()[i];
+            v = (act == FFNActivation::ReLU) ? ReLUKernel::f(v) : GELUKernelT<MathPrecision::Exact>::f(v);
+        }
+        Tensor expected = hidden.matmul(W2);
+
+        Tensor out = ffn.forward(x);
+        Tensor inferred = ffn.infer(x);
+        assert(out.channels() == 1 && out.height() == 6 && out.width() == 6);
+        for (size_t i = 0; i < out.size(); ++i) {
+            assert(std::abs(out.data()[i] - expected.data()[i]) < 1e-12);
+            assert(out.data()[i] == inferred.data()[i]);
+        }
+        std::cout << "✓ " << name << " 前向与分步实现一致" << std::endl;
+
+        // 反向梯度累加到已有的 dInput 上
+        Tensor G(1, 6, 6);
+        G.randomInit(-1.0, 1.0);
+        Tensor dInput(2, 3, 6, 1.0);
+        ffn.backward(G, 0.0, dInput);
+
+        const double eps = 1e-5;
+        double maxError = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            Tensor plus = x, minus = x;
+            plus.data()[i] += eps;
+            minus.data()[i] -= eps;
+            Tensor op = ffn.infer(plus), om = ffn.infer(minus);
+            double numeric = 0.0;
+            for (size_t j = 0; j < op.size(); ++j) numeric += (op.data()[j] - om.data()[j]) * G.data()[j];
+            numeric /= 2.0 * eps;
+            maxError = std::max(maxError, std::abs(1.0 + numeric - dInput.data()[i]));
+        }
+        assert(maxError < 1e-6);
+        std::cout << "✓ " << name << " 融合反向与数值梯度一致 (误差 " << maxError << ")" << std::endl;
+    }
+
+    // 整个 block 在 GELU 下的梯度
+    TransformerBlock block(8, 8, 16, 2);
+    block.setFeedForwardActivation(FFNActivation::GELU);
+    Tensor input(1, 5, 8);
+    input.randomInit(-1.0, 1.0);
+    double gradError = maxBlockGradError(block, input);
+    assert(gradError < 1e-6);
+    std::cout << "✓ GELU TransformerBlock 梯度检查通过 (误差 " << gradError << ")" << std::endl;
+}
+
+void testSparseAttention() {
+    std::cout << "\n=== 测试稀疏注意力模式 ===" << std::endl;
+
+    const size_t L = AttentionLayer::kTile + 11;
+    Tensor input(1, L, 8);
+    input.randomInit(-1.0, 1.0);
+
+    // 窗口覆盖整个序列时与稠密注意力完全一致
+    setGlobalSeed(11);
+    AttentionLayer dense(8, 8, 2);
+    setGlobalSeed(11);
+    AttentionLayer wide(8, 8, 2);
+    wide.setPattern(AttentionPattern::slidingWindow(L));
+    Tensor denseOut = dense.forward(input);
+    Tensor wideOut = wide.forward(input);
+    for (size_t i = 0; i < denseOut.size(); ++i) {
+        assert(std::abs(denseOut.data()[i] - wideOut.data()[i]) < 1e-12);
+    }
+    std::cout << "✓ 全覆盖窗口与稠密注意力一致" << std::endl;
+
+    // 各模式下权重只落在允许的位置上，且每行和为 1
+    const AttentionPattern patterns[] = {
+        AttentionPattern::slidingWindow(3),
+        AttentionPattern::dilated(2, 3),
+        AttentionPattern::windowWithGlobal(2, 2),
+        AttentionPattern{0, 4, 1},
+    };
+    for (const AttentionPattern& pattern : patterns) {
+        for (bool causal : {false, true}) {
+            AttentionLayer layer(8, 8, 2);
+            layer.setPattern(pattern);
+            layer.setCausal(causal);
+            layer.forward(input);
+            TensorView w = layer.getHeadWeights(1);
+            for (size_t i = 0; i < L; ++i) {
+                double sum = 0.0;
+                for (size_t j = 0; j < L; ++j) {
+                    if (!layer.attends(i, j)) assert(w(0, i, j) == 0.0);
+                    sum += w(0, i, j);
+                }
+                assert(std::abs(sum - 1.0) < 1e-9);
+            }
+        }
+    }
+    AttentionLayer windowed(8, 8);
+    windowed.setPattern(AttentionPattern::windowWithGlobal(1, 1));
+    assert(windowed.attends(5, 4) && windowed.attends(5, 6) && !windowed.attends(5, 3));
+    assert(windowed.attends(5, 0) && windowed.attends(0, 9));
+    std::cout << "✓ 权重仅分布在窗口 / 膨胀 / 全局位置上" << std::endl;
+
+    double gradError = std::max({maxAttentionGradError(8, 2, 12, false, false, AttentionPattern::slidingWindow(2)),
+                                 maxAttentionGradError(8, 2, 12, true, false, AttentionPattern::dilated(2, 2)),
+                                 maxAttentionGradError(8, 2, 12, false, true, AttentionPattern::windowWithGlobal(1, 2))});
+    assert(gradError < 1e-6);
+    std::cout << "✓ 稀疏模式反向梯度正确 (误差 " << gradError << ")" << std::endl;
+
+    // 增量解码在同一稀疏模式下与因果完整前向一致
+    AttentionNetwork network(L, 16, 16, 32, 2, 2);
+    network.setCausal(true);
+    network.setAttentionPattern(AttentionPattern::windowWithGlobal(3, 1));
+    Tensor seq(1, L, 1);
+    seq.randomInit(0.0, 1.0);
+    Tensor full = network.forward(seq);
+    network.resetIncremental();
+    double maxError = 0.0;
+    for (size_t t = 0; t < L; ++t) {
+        Tensor out = network.forwardIncremental(Tensor(1, 1, 1, seq(0, t, 0)));
+        maxError = std::max(maxError, std::abs(out(0, 0, 0) - full(0, t, 0)));
+    }
+    assert(maxError < 1e-10);
+    std::cout << "✓ 稀疏模式下增量解码与完整前向一致 (误差 " << maxError << ")" << std::endl;
+
+    bool threw = false;
+    try {
+        windowed.setPattern(AttentionPattern{2, 0, 0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "✓ dilation 为 0 时抛出异常" << std::endl;
+}
+
+// 线性注意力层的输入梯度与数值梯度的最大误差
+double maxLinearAttentionGradError(size_t heads, size_t seqLen, bool causal) {
+    LinearAttentionLayer layer(8, 8, heads);
+    layer.setCausal(causal);
+    Tensor input(1, seqLen, 8);
+    input.randomInit(-1.0, 1.0);
+    Tensor G(1, seqLen, 8);
+    G.randomInit(-1.0, 1.0);
+
+    layer.forward(input);
+    Tensor dInput = layer.backward(G, 0.0);
+
+    auto lossAt = [&](const Tensor& x) {
+        Tensor out = layer.forward(x);
+        double loss = 0.0;
+        for (size_t i = 0; i < out.size(); ++i) loss += out.data()[i] * G.data()[i];
+        return loss;
+    };
+
+    const double eps = 1e-5;
+    double maxError = 0.0;
+    for (size_t i = 0; i < input.size(); i += 5) {
+        Tensor plus = input, minus = input;
+        plus.data()[i] += eps;
+        minus.data()[i] -= eps;
+        double numeric = (lossAt(plus) - lossAt(minus)) / (2.0 * eps);
+        maxError = std::max(maxError, std::abs(numeric - dInput.data()[i]));
+    }
+    return maxError;
+}
+
+void testLinearAttention() {
+    std::cout << "\n=== 测试线性注意力 ===" << std::endl;
+
+    // 与逐对计算 phi(q).phi(k) 的隐式权重一致：输出 = W V W_O，且每行权重和为 1
+    const size_t L = 9;
+    LinearAttentionLayer layer(8, 8, 2);
+    Tensor input(1, L, 8);
+    input.randomInit(-1.0, 1.0);
+    layer.forward(input);
+    for (size_t h = 0; h < 2; ++h) {
+        TensorView w = layer.getHeadWeights(h);
+        for (size_t i = 0; i < L; ++i) {
+            double sum = 0.0;
+            for (size_t j = 0; j < L; ++j) {
+                assert(w(0, i, j) > 0.0);
+                sum += w(0, i, j);
+            }
+            assert(std::abs(sum - 1.0) < 1e-12);
+        }
+    }
+    std::cout << "✓ 隐式注意力权重为正且每行归一化" << std::endl;
+
+    double gradError = std::max({maxLinearAttentionGradError(1, 7, false),
+                                 maxLinearAttentionGradError(2, 11, false),
+                                 maxLinearAttentionGradError(2, 11, true)});
+    assert(gradError < 1e-6);
+    std::cout << "✓ 线性注意力反向梯度正确 (误差 " << gradError << ")" << std::endl;
+
+    // 网络级：线性注意力可选，因果前向与增量解码一致，批量填充不影响结果
+    AttentionNetwork network(16, 16, 16, 32, 2, 2, PositionalEncodingType::Sinusoidal, AttentionType::Linear);
+    assert(network.getAttentionType() == AttentionType::Linear);
+    assert(network.getBlocks()[0].getAttention().type() == AttentionType::Linear);
+    network.setCausal(true);
+    Tensor seq(1, 16, 1);
+    seq.randomInit(0.0, 1.0);
+    Tensor full = network.forward(seq);
+    network.resetIncremental();
+    double maxError = 0.0;
+    for (size_t t = 0; t < 16; ++t) {
+        Tensor out = network.forwardIncremental(Tensor(1, 1, 1, seq(0, t, 0)));
+        maxError = std::max(maxError, std::abs(out(0, 0, 0) - full(0, t, 0)));
+    }
+    assert(maxError < 1e-10);
+    Tensor shortSeq(1, 10, 1);
+    shortSeq.randomInit(0.0, 1.0);
+    std::vector<Tensor> batchOut = network.forwardBatch({seq, shortSeq});
+    Tensor alone = network.forward(shortSeq);
+    for (size_t t = 0; t < 10; ++t) {
+        maxError = std::max(maxError, std::abs(batchOut[1](0, t, 0) - alone(0, t, 0)));
+    }
+    assert(maxError < 1e-10);
+    std::cout << "✓ 线性注意力网络的增量解码与批量前向一致 (误差 " << maxError << ")" << std::endl;
+
+    bool threw = false;
+    try {
+        AttentionNetwork rotary(8, 8, 8, 16, 1, 1, PositionalEncodingType::Rotary, AttentionType::Linear);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        layer.setPattern(AttentionPattern::slidingWindow(2));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "✓ 不支持的 RoPE / 稀疏模式抛出异常" << std::endl;
+}
+
+void testStreamingInference() {
+    std::cout << "\n=== 测试流式推理 (环形 KV 缓存) ===" << std::endl;
+
+    // 窗口 W 的流式输出 = 因果 + 滑动窗口 (W - 1) 的完整前向；分块大小不整除序列长度
+    const size_t W = 8;
+    const size_t L = 45;
+    for (PositionalEncodingType pos : {PositionalEncodingType::Sinusoidal, PositionalEncodingType::Rotary}) {
+        AttentionNetwork network(L, 16, 16, 32, 2, 2, pos);
+        network.setCausal(true);
+        network.setAttentionPattern(AttentionPattern::slidingWindow(W - 1));
+        Tensor seq(1, L, 1);
+        seq.randomInit(0.0, 1.0);
+        Tensor full = network.forward(seq);
+
+        // 流式推理只依赖环形缓存本身，不依赖稀疏模式
+        network.setAttentionPattern(AttentionPattern::dense());
+        StreamingEngine engine(network, W, 3);
+        std::vector<double> streamed;
+        for (size_t t = 0; t < L; ++t) {
+            std::vector<double> out = engine.push(seq(0, t, 0));
+            assert(out.size() == ((t + 1) % 3 == 0 ? 3u : 0u));
+            streamed.insert(streamed.end(), out.begin(), out.end());
+        }
+        std::vector<double> tail = engine.flush();
+        streamed.insert(streamed.end(), tail.begin(), tail.end());
+        assert(streamed.size() == L && engine.pendingCount() == 0);
+
+        double maxError = 0.0;
+        for (size_t t = 0; t < L; ++t) maxError = std::max(maxError, std::abs(streamed[t] - full(0, t, 0)));
+        assert(maxError < 1e-10);
+        std::cout << "✓ " << (pos == PositionalEncodingType::Rotary ? "RoPE" : "Sinusoidal")
+                  << " 流式输出与滑动窗口因果前向一致 (误差 " << maxError << ")" << std::endl;
+    }
+
+    // 长流：内存固定，延迟统计有效
+    AttentionNetwork network(16, 8, 8, 16, 1, 2);
+    StreamingEngine engine(network, 16, 4);
+    const size_t N = 3000;
+    for (size_t t = 0; t < N; ++t) {
+        for (double y : engine.push(std::sin(0.01 * t))) assert(std::isfinite(y));
+    }
+    StreamingLatencyStats stats = engine.latencyStats();
+    assert(stats.tokens == N && stats.chunks == N / 4);
+    assert(network.incrementalLength() == N);
+    assert(stats.p50Micros <= stats.p99Micros && stats.p99Micros <= stats.maxMicros);
+    assert(stats.computeMicrosPerToken > 0.0 && stats.meanMicros >= stats.computeMicrosPerToken * 0.5);
+    std::cout << "✓ " << N << " 个 token 流式处理完成：平均延迟 " << stats.meanMicros << " us, p99 "
+              << stats.p99Micros << " us" << std::endl;
+
+    engine.reset();
+    assert(engine.tokensProcessed() == 0 && network.incrementalLength() == 0);
+
+    // 线性注意力的流式状态本身有界，窗口不影响结果
+    AttentionNetwork linear(16, 8, 8, 16, 1, 2, PositionalEncodingType::Sinusoidal, AttentionType::Linear);
+    linear.setCausal(true);
+    Tensor seq(1, 20, 1);
+    seq.randomInit(0.0, 1.0);
+    Tensor full = linear.forward(seq);
+    StreamingEngine linearEngine(linear, 4, 5);
+    double maxError = 0.0;
+    size_t t = 0;
+    for (size_t i = 0; i < 20; ++i) {
+        for (double y : linearEngine.push(seq(0, i, 0))) maxError = std::max(maxError, std::abs(y - full(0, t++, 0)));
+    }
+    assert(t == 20 && maxError < 1e-10);
+    std::cout << "✓ 线性注意力流式输出与因果前向一致" << std::endl;
+}
+
+void testProgressThrottle() {
+    std::cout << "\n=== 测试训练进度限频合并 ===" << std::endl;
+    using Clock = ProgressThrottle::Clock;
+    const Clock::time_point t0 = Clock::now();
+    auto at = [t0](int micros) { return t0 + std::chrono::microseconds(micros); };
+
+    // 30 Hz：首个点立即刷新，之后一帧（约 33 ms）内的点合并到下一批
+    ProgressThrottle throttle(30.0);
+    assert(throttle.record(1, 1.0, at(0)));
+    std::vector<LossPoint> batch = throttle.takeBatch(at(0));
+    assert(batch.size() == 1 && batch[0].epoch == 1);
+    for (int epoch = 2; epoch <= 100; ++epoch) {
+        assert(!throttle.record(epoch, 1.0 / epoch, at(epoch * 100)));
+    }
+    assert(throttle.hasPending());
+    assert(throttle.record(101, 0.01, at(34000)));
+    batch = throttle.takeBatch(at(34000));
+    assert(batch.size() == 100 && batch.front().epoch == 2 && batch.back().epoch == 101);
+    assert(!throttle.hasPending() && throttle.takeBatch(at(34000)).empty());
+    std::cout << "✓ 一帧内的 100 轮合并为一次刷新" << std::endl;
+
+    // 单帧点数有上限：稀疏化后仍按轮次递增，且末尾为最新一轮
+    ProgressThrottle capped(30.0, 8);
+    capped.record(0, 0.0, at(0));
+    capped.takeBatch(at(0));
+    for (int epoch = 1; epoch <= 10000; ++epoch) capped.record(epoch, 1.0, at(1));
+    batch = capped.takeBatch(at(1));
+    assert(batch.size() <= 17 && batch.size() >= 8 && batch.back().epoch == 10000);
+    for (size_t i = 1; i < batch.size(); ++i) assert(batch[i].epoch > batch[i - 1].epoch);
+    std::cout << "✓ 10000 轮压缩为 " << batch.size() << " 个点，保留最新一轮" << std::endl;
+
+    // 不限频：每轮都刷新
+    ProgressThrottle unthrottled(0.0);
+    for (int epoch = 1; epoch <= 5; ++epoch) {
+        assert(unthrottled.record(epoch, 0.5, at(0)));
+        assert(unthrottled.takeBatch(at(0)).size() == 1);
+    }
+    std::cout << "✓ 频率 <= 0 时逐轮刷新" << std::endl;
+}
+
+void testSnapshotPublishing() {
+    std::cout << "\n=== 测试可视化快照发布 ===" << std::endl;
+
+    // 发布器：未发布时为空；旧快照仍被读者持有时不回收，释放后复用其缓冲区
+    SnapshotPublisher<std::vector<double>> publisher;
+    assert(!publisher.latest() && publisher.version() == 0);
+    auto first = publisher.acquire();
+    first->assign(4, 1.0);
+    const std::vector<double>* firstBuffer = first.get();
+    publisher.publish(std::move(first));
+    std::shared_ptr<const std::vector<double>> held = publisher.latest();
+    assert(held.get() == firstBuffer && publisher.version() == 1);
+
+    auto second = publisher.acquire();
+    assert(second.get() != firstBuffer);
+    second->assign(4, 2.0);
+    const std::vector<double>* secondBuffer = second.get();
+    publisher.publish(std::move(second));
+    assert((*held)[0] == 1.0 && (*publisher.latest())[0] == 2.0);
+    held.reset();
+
+    // 第一份被替换时仍有读者，不会回收；第二份被替换时无人持有，下次 acquire() 复用
+    auto third = publisher.acquire();
+    assert(third.get() != secondBuffer);
+    third->assign(4, 3.0);
+    publisher.publish(std::move(third));
+    assert(publisher.acquire().get() == secondBuffer);
+    std::cout << "✓ 快照按版本发布，无读者的旧快照被回收复用" << std::endl;
+
+    // 并发：读者看到的每份快照都是完整的一代，版本单调不减
+    SnapshotPublisher<std::vector<double>> shared;
+    const int generations = 2000;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&]() {
+        uint64_t lastVersion = 0;
+        while (!done.load()) {
+            uint64_t version = shared.version();
+            assert(version >= lastVersion);
+            lastVersion = version;
+            std::shared_ptr<const std::vector<double>> snap = shared.latest();
+            if (!snap) continue;
+            for (double v : *snap) {
+                if (v != snap->front()) ++torn;
+            }
+        }
+    });
+    for (int g = 1; g <= generations; ++g) {
+        auto snap = shared.acquire();
+        snap->assign(256, static_cast<double>(g));
+        shared.publish(std::move(snap));
+    }
+    done = true;
+    reader.join();
+    assert(torn == 0 && shared.version() == static_cast<uint64_t>(generations));
+    assert(shared.latest()->front() == generations);
+    std::cout << "✓ 并发读写 " << generations << " 代快照，无撕裂读取" << std::endl;
+
+    // MLP：build() 发布初始快照；训练后需显式发布；持有网络锁时仍可读取快照
+    NeuralNetwork mlp;
+    mlp.setInputSize(2);
+    mlp.addLayer(3, ActivationType::Tanh);
+    mlp.addLayer(1, ActivationType::Sigmoid);
+    mlp.build();
+    std::shared_ptr<const NetworkSnapshot> before = mlp.latestSnapshot();
+    assert(before && before->layerSizes == std::vector<int>({2, 3, 1}) && before->layers.size() == 2);
+    mlp.train({{0.0, 1.0}, {1.0, 0.0}}, {{1.0}, {1.0}}, 0.5);
+    assert(mlp.latestSnapshot() == before);
+    mlp.publishSnapshot();
+    std::shared_ptr<const NetworkSnapshot> after = mlp.latestSnapshot();
+    const std::vector<Layer>& layers = mlp.getLayers();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        assert(after->layers[l].weights == layers[l].weights);
+        assert(after->layers[l].output == layers[l].output);
+    }
+    assert(after->layers[0].weights != before->layers[0].weights);
+    std::cout << "✓ MLP 快照与训练后的权重/激活一致，旧快照保持不变" << std::endl;
+
+    // CNN：特征图与全连接层快照
+    CNNNetwork cnn;
+    cnn.setInputSize(1, 6, 6);
+    cnn.addConvLayer(2, 3, 1, 1, CNNActivationType::ReLU);
+    cnn.addPoolingLayer(2, 2, PoolingType::Max);
+    cnn.addDenseLayer(2, ActivationType::Sigmoid);
+    cnn.build();
+    assert(cnn.latestSnapshot()->cnnLayers.size() == 3);
+    Tensor image(1, 6, 6);
+    image.randomInit(0.0, 1.0);
+    cnn.forward(image);
+    cnn.publishSnapshot();
+    {
+        std::lock_guard<std::mutex> lock(cnn.getMutex());
+        std::shared_ptr<const CNNSnapshot> snap = cnn.latestSnapshot();
+        const Tensor& featureMap = cnn.getCNNLayers()[0]->getOutput();
+        assert(snap->cnnLayers[0].output.size() == featureMap.size());
+        assert(snap->cnnLayers[0].outputChannels == 2 && snap->inputHeight == 6);
+        for (size_t i = 0; i < featureMap.size(); ++i) assert(snap->cnnLayers[0].output.rawData()[i] == featureMap.rawData()[i]);
+        assert(snap->denseLayers.size() == 1 && snap->denseLayers[0].output == cnn.getDenseLayers()[0].output);
+    }
+    std::cout << "✓ CNN 快照包含特征图与全连接层状态" << std::endl;
+
+    // 注意力：Q/K/V 与各头权重的副本，与网络后续前向无关
+    AttentionNetwork attention(6, 8, 8, 16, 1, 2);
+    attention.setCausal(true);
+    assert(attention.latestSnapshot() && attention.latestSnapshot()->Q.empty());
+    Tensor seq(1, 6, 1);
+    seq.randomInit(0.0, 1.0);
+    attention.forward(seq);
+    attention.publishSnapshot();
+    std::shared_ptr<const AttentionSnapshot> snap = attention.latestSnapshot();
+    const AttentionLayerBase& attn = attention.getBlocks()[0].getAttention();
+    const Tensor& weights = attn.getWeights();
+    assert(snap->numHeads == 2 && snap->causal && snap->Q.height() == 6 && snap->Q.width() == 8);
+    for (size_t i = 0; i < weights.size(); ++i) assert(snap->weights.rawData()[i] == weights.rawData()[i]);
+    assert(!snap->attends(0, 1) && snap->attends(1, 0));
+    const double q00 = snap->Q(0, 0, 0);
+    Tensor other(1, 6, 1);
+    other.randomInit(2.0, 3.0);
+    attention.forward(other);
+    assert(snap->Q(0, 0, 0) == q00);
+    std::cout << "✓ 注意力快照与之后的前向互不影响" << std::endl;
+}
+
+void testTrainingControl() {
+    std::cout << "\n=== 测试训练暂停/恢复/取消控制 ===" << std::endl;
+    using Clock = std::chrono::steady_clock;
+
+    TrainingControl control;
+    assert(control.checkpoint() && !control.isPaused() && !control.stopRequested());
+
+    // 暂停：训练线程阻塞在 checkpoint() 上，恢复后立即继续
+    control.pause();
+    std::atomic<bool> passed{false};
+    std::atomic<bool> result{false};
+    Clock::time_point resumedAt;
+    Clock::time_point wokeAt;
+    std::thread worker([&]() {
+        result = control.checkpoint();
+        wokeAt = Clock::now();
+        passed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(!passed);
+    resumedAt = Clock::now();
+    control.resume();
+    worker.join();
+    assert(passed && result);
+    const double resumeMicros = std::chrono::duration<double, std::micro>(wokeAt - resumedAt).count();
+    std::cout << "✓ 暂停期间阻塞等待，恢复延迟 " << resumeMicros << " us" << std::endl;
+
+    // 暂停中取消：立即唤醒并返回 false
+    control.pause();
+    passed = false;
+    std::thread cancelled([&]() {
+        result = control.checkpoint();
+        passed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    control.stop();
+    cancelled.join();
+    assert(passed && !result && control.stopRequested() && !control.isPaused());
+    control.reset();
+    assert(control.checkpoint());
+    std::cout << "✓ 暂停中取消立即返回，reset() 后可再次训练" << std::endl;
+
+    // 轮内取消：样本之间检查，已取消时不更新权重
+    NeuralNetwork mlp;
+    mlp.setInputSize(2);
+    mlp.addLayer(1, ActivationType::Sigmoid);
+    mlp.build();
+    const std::vector<double> before = mlp.getLayers()[0].weights;
+    control.stop();
+    assert(mlp.train({{0.0, 1.0}, {1.0, 1.0}}, {{1.0}, {0.0}}, 0.5, &control) == 0.0);
+    assert(mlp.getLayers()[0].weights == before);
+    control.reset();
+    assert(mlp.train({{0.0, 1.0}, {1.0, 1.0}}, {{1.0}, {0.0}}, 0.5, &control) > 0.0);
+    assert(mlp.getLayers()[0].weights != before);
+
+    CNNNetwork cnn;
+    cnn.setInputSize(1, 4, 4);
+    cnn.addConvLayer(1, 3, 1, 1, CNNActivationType::ReLU);
+    cnn.addDenseLayer(1, ActivationType::Sigmoid);
+    cnn.build();
+    control.stop();
+    assert(cnn.train({Tensor(1, 4, 4, 0.5)}, {{1.0}}, 0.1, &control) == 0.0);
+    std::cout << "✓ MLP/CNN 训练在样本之间响应取消" << std::endl;
+}
+
+void testDataPipeline() {
+    std::cout << "\n=== 测试生产者/消费者数据管线 ===" << std::endl;
+
+    // 无锁有界队列：容量取整为 2 的幂，满/空时立即返回，先进先出
+    BoundedQueue<int> queue(5);
+    assert(queue.capacity() == 8);
+    for (int i = 0; i < 8; ++i) {
+        assert(queue.tryPush(int(i)));
+    }
+    int value = -1;
+    assert(!queue.tryPush(int(99)));
+    for (int i = 0; i < 8; ++i) {
+        assert(queue.tryPop(value) && value == i);
+    }
+    assert(!queue.tryPop(value));
+    std::cout << "✓ 有界队列满/空判断与 FIFO 顺序正确" << std::endl;
+
+    // 有限数据集：多个生成线程，每个编号恰好生成一次
+    const size_t total = 2000;
+    DataPipeline<size_t> finite([](size_t index, PhiloxRng&) { return index * 3; }, 4, 16, 7, total);
+    std::vector<int> seen(total, 0);
+    size_t sample = 0;
+    size_t index = 0;
+    size_t count = 0;
+    while (finite.next(sample, &index)) {
+        assert(index < total && sample == index * 3);
+        ++seen[index];
+        ++count;
+    }
+    assert(count == total);
+    for (int s : seen) assert(s == 1);
+    assert(!finite.next(sample));
+    assert(finite.stats().produced == total && finite.stats().consumed == total);
+    std::cout << "✓ 4 个生成线程产出 " << total << " 个样本，无重复无遗漏" << std::endl;
+
+    // 无限数据流：预取的样本在训练需要时已经就绪
+    const size_t seqLen = 5;
+    using SortPair = std::pair<Tensor, Tensor>;
+    DataPipeline<SortPair> stream(
+        [seqLen](size_t, PhiloxRng& gen) {
+            SortPair pair;
+            makeSortSample(seqLen, gen, pair.first, pair.second);
+            return pair;
+        },
+        2, 32, 42);
+    // 等到队列已填满且生成线程已在满队列上等待（限时轮询，不依赖固定的休眠时长）
+    const auto fillDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((stream.stats().produced < stream.prefetchDepth() || stream.stats().producerStalls == 0) &&
+           std::chrono::steady_clock::now() < fillDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(stream.stats().produced >= stream.prefetchDepth());
+    const size_t stallsBefore = stream.stats().consumerStalls;
+    SortPair pair;
+    for (int i = 0; i < 32; ++i) {
+        assert(stream.next(pair));
+        assert(pair.first.channels() == 1 && pair.first.height() == seqLen && pair.first.width() == 1);
+        for (size_t t = 1; t < seqLen; ++t) {
+            assert(pair.second(0, t - 1, 0) <= pair.second(0, t, 0));
+        }
+    }
+    assert(stream.stats().consumerStalls == stallsBefore);
+    assert(stream.stats().producerStalls > 0); // 队列满后生成线程休眠等待
+
+    // 停止：阻塞在满队列上的生成线程立即退出
+    stream.stop();
+    assert(!stream.next(pair));
+    std::cout << "✓ 预取 " << stream.prefetchDepth() << " 个样本，消费无等待；stop() 立即回收线程" << std::endl;
+
+    // 生成函数的异常在消费端重新抛出
+    DataPipeline<int> failing([](size_t index, PhiloxRng&) -> int {
+        if (index == 3) throw std::runtime_error("bad sample");
+        return static_cast<int>(index);
+    }, 1, 4, 1);
+    bool threw = false;
+    try {
+        int out = 0;
+        while (failing.next(out)) {
+        }
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "✓ 生成线程的异常传递到消费者" << std::endl;
+}
+
+void testMappedDataset() {
+    std::cout << "\n=== 测试内存映射二进制数据集 ===" << std::endl;
+    const std::string path = "functional_test_dataset.nnds";
+
+    // 写出 10 个 1x4x5 样本（最后一个为非连续的转置视图），标签为 2 类 one-hot
+    std::vector<Tensor> samples;
+    {
+        DatasetWriter writer(path, 1, 4, 5, 2);
+        for (int i = 0; i < 9; ++i) {
+            Tensor t(1, 4, 5);
+            for (size_t k = 0; k < t.size(); ++k) t.rawData()[k] = i * 0.1 + 0.01 * static_cast<double>(k);
+            writer.append(t, {i % 2 == 0 ? 1.0 : 0.0, i % 2 == 0 ? 0.0 : 1.0});
+            samples.push_back(t);
+        }
+        Tensor wide(1, 5, 4);
+        for (size_t k = 0; k < wide.size(); ++k) wide.rawData()[k] = -0.01 * static_cast<double>(k);
+        writer.append(TensorView(wide).transposed(), {0.5, 0.5});
+        samples.push_back(TensorView(wide).transposed().toTensor());
+        writer.finish();
+        assert(writer.size() == 10);
+    }
+
+    {
+        MappedDataset dataset(path);
+        assert(dataset.size() == 10 && dataset.channels() == 1 && dataset.height() == 4 &&
+               dataset.width() == 5 && dataset.labelSize() == 2);
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            const TensorView view = dataset.sample(i);
+            assert(view.isContiguous());
+            for (size_t h = 0; h < 4; ++h)
+                for (size_t w = 0; w < 5; ++w)
+                    assert(view(0, h, w) == samples[i](0, h, w));
+        }
+        assert(dataset.label(3)[1] == 1.0 && dataset.label(9)[0] == 0.5);
+
+        // 零拷贝：视图直接指向映射区，样本首尾相接且 64 字节对齐
+        const double* first = &dataset.sample(0)(0, 0, 0);
+        assert(&dataset.sample(1)(0, 0, 0) == first + dataset.sampleSize());
+        assert(reinterpret_cast<uintptr_t>(first) % 64 == 0);
+        assert(reinterpret_cast<uintptr_t>(dataset.label(0)) % 64 == 0);
+        bool outOfRange = false;
+        try {
+            dataset.sample(10);
+        } catch (const std::out_of_range&) {
+            outOfRange = true;
+        }
+        assert(outOfRange);
+        std::cout << "✓ 写出/映射往返一致，样本为对齐的零拷贝视图" << std::endl;
+
+        // 打乱的小批量：每轮是一个排列，顺序只由 (seed, 轮次) 决定
+        DatasetBatchReader reader(dataset, 4, 123);
+        DatasetBatchReader same(dataset, 4, 123);
+        assert(reader.batchesPerEpoch() == 3);
+        std::vector<size_t> epoch0;
+        std::vector<size_t> epoch0Again;
+        DatasetBatch batch;
+        std::vector<size_t> batchSizes;
+        while (reader.next(batch)) {
+            batchSizes.push_back(batch.size());
+            for (size_t k = 0; k < batch.size(); ++k) {
+                assert(batch.inputs[k].channels() == 1 && batch.targets[k] == dataset.label(batch.indices[k]));
+                epoch0.push_back(batch.indices[k]);
+            }
+        }
+        while (same.next(batch)) epoch0Again.insert(epoch0Again.end(), batch.indices.begin(), batch.indices.end());
+        assert((batchSizes == std::vector<size_t>{4, 4, 2}));
+        assert(epoch0 == epoch0Again);
+        std::vector<size_t> sorted = epoch0;
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); ++i) assert(sorted[i] == i);
+
+        std::vector<size_t> epoch1;
+        reader.startEpoch();
+        while (reader.next(batch)) epoch1.insert(epoch1.end(), batch.indices.begin(), batch.indices.end());
+        assert(reader.epoch() == 1 && epoch1.size() == 10 && epoch1 != epoch0);
+        std::cout << "✓ 小批量按轮次可复现地打乱，最后一批不满" << std::endl;
+
+        // trainBatch 直接消费映射视图：返回的损失即训练前对同一样本/标签的损失
+        CNNNetwork net;
+        net.setInputSize(1, 4, 5);
+        net.addConvLayer(2, 3, 1, 1, CNNActivationType::ReLU);
+        net.addFlattenLayer();
+        net.addDenseLayer(2, ActivationType::Sigmoid);
+        net.build();
+        DatasetBatchReader ordered(dataset, 1, 0, false);
+        for (size_t i = 0; i < dataset.size(); ++i) {
+            const std::vector<double> label(dataset.label(i), dataset.label(i) + 2);
+            const std::vector<double> before = net.forward(samples[i]);
+            const double expected = net.calculateLoss(before, label);
+            assert(ordered.next(batch) && batch.indices[0] == i);
+            const double loss = net.trainBatch(batch.inputs, batch.targets, 0.05);
+            assert(std::abs(loss - expected) < 1e-12);
+            assert(net.forward(samples[i]) != before);
+        }
+        std::cout << "✓ CNNNetwork::trainBatch 直接训练映射视图" << std::endl;
+    }
+
+    // 截断的文件被拒绝
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+    }
+    bool rejected = false;
+    try {
+        MappedDataset truncated(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::remove(path.c_str());
+    std::cout << "✓ 截断的数据集文件被拒绝" << std::endl;
+}
+
+// 写出无符号字节 IDX 文件（大端序维度）
+static void writeIdxFile(const std::string& path, const std::vector<uint32_t>& dims,
+                         const std::vector<unsigned char>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    const unsigned char magic[4] = {0, 0, 0x08, static_cast<unsigned char>(dims.size())};
+    out.write(reinterpret_cast<const char*>(magic), 4);
+    for (uint32_t dim : dims) {
+        const unsigned char be[4] = {static_cast<unsigned char>(dim >> 24), static_cast<unsigned char>(dim >> 16),
+                                     static_cast<unsigned char>(dim >> 8), static_cast<unsigned char>(dim)};
+        out.write(reinterpret_cast<const char*>(be), 4);
+    }
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+void testIdxDataset() {
+    std::cout << "\n=== 测试 IDX (MNIST) 数据集读取 ===" << std::endl;
+    const std::string imagesPath = "functional_test-images-idx3-ubyte";
+    const std::string labelsPath = "functional_test-labels-idx1-ubyte";
+    const std::string cachePath = "functional_test-idx.nnds";
+
+    // 600 张 3x4 图像（跨越多个并行块），像素 (i + k) % 256，标签 i % 3
+    const size_t count = 600;
+    std::vector<unsigned char> pixels(count * 12);
+    std::vector<unsigned char> rawLabels(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t k = 0; k < 12; ++k) pixels[i * 12 + k] = static_cast<unsigned char>((i + k) % 256);
+        rawLabels[i] = static_cast<unsigned char>(i % 3);
+    }
+    writeIdxFile(imagesPath, {static_cast<uint32_t>(count), 3, 4}, pixels);
+    writeIdxFile(labelsPath, {static_cast<uint32_t>(count)}, rawLabels);
+
+    IdxDataset unit = loadIdxDataset(imagesPath, labelsPath);
+    assert(unit.images.size() == count && unit.numClasses == 3 && !unit.fromCache);
+    assert(unit.images[0].channels() == 1 && unit.images[0].height() == 3 && unit.images[0].width() == 4);
+    for (size_t i = 0; i < count; i += 37) {
+        for (size_t k = 0; k < 12; ++k) {
+            assert(std::abs(unit.images[i].rawData()[k] - pixels[i * 12 + k] / 255.0) < 1e-12);
+        }
+        assert(unit.labels[i][i % 3] == 1.0 && unit.labels[i][(i + 1) % 3] == 0.0);
+    }
+    std::cout << "✓ 并行解码 " << count << " 张图像，归一化到 [0, 1]，标签转为 one-hot" << std::endl;
+
+    IdxLoadOptions options;
+    options.normalization = IdxNormalization::Standardize;
+    options.limit = 100;
+    IdxDataset standardized = loadIdxDataset(imagesPath, labelsPath, options);
+    assert(standardized.images.size() == 100);
+    double sum = 0.0;
+    double square = 0.0;
+    for (const Tensor& image : standardized.images) {
+        for (size_t k = 0; k < image.size(); ++k) {
+            sum += image.rawData()[k];
+            square += image.rawData()[k] * image.rawData()[k];
+        }
+    }
+    const double n = 100.0 * 12.0;
+    assert(std::abs(sum / n) < 1e-9 && std::abs(square / n - 1.0) < 1e-9);
+    std::cout << "✓ limit 截取前 100 个样本，标准化后均值 0、方差 1" << std::endl;
+
+    // 测试集沿用训练集的统计量：全部 600 个样本按前 100 个的均值与标准差归一化
+    IdxLoadOptions testOptions;
+    testOptions.normalization = IdxNormalization::Standardize;
+    testOptions.useStatistics = true;
+    testOptions.statistics = standardized.statistics;
+    IdxDataset test = loadIdxDataset(imagesPath, labelsPath, testOptions);
+    assert(test.statistics.offset == standardized.statistics.offset &&
+           test.statistics.scale == standardized.statistics.scale);
+    for (size_t i = 0; i < count; i += 41) {
+        const double expected = (pixels[i * 12] - standardized.statistics.offset) * standardized.statistics.scale;
+        assert(std::abs(test.images[i].rawData()[0] - expected) < 1e-12);
+    }
+    assert(unit.statistics.offset == 0.0 && unit.statistics.scale == 1.0 / 255.0);
+    std::cout << "✓ 返回归一化参数，测试集可按训练集的均值与标准差归一化" << std::endl;
+
+    // 缓存：首次解码并写出，之后直接读取；源文件更新后缓存失效
+    std::remove(cachePath.c_str());
+    options = IdxLoadOptions();
+    options.cachePath = cachePath;
+    IdxDataset first = loadIdxDataset(imagesPath, labelsPath, options);
+    IdxDataset cached = loadIdxDataset(imagesPath, labelsPath, options);
+    assert(!first.fromCache && cached.fromCache);
+    assert(cached.images.size() == count && cached.numClasses == 3);
+    for (size_t i = 0; i < count; i += 53) {
+        assert(cached.images[i].data() == unit.images[i].data() && cached.labels[i] == unit.labels[i]);
+    }
+    {
+        MappedDataset mapped(buildIdxCache(imagesPath, labelsPath, options));
+        assert(mapped.size() == count && mapped.labelSize() == 3);
+    }
+
+    options.normalization = IdxNormalization::None;
+    assert(!loadIdxDataset(imagesPath, labelsPath, options).fromCache); // 预处理方式不同，重新解码
+    assert(loadIdxDataset(imagesPath, labelsPath, options).fromCache);
+
+    // 标准化缓存：命中时由源像素重新得到统计量；显式统计量改变时重建
+    options.normalization = IdxNormalization::Standardize;
+    IdxStatistics built;
+    buildIdxCache(imagesPath, labelsPath, options, &built);
+    IdxDataset standardCached = loadIdxDataset(imagesPath, labelsPath, options);
+    assert(standardCached.fromCache && standardCached.statistics.offset == built.offset &&
+           standardCached.statistics.scale == built.scale);
+    options.useStatistics = true;
+    options.statistics = standardized.statistics;
+    assert(!loadIdxDataset(imagesPath, labelsPath, options).fromCache);
+    assert(loadIdxDataset(imagesPath, labelsPath, options).fromCache);
+    options.statistics.scale *= 2.0;
+    assert(!loadIdxDataset(imagesPath, labelsPath, options).fromCache);
+    namespace fs = std::filesystem;
+    fs::last_write_time(imagesPath, fs::last_write_time(cachePath) + std::chrono::seconds(5));
+    assert(!loadIdxDataset(imagesPath, labelsPath, options).fromCache);
+    std::cout << "✓ 解码结果缓存为二进制数据集，预处理方式、统计量改变或源文件更新时重建" << std::endl;
+
+    // 格式错误
+    writeIdxFile(labelsPath, {static_cast<uint32_t>(count - 1)}, std::vector<unsigned char>(count - 1, 0));
+    bool mismatch = false;
+    try {
+        loadIdxDataset(imagesPath, labelsPath);
+    } catch (const std::runtime_error&) {
+        mismatch = true;
+    }
+    {
+        std::ofstream gz(labelsPath, std::ios::binary | std::ios::trunc);
+        gz.put(static_cast<char>(0x1f));
+        gz.put(static_cast<char>(0x8b));
+        gz.put(0);
+        gz.put(0);
+    }
+    bool compressed = false;
+    try {
+        loadIdxDataset(imagesPath, labelsPath);
+    } catch (const std::runtime_error& e) {
+        compressed = std::string(e.what()).find("gzip") != std::string::npos;
+    }
+    assert(mismatch && compressed);
+    std::remove(imagesPath.c_str());
+    std::remove(labelsPath.c_str());
+    std::remove(cachePath.c_str());
+    std::cout << "✓ 数量不一致与 gzip 压缩文件给出明确错误" << std::endl;
+}
+
+void testDataTable() {
+    std::cout << "\n=== 测试 CSV 表格数据集 ===" << std::endl;
+
+    // 表头、引号、CRLF、空行与按名称指定目标列
+    const std::string text = "x1, \"x2\" ,label,x3\r\n"
+                             "1.5,2,0,-3e2\r\n"
+                             "\r\n"
+                             "  +4 ,\"5.25\",1,6\n"
+                             "\n";
+    CsvOptions options;
+    options.targetColumns = {"label"};
+    DataTable table = parseCsv(text, options);
+    assert(table.rows() == 2 && table.featureCount() == 3 && table.targetCount() == 1);
+    assert(table.featureNames() == std::vector<std::string>({"x1", "x2", "x3"}));
+    assert(table.targetNames() == std::vector<std::string>({"label"}));
+    assert(table.features(0)[0] == 1.5 && table.features(0)[1] == 2.0 && table.features(0)[2] == -300.0);
+    assert(table.features(1)[0] == 4.0 && table.features(1)[1] == 5.25 && table.features(1)[2] == 6.0);
+    assert(table.targets(0)[0] == 0.0 && table.targets(1)[0] == 1.0);
+    assert(table.features(1) == table.featureData().data() + 3); // 行主序连续存储
+    std::cout << "✓ 表头、引号、CRLF 与空行解析正确，目标列按名称选取" << std::endl;
+
+    // 错误指出行号与列号（行号含表头与空行）
+    auto errorOf = [](const std::string& csv) {
+        try {
+            parseCsv(csv);
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    assert(errorOf("a,b\n1,2\n\n3,abc\n").find("line 4, column 2") != std::string::npos);
+    assert(errorOf("a,b\n1,2\n3\n").find("line 3, column 2") != std::string::npos);
+    assert(errorOf("a,b\n1,2,3\n").find("line 2, column 3") != std::string::npos);
+    assert(errorOf("a,b\n1,\n").find("missing value") != std::string::npos);
+    bool unknownColumn = false;
+    try {
+        CsvOptions missing;
+        missing.targetColumns = {"y"};
+        parseCsv("a,b\n1,2\n", missing);
+    } catch (const std::invalid_argument&) {
+        unknownColumn = true;
+    }
+    assert(unknownColumn);
+    std::cout << "✓ 非数字、缺失字段与列数不符时报告行号和列号" << std::endl;
+
+    // 足够大的输入会被切成多块并行解析，结果与行顺序保持一致
+    const size_t rows = 20000;
+    std::string big = "a;b;c;y\n";
+    for (size_t i = 0; i < rows; ++i) {
+        big += std::to_string(i) + ";" + std::to_string(i * 0.5) + ";" + std::to_string(i % 7) + ";" +
+               std::to_string(i % 2) + (i % 3 == 0 ? "\r\n" : "\n");
+    }
+    CsvOptions semicolon;
+    semicolon.delimiter = ';';
+    DataTable large = parseCsv(big, semicolon);
+    assert(large.rows() == rows && large.featureCount() == 3 && large.targetCount() == 1);
+    for (size_t i = 0; i < rows; i += 997) {
+        assert(large.features(i)[0] == static_cast<double>(i));
+        assert(std::abs(large.features(i)[1] - i * 0.5) < 1e-9);
+        assert(large.features(i)[2] == static_cast<double>(i % 7) && large.targets(i)[0] == static_cast<double>(i % 2));
+    }
+    std::cout << "✓ 并行解析 " << rows << " 行，按行顺序写入连续矩阵" << std::endl;
+
+    // 标准化：均值 0、标准差 1，常数列保持有限值
+    DataTable scaled = DataTable::fromRows({{1.0, 5.0}, {2.0, 5.0}, {3.0, 5.0}}, {{0.0}, {1.0}, {0.0}});
+    DataTable::Standardization stats = scaled.standardize();
+    assert(std::abs(stats.mean[0] - 2.0) < 1e-12 && stats.stddev[1] == 1.0);
+    assert(std::abs(scaled.features(0)[0] + scaled.features(2)[0]) < 1e-12);
+    assert(std::abs(scaled.features(2)[0] - std::sqrt(1.5)) < 1e-12 && scaled.features(1)[1] == 0.0);
+    // 均值远大于离散程度时方差不被相消：1e9 + {0, 1, 2} 的标准差为 sqrt(2/3)，1e8 + {0, 0.001, 0.002} 不为 0
+    DataTable offsetTable = DataTable::fromRows({{1e9, 1e8}, {1e9 + 1.0, 1e8 + 0.001}, {1e9 + 2.0, 1e8 + 0.002}},
+                                                {{0.0}, {1.0}, {0.0}});
+    DataTable::Standardization offsetStats = offsetTable.standardize();
+    assert(std::abs(offsetStats.stddev[0] - std::sqrt(2.0 / 3.0)) < 1e-9);
+    assert(std::abs(offsetStats.stddev[1] - 0.001 * std::sqrt(2.0 / 3.0)) < 1e-7); // 1e8 处的舍入误差约 1e-8
+    assert(std::abs(offsetTable.features(2)[0] - std::sqrt(1.5)) < 1e-6);
+    std::cout << "✓ 特征标准化（常数列不除以零，大偏移下方差准确）" << std::endl;
+
+    // train(DataTable) 与逐行 vector 版本等价
+    TabularData xor4 = makeTabularDataset(TabularDataset::XOR, getRng());
+    DataTable xorTable = DataTable::fromRows(xor4.inputs, xor4.targets);
+    NeuralNetwork network;
+    network.setInputSize(2);
+    network.addLayer(4, ActivationType::Tanh);
+    network.addLayer(1, ActivationType::Sigmoid);
+    network.build();
+    assert(network.train(xorTable, 0.0) == network.train(xor4.inputs, xor4.targets, 0.0));
+    const double before = network.train(xorTable, 0.0);
+    for (int epoch = 0; epoch < 200; ++epoch) network.train(xorTable, 0.5);
+    assert(network.train(xorTable, 0.0) < before);
+    bool sizeMismatch = false;
+    try {
+        network.train(large, 0.1);
+    } catch (const std::invalid_argument&) {
+        sizeMismatch = true;
+    }
+    assert(sizeMismatch);
+    std::cout << "✓ NeuralNetwork::train 直接读取 DataTable，结果与逐行版本一致" << std::endl;
+}
+
+void testAugmentation() {
+    std::cout << "\n=== 测试 CNN 数据增强 ===" << std::endl;
+    // 2 通道 4x4，元素互不相同
+    Tensor image(2, 4, 4);
+    for (size_t i = 0; i < image.size(); ++i) image.rawData()[i] = static_cast<double>(i + 1);
+    PhiloxRng gen(7);
+
+    assert(ImageAugmenter().apply(image, gen).data() == image.data());
+    Tensor flipped = ImageAugmenter().flipHorizontal(1.0).apply(image, gen);
+    Tensor upsideDown = ImageAugmenter().flipVertical(1.0).apply(image, gen);
+    for (size_t c = 0; c < 2; ++c)
+        for (size_t h = 0; h < 4; ++h)
+            for (size_t w = 0; w < 4; ++w) {
+                assert(flipped(c, h, w) == image(c, h, 3 - w));
+                assert(upsideDown(c, h, w) == image(c, 3 - h, w));
+            }
+    std::cout << "✓ 水平 / 垂直翻转" << std::endl;
+
+    // 旋转结果是四种旋转之一，多次抽样覆盖全部四种
+    ImageAugmenter rotation;
+    rotation.rotate90();
+    std::set<int> seenTurns;
+    for (int trial = 0; trial < 40; ++trial) {
+        Tensor rotated = rotation.apply(image, gen);
+        int matched = -1;
+        for (int turns = 0; turns < 4 && matched < 0; ++turns) {
+            bool same = true;
+            for (size_t c = 0; c < 2; ++c)
+                for (size_t y = 0; y < 4; ++y)
+                    for (size_t x = 0; x < 4; ++x) {
+                        size_t sy = y, sx = x; // 逆时针旋转 turns 次后 (y, x) 的来源
+                        for (int t = 0; t < turns; ++t) {
+                            const size_t py = sy;
+                            sy = sx;
+                            sx = 3 - py;
+                        }
+                        same = same && rotated(c, y, x) == image(c, sy, sx);
+                    }
+            if (same) matched = turns;
+        }
+        assert(matched >= 0);
+        seenTurns.insert(matched);
+    }
+    assert(seenTurns.size() == 4);
+    bool nonSquare = false;
+    try {
+        rotation.apply(Tensor(1, 2, 3, 1.0), gen);
+    } catch (const std::invalid_argument&) {
+        nonSquare = true;
+    }
+    assert(nonSquare);
+    std::cout << "✓ 随机 90 度旋转（非正方形图像报错）" << std::endl;
+
+    // 平移：输出为某个 (dy, dx) 的整体平移，移出处补零
+    ImageAugmenter shift;
+    shift.shift(1);
+    for (int trial = 0; trial < 20; ++trial) {
+        Tensor moved = shift.apply(image, gen);
+        bool matched = false;
+        for (int dy = -1; dy <= 1 && !matched; ++dy)
+            for (int dx = -1; dx <= 1 && !matched; ++dx) {
+                bool same = true;
+                for (size_t c = 0; c < 2; ++c)
+                    for (int h = 0; h < 4; ++h)
+                        for (int w = 0; w < 4; ++w) {
+                            const int sh = h - dy;
+                            const int sw = w - dx;
+                            const double expected = (sh >= 0 && sh < 4 && sw >= 0 && sw < 4)
+                                ? image(c, static_cast<size_t>(sh), static_cast<size_t>(sw)) : 0.0;
+                            same = same && moved(c, static_cast<size_t>(h), static_cast<size_t>(w)) == expected;
+                        }
+                matched = same;
+            }
+        assert(matched);
+    }
+    std::cout << "✓ 随机平移，移出区域补零" << std::endl;
+
+    // 裁剪缩放：尺寸不变，双线性插值不超出原值范围；scale = 1 时不变
+    Tensor cropped = ImageAugmenter().crop(0.5).apply(image, gen);
+    assert(cropped.channels() == 2 && cropped.height() == 4 && cropped.width() == 4);
+    for (size_t c = 0; c < 2; ++c) {
+        const double low = c * 16 + 1.0;
+        for (size_t i = 0; i < 16; ++i) {
+            const double v = cropped.rawData()[c * 16 + i];
+            assert(v >= low - 1e-12 && v <= low + 15.0 + 1e-12);
+        }
+    }
+    assert(ImageAugmenter().crop(1.0).apply(image, gen).data() == image.data());
+    std::cout << "✓ 随机裁剪并缩放回原尺寸" << std::endl;
+
+    // 噪声：差值均值约为 0、标准差约为设定值
+    Tensor flat(1, 64, 64, 0.5);
+    Tensor noisy = ImageAugmenter().noise(0.1).apply(flat, gen);
+    double mean = 0.0;
+    double square = 0.0;
+    for (size_t i = 0; i < noisy.size(); ++i) {
+        const double d = noisy.rawData()[i] - 0.5;
+        mean += d;
+        square += d * d;
+    }
+    mean /= noisy.size();
+    const double stddev = std::sqrt(square / noisy.size() - mean * mean);
+    assert(std::abs(mean) < 0.01 && std::abs(stddev - 0.1) < 0.01);
+    std::cout << "✓ 高斯噪声" << std::endl;
+
+    // 配置字符串、非连续视图输入与可复现性
+    ImageAugmenter composed = ImageAugmenter::fromSpec(" flip_h, flip_v=0.25,rot90, shift=2,crop,noise=0.01 ");
+    assert(composed.size() == 6);
+    assert(ImageAugmenter::fromSpec(composed.spec()).spec() == composed.spec());
+    assert(ImageAugmenter::fromSpec("none").empty() && ImageAugmenter::fromSpec("").empty());
+    int rejected = 0;
+    for (const char* bad : {"mirror", "shift=1.5", "crop=0", "flip_h=2", "noise=x", "rot90=1"}) {
+        try {
+            ImageAugmenter::fromSpec(bad);
+        } catch (const std::invalid_argument&) {
+            ++rejected;
+        }
+    }
+    assert(rejected == 6);
+    TensorView transposed = TensorView(image).transposed();
+    PhiloxRng genA(123);
+    PhiloxRng genB(123);
+    Tensor a = composed.apply(transposed, genA);
+    Tensor b = composed.apply(transposed.toTensor(), genB);
+    assert(a.data() == b.data());
+    std::cout << "✓ 由配置组合步骤，相同种子结果一致，支持非连续视图" << std::endl;
+
+    // 增强管线：多个生成线程循环遍历数据集，数据集本身不被修改
+    std::vector<Tensor> dataset;
+    for (int i = 0; i < 10; ++i) dataset.emplace_back(1, 8, 8, static_cast<double>(i));
+    auto pipeline = makeAugmentationPipeline(
+        ImageAugmenter::fromSpec("flip_h,shift=1"), [&](size_t i) { return TensorView(dataset[i]); },
+        dataset.size(), 2, 8, 42, 30);
+    std::vector<int> seen(10, 0);
+    Tensor sample;
+    size_t index = 0;
+    size_t received = 0;
+    while (pipeline->next(sample, &index)) {
+        const size_t original = index % dataset.size();
+        ++seen[original];
+        for (size_t k = 0; k < sample.size(); ++k) {
+            const double v = sample.rawData()[k];
+            assert(v == 0.0 || v == static_cast<double>(original));
+        }
+        ++received;
+    }
+    assert(received == 30);
+    for (int count : seen) assert(count == 3);
+    for (int i = 0; i < 10; ++i) assert(dataset[static_cast<size_t>(i)].min() == static_cast<double>(i));
+    std::cout << "✓ 生成线程即时增强，按编号循环遍历数据集 3 轮" << std::endl;
+}
+
+void testCounterRng() {
+    std::cout << "\n=== 测试计数器随机流与打乱采样 ===" << std::endl;
+    // Philox4x32-10 参考向量
+    const auto zero = PhiloxRng::block({0, 0, 0, 0}, {0, 0});
+    assert(zero[0] == 0x6627e8d5u && zero[1] == 0xe169c58du && zero[2] == 0xbc57ac4cu && zero[3] == 0x9b00dbd8u);
+    const auto ones = PhiloxRng::block({~0u, ~0u, ~0u, ~0u}, {~0u, ~0u});
+    assert(ones[0] == 0x408f276du && ones[1] == 0x41c83b0eu && ones[2] == 0xa20bc7c6u && ones[3] == 0x6d5451fdu);
+
+    // seek 直接跳到任意位置；子流互不相同，相同编号的子流相同
+    PhiloxRng rng(5, 3);
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 10; ++i) values.push_back(rng());
+    PhiloxRng jumped(5, 3);
+    jumped.seek(7);
+    assert(jumped() == values[7] && jumped() == values[8] && jumped.position() == 9);
+    jumped.seek(2);
+    assert(jumped() == values[2]);
+    assert(rng.stream(0)() != rng.stream(1)() && rng.stream(4)() == PhiloxRng(5, 3).stream(4)());
+    assert(PhiloxRng(6, 3)() != values[0]);
+    for (int i = 0; i < 1000; ++i) {
+        const double u = rng.uniform();
+        assert(u >= 0.0 && u < 1.0 && rng.uniformIndex(7) < 7);
+    }
+    std::cout << "✓ Philox 参考向量、seek 与子流" << std::endl;
+
+    // 线程专属流：种子相同则可复现，不同线程的流不同
+    setGlobalSeed(21);
+    const uint64_t mainFirst = getRng()();
+    setGlobalSeed(21);
+    assert(getRng()() == mainFirst);
+    uint64_t otherFirst = 0;
+    std::thread([&]() { otherFirst = getRng()(); }).join();
+    assert(otherFirst != mainFirst);
+    std::cout << "✓ getRng() 按线程独立，随全局种子复现" << std::endl;
+
+    // 采样器：每轮是一个排列，各轮不同，可直接跳回任意一轮
+    ShuffledBatchSampler sampler(103, 10, PhiloxRng(8));
+    assert(sampler.batchesPerEpoch() == 11);
+    std::vector<std::vector<size_t>> epochs;
+    std::vector<size_t> batch;
+    for (int e = 0; e < 3; ++e) {
+        std::vector<size_t> order;
+        size_t batches = 0;
+        while (sampler.next(batch)) {
+            assert(batch.size() == (batches + 1 < sampler.batchesPerEpoch() ? 10u : 3u));
+            order.insert(order.end(), batch.begin(), batch.end());
+            ++batches;
+        }
+        std::vector<size_t> sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); ++i) assert(sorted[i] == i);
+        epochs.push_back(order);
+        sampler.nextEpoch();
+    }
+    assert(epochs[0] != epochs[1] && epochs[1] != epochs[2]);
+    sampler.setEpoch(1);
+    assert(sampler.order() == epochs[1]);
+    ShuffledBatchSampler ordered(5, 2, PhiloxRng(8), false);
+    assert(ordered.next(batch) && batch == std::vector<size_t>({0, 1}));
+    std::cout << "✓ 打乱的小批量覆盖全部样本，第 e 轮的顺序可单独重建" << std::endl;
+
+    // 相同种子的网络逐位一致；大层并行初始化，第 j 行仍等于 stream(j) 的输出
+    Layer big(512, 160, ActivationType::Sigmoid, PhiloxRng(3));
+    Layer again(512, 160, ActivationType::Sigmoid, PhiloxRng(3));
+    assert(big.weights == again.weights && big.biases == again.biases);
+    const double limit = std::sqrt(6.0 / (512.0 + 160.0));
+    PhiloxRng row = PhiloxRng(3).stream(77);
+    assert(big.weight(77, 0) == row.uniform(-limit, limit));
+
+    auto makeMlp = [](uint64_t seed, bool shuffle) {
+        auto net = std::make_unique<NeuralNetwork>();
+        net->setSeed(seed);
+        net->setShuffle(shuffle);
+        net->setInputSize(2);
+        net->addLayer(6, ActivationType::Tanh);
+        net->addLayer(1, ActivationType::Sigmoid);
+        net->build();
+        return net;
+    };
+    TabularData xor4 = makeTabularDataset(TabularDataset::XOR, getRng());
+    DataTable table = DataTable::fromRows(xor4.inputs, xor4.targets);
+    auto netA = makeMlp(9, true);
+    auto netB = makeMlp(9, true);
+    auto fixed = makeMlp(9, false);
+    assert(netA->getLayers()[0].weights == fixed->getLayers()[0].weights);
+    assert(makeMlp(10, false)->getLayers()[0].weights != fixed->getLayers()[0].weights);
+    for (int epoch = 0; epoch < 20; ++epoch) {
+        assert(netA->train(table, 0.5) == netB->train(table, 0.5));
+        fixed->train(table, 0.5);
+    }
+    assert(netA->getLayers()[0].weights == netB->getLayers()[0].weights);
+    assert(netA->getLayers()[0].weights != fixed->getLayers()[0].weights);
+
+    auto makeCnn = [](uint64_t seed) {
+        auto cnn = std::make_unique<CNNNetwork>();
+        cnn->setSeed(seed);
+        cnn->setInputSize(1, 8, 8);
+        cnn->addConvLayer(16, 3, 1, 1);
+        cnn->addDenseLayer(3, ActivationType::Sigmoid);
+        cnn->build();
+        return cnn;
+    };
+    auto cnnA = makeCnn(4);
+    auto cnnB = makeCnn(4);
+    const auto kernelsA = cnnA->getAllKernels();
+    const auto kernelsB = cnnB->getAllKernels();
+    for (size_t k = 0; k < kernelsA[0].size(); ++k) assert(kernelsA[0][k].data() == kernelsB[0][k].data());
+    assert(cnnA->getDenseLayers()[0].weights == cnnB->getDenseLayers()[0].weights);
+    std::cout << "✓ 相同种子的网络初始权重一致，打乱训练逐位可复现" << std::endl;
+
+    // 管线样本只由种子与编号决定；nextInOrder() 按编号取出，顺序也与生成线程数无关
+    auto collect = [](size_t workers) {
+        DataPipeline<double> pipeline([](size_t, PhiloxRng& gen) { return gen.normal(); }, workers, 8, 17, 200);
+        std::vector<double> inOrder;
+        double value = 0.0;
+        size_t index = 0;
+        while (pipeline.nextInOrder(value, &index)) {
+            assert(index == inOrder.size());
+            inOrder.push_back(value);
+        }
+        return inOrder;
+    };
+    const std::vector<double> single = collect(1);
+    assert(single.size() == 200 && single == collect(4));
+    std::cout << "✓ 数据管线的样本与顺序均与生成线程数无关" << std::endl;
+}
+
 int main() {
     std::cout << "==========================================" << std::endl;
     std::cout << "  Neural Network 自动化功能测试" << std::endl;
@@ -241,6 +2153,30 @@ int main() {
         testCNNBasicFunctionality();
         testCNNEdgeCases();
         testTensorOperations();
+        testTensorReshapeView();
+        testTensorViewSlicing();
+        testTensorExpressionTemplates();
+        testActivationKernels();
+        testFastMath();
+        testMultiHeadAttention();
+        testTiledAttention();
+        testIncrementalDecoding();
+        testBatchedAttention();
+        testPositionalEncodings();
+        testFusedAddLayerNorm();
+        testFusedFeedForward();
+        testSparseAttention();
+        testLinearAttention();
+        testStreamingInference();
+        testSnapshotPublishing();
+        testProgressThrottle();
+        testTrainingControl();
+        testDataPipeline();
+        testMappedDataset();
+        testIdxDataset();
+        testDataTable();
+        testAugmentation();
+        testCounterRng();
         testAttentionCrash();
         
         std::cout << "\n==========================================" << std::endl;
@@ -0,0 +1,511 @@
+#include "neural_network.h"
+#include "cnn/augmentation.h"
+#include "cnn/cnn_network.h"
+#include "cnn/random.h"
+#include "attention/attention_network.h"
+#include "progress_throttle.h"
+#include "synthetic_datasets.h"
+#include "data_pipeline.h"
+#include "mapped_dataset.h"
+#include "idx_dataset.h"
+#include "data_table.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// 无界面训练器：按配置文件构建 MLP / CNN / 注意力网络，在与可视化程序相同的合成数据集上训练，
+// 输出损失曲线 (CSV) 与吞吐量。只链接核心引擎源文件，可在没有 Qt 的计算节点上运行。
+//
+// 用法: HeadlessTrainer <config> [key=value ...]
+// 配置为每行一个 key = value，# 之后为注释；命令行上的 key=value 覆盖文件中的值。
+
+class Config {
+public:
+    void set(const std::string& key, const std::string& value) { values_[key] = value; }
+
+    std::string getString(const std::string& key, const std::string& fallback) const {
+        used_.insert(key);
+        auto it = values_.find(key);
+        return it == values_.end() ? fallback : it->second;
+    }
+    int getInt(const std::string& key, int fallback) const {
+        std::string value = getString(key, "");
+        return value.empty() ? fallback : std::stoi(value);
+    }
+    double getDouble(const std::string& key, double fallback) const {
+        std::string value = getString(key, "");
+        return value.empty() ? fallback : std::stod(value);
+    }
+
+    // 未被读取的键（多为拼写错误）
+    std::vector<std::string> unusedKeys() const {
+        std::vector<std::string> unused;
+        for (const auto& entry : values_) {
+            if (!used_.count(entry.first)) unused.push_back(entry.first);
+        }
+        return unused;
+    }
+
+private:
+    std::map<std::string, std::string> values_;
+    mutable std::set<std::string> used_;
+};
+
+static std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+static bool parseAssignment(const std::string& line, Config& config) {
+    const std::string content = trim(line.substr(0, line.find('#')));
+    if (content.empty()) return true;
+    const size_t eq = content.find('=');
+    if (eq == std::string::npos) return false;
+    const std::string key = trim(content.substr(0, eq));
+    if (key.empty()) return false;
+    config.set(key, trim(content.substr(eq + 1)));
+    return true;
+}
+
+static Config loadConfig(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open config file: " + path);
+    }
+    Config config;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!parseAssignment(line, config)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected key = value");
+        }
+    }
+    return config;
+}
+
+struct TrainingRun {
+    std::string description;
+    std::vector<LossPoint> curve;
+    size_t samplesPerEpoch = 0;
+    size_t tokensPerSample = 1;
+    double seconds = 0.0;
+    size_t testSamples = 0;     // 测试集样本数，0 表示未评估
+    double testAccuracy = 0.0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// 逐轮训练并记录损失；每 logEvery 轮打印一次
+template <typename TrainEpoch>
+static void runEpochs(int epochs, int logEvery, TrainingRun& run, TrainEpoch&& trainEpoch) {
+    run.curve.reserve(static_cast<size_t>(epochs));
+    const Clock::time_point start = Clock::now();
+    for (int epoch = 1; epoch <= epochs; ++epoch) {
+        const double loss = trainEpoch();
+        run.curve.push_back({epoch, loss});
+        if (logEvery > 0 && (epoch % logEvery == 0 || epoch == epochs)) {
+            std::cout << "Epoch " << epoch << "/" << epochs << " - Loss: " << std::fixed
+                      << std::setprecision(6) << loss << std::endl;
+        }
+    }
+    run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static ActivationType activationFromName(const std::string& name) {
+    if (name == "sigmoid") return ActivationType::Sigmoid;
+    if (name == "relu") return ActivationType::ReLU;
+    if (name == "tanh") return ActivationType::Tanh;
+    throw std::invalid_argument("Unknown activation: " + name);
+}
+
+static TrainingRun trainMLP(const Config& config, PhiloxRng& gen) {
+    // csv_file 指定时从 CSV 读取（目标列为 csv_target，缺省为最后一列），否则使用合成数据集
+    std::string datasetName = config.getString("dataset", "xor");
+    DataTable data;
+    const std::string csvFile = config.getString("csv_file", "");
+    if (!csvFile.empty()) {
+        CsvOptions options;
+        const std::string target = config.getString("csv_target", "");
+        if (!target.empty()) options.targetColumns.push_back(target);
+        options.standardize = config.getInt("csv_standardize", 1) != 0;
+        const auto loadStart = std::chrono::steady_clock::now();
+        data = loadCsv(csvFile, options);
+        const double loadSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+        std::cout << "Loaded " << data.rows() << " rows x " << data.featureCount() << " features from "
+                  << csvFile << " in " << std::fixed << std::setprecision(3) << loadSeconds << " s\n";
+        datasetName = csvFile;
+    } else {
+        TabularData rows = makeTabularDataset(tabularDatasetFromName(datasetName), gen,
+                                              config.getInt("circle_samples", 100));
+        data = DataTable::fromRows(rows.inputs, rows.targets);
+    }
+
+    const int hiddenLayers = config.getInt("hidden_layers", 2);
+    const int neurons = config.getInt("neurons", 8);
+    const ActivationType activation = activationFromName(config.getString("activation", "sigmoid"));
+    const int inputSize = static_cast<int>(data.featureCount());
+    const int outputSize = static_cast<int>(data.targetCount());
+
+    NeuralNetwork network;
+    network.setInputSize(inputSize);
+    for (int i = 0; i < hiddenLayers; ++i) {
+        network.addLayer(neurons, activation);
+    }
+    network.addLayer(outputSize, ActivationType::Sigmoid);
+    network.build();
+    // shuffle=1：每轮按新的随机顺序遍历样本（顺序由 seed 与轮次决定）
+    network.setShuffle(config.getInt("shuffle", 0) != 0);
+
+    TrainingRun run;
+    run.description = "MLP " + std::to_string(inputSize) + "-" + std::to_string(hiddenLayers) + "x" +
+                      std::to_string(neurons) + "-" + std::to_string(outputSize) + " on " + datasetName;
+    run.samplesPerEpoch = data.rows();
+
+    const double learningRate = config.getDouble("learning_rate", 0.5);
+    runEpochs(config.getInt("epochs", 1000), config.getInt("log_every", 100), run, [&]() {
+        return network.train(data, learningRate);
+    });
+    return run;
+}
+
+static TrainingRun trainCNN(const Config& config, PhiloxRng& gen) {
+    const int kernelSize = config.getInt("kernel_size", 3);
+
+    // 数据来源：dataset_file 为内存映射的二进制数据集；idx_images/idx_labels 为 MNIST 等 IDX 文件
+    // （指定 idx_cache 时解码结果缓存为二进制数据集并映射训练）；否则生成合成形状数据集
+    std::string datasetFile = config.getString("dataset_file", "");
+    const std::string idxImages = config.getString("idx_images", "");
+    IdxLoadOptions idxOptions;
+    IdxStatistics idxStatistics; // 训练集的归一化参数，测试集沿用
+    if (!idxImages.empty()) {
+        idxOptions.normalization = idxNormalizationFromName(config.getString("idx_normalize", "unit"));
+        idxOptions.limit = static_cast<size_t>(config.getInt("idx_limit", 0));
+        idxOptions.cachePath = config.getString("idx_cache", "");
+    }
+    std::unique_ptr<MappedDataset> mapped;
+    std::vector<Tensor> images;
+    std::vector<std::vector<double>> labels;
+    size_t channels = 1;
+    size_t height = 0;
+    size_t width = 0;
+    size_t numClasses = 0;
+
+    TrainingRun run;
+    if (!idxImages.empty()) {
+        const std::string idxLabels = config.getString("idx_labels", "");
+        const Clock::time_point start = Clock::now();
+        if (!idxOptions.cachePath.empty()) {
+            datasetFile = buildIdxCache(idxImages, idxLabels, idxOptions, &idxStatistics);
+        } else {
+            IdxDataset idx = loadIdxDataset(idxImages, idxLabels, idxOptions);
+            if (idx.images.empty()) {
+                throw std::runtime_error("IDX dataset has no samples: " + idxImages);
+            }
+            idxStatistics = idx.statistics;
+            images = std::move(idx.images);
+            labels = std::move(idx.labels);
+            channels = images.front().channels();
+            height = images.front().height();
+            width = images.front().width();
+            numClasses = idx.numClasses;
+            run.description = "CNN " + std::to_string(height) + "x" + std::to_string(width) + " from " +
+                              idxImages + ", " + std::to_string(numClasses) + " classes";
+            run.samplesPerEpoch = images.size();
+        }
+        std::cout << "Loaded " << idxImages << " in " << std::fixed << std::setprecision(3)
+                  << std::chrono::duration<double>(Clock::now() - start).count() << " s" << std::endl;
+    }
+
+    if (!datasetFile.empty()) {
+        mapped = std::make_unique<MappedDataset>(datasetFile);
+        if (mapped->empty()) {
+            throw std::runtime_error("Dataset file has no samples: " + datasetFile);
+        }
+        channels = mapped->channels();
+        height = mapped->height();
+        width = mapped->width();
+        numClasses = mapped->labelSize();
+        run.description = "CNN " + std::to_string(height) + "x" + std::to_string(width) + " from " +
+                          datasetFile + ", " + std::to_string(numClasses) + " classes";
+        run.samplesPerEpoch = mapped->size();
+    } else if (images.empty()) {
+        const int inputSize = config.getInt("image_size", 16);
+        const int classes = config.getInt("classes", 3);
+        makeShapeDataset(inputSize, classes, config.getInt("samples_per_class", 50), gen, images, labels);
+        height = width = static_cast<size_t>(inputSize);
+        numClasses = static_cast<size_t>(classes);
+        run.description = "CNN " + std::to_string(inputSize) + "x" + std::to_string(inputSize) + " shapes, " +
+                          std::to_string(classes) + " classes";
+        run.samplesPerEpoch = images.size();
+
+        const std::string exportPath = config.getString("export_dataset", "");
+        if (!exportPath.empty()) {
+            DatasetWriter writer(exportPath, channels, height, width, numClasses);
+            for (size_t i = 0; i < images.size(); ++i) {
+                writer.append(images[i], labels[i]);
+            }
+            writer.finish();
+            std::cout << "Wrote " << writer.size() << " samples to " << exportPath << std::endl;
+        }
+    }
+
+    // 与 CNNMainWindow::createNetwork 相同的结构
+    CNNNetwork network;
+    network.setInputSize(channels, height, width);
+    network.addConvLayer(config.getInt("conv1_filters", 8), kernelSize, 1, 1, CNNActivationType::ReLU);
+    network.addPoolingLayer(2, 2, PoolingType::Max);
+    network.addConvLayer(config.getInt("conv2_filters", 16), kernelSize, 1, 1, CNNActivationType::ReLU);
+    network.addPoolingLayer(2, 2, PoolingType::Max);
+    network.addFlattenLayer();
+    network.addDenseLayer(config.getInt("hidden_neurons", 64), ActivationType::ReLU);
+    network.addDenseLayer(numClasses, ActivationType::Sigmoid);
+    network.build();
+
+    const double learningRate = config.getDouble("learning_rate", 0.01);
+    const int epochs = config.getInt("epochs", 100);
+    const int logEvery = config.getInt("log_every", 10);
+    const size_t batchSize = static_cast<size_t>(config.getInt("batch_size", 32));
+    const ImageAugmenter augmenter = ImageAugmenter::fromSpec(config.getString("augment", ""));
+    if (!augmenter.empty()) {
+        // 增强在 augment_workers 个生成线程中进行，与训练重叠；按编号顺序循环遍历数据集，结果与线程数无关
+        const size_t count = mapped ? mapped->size() : images.size();
+        AugmentationSource source;
+        if (mapped) {
+            source = [&](size_t index) { return mapped->sample(index); };
+        } else {
+            source = [&](size_t index) { return TensorView(images[index]); };
+        }
+        const size_t workers = static_cast<size_t>(std::max(1, config.getInt("augment_workers", 2)));
+        std::unique_ptr<DataPipeline<Tensor>> pipeline = makeAugmentationPipeline(
+            augmenter, source, count, workers, 2 * batchSize, gen(),
+            static_cast<size_t>(std::max(0, epochs)) * count);
+        run.description += ", augment " + augmenter.spec();
+
+        std::vector<Tensor> batchImages(batchSize);
+        std::vector<TensorView> views;
+        std::vector<const double*> targets;
+        runEpochs(epochs, logEvery, run, [&]() {
+            double epochLoss = 0.0;
+            for (size_t trained = 0; trained < count;) {
+                const size_t n = std::min(batchSize, count - trained);
+                views.clear();
+                targets.clear();
+                for (size_t k = 0; k < n; ++k) {
+                    size_t index = 0;
+                    if (!pipeline->nextInOrder(batchImages[k], &index)) {
+                        throw std::runtime_error("Augmentation pipeline ended early");
+                    }
+                    index %= count;
+                    views.emplace_back(batchImages[k]);
+                    targets.push_back(mapped ? mapped->label(index) : labels[index].data());
+                }
+                epochLoss += network.trainBatch(views, targets, learningRate) * static_cast<double>(n);
+                trained += n;
+            }
+            return epochLoss / static_cast<double>(count);
+        });
+        const DataPipelineStats stats = pipeline->stats();
+        std::cout << "Augmentation: " << workers << " workers, trainer waited for samples "
+                  << stats.consumerStalls << " of " << stats.consumed << " times" << std::endl;
+    } else if (mapped) {
+        // 打乱的小批量零拷贝视图；读取下一批的页面与本批计算重叠
+        DatasetBatchReader reader(*mapped, batchSize, gen());
+        DatasetBatch batch;
+        runEpochs(epochs, logEvery, run, [&]() {
+            double epochLoss = 0.0;
+            while (reader.next(batch)) {
+                epochLoss += network.trainBatch(batch.inputs, batch.targets, learningRate) *
+                             static_cast<double>(batch.size());
+            }
+            reader.startEpoch();
+            return epochLoss / static_cast<double>(mapped->size());
+        });
+    } else {
+        network.setShuffle(config.getInt("shuffle", 0) != 0);
+        runEpochs(epochs, logEvery, run, [&]() {
+            return network.train(images, labels, learningRate);
+        });
+    }
+
+    // 可选的测试集：分类准确率（输出最大值与 one-hot 标签的类别一致）
+    const std::string testImages = config.getString("idx_test_images", "");
+    if (!testImages.empty()) {
+        IdxLoadOptions testOptions;
+        testOptions.normalization = idxOptions.normalization;
+        // 训练集来自 IDX 时沿用其归一化参数（standardize 用训练集的均值与标准差，而非测试集自身的）
+        testOptions.useStatistics = !idxImages.empty();
+        testOptions.statistics = idxStatistics;
+        testOptions.limit = static_cast<size_t>(config.getInt("idx_test_limit", 0));
+        IdxDataset test = loadIdxDataset(testImages, config.getString("idx_test_labels", ""), testOptions);
+        size_t correct = 0;
+        for (size_t i = 0; i < test.images.size(); ++i) {
+            const std::vector<double> output = network.forward(test.images[i]);
+            const auto predicted = std::max_element(output.begin(), output.end()) - output.begin();
+            const auto expected = std::max_element(test.labels[i].begin(), test.labels[i].end()) -
+                                  test.labels[i].begin();
+            if (predicted == expected) ++correct;
+        }
+        run.testSamples = test.images.size();
+        run.testAccuracy = test.images.empty() ? 0.0 : static_cast<double>(correct) / test.images.size();
+    }
+    return run;
+}
+
+static TrainingRun trainAttention(const Config& config, PhiloxRng& gen) {
+    const size_t seqLen = static_cast<size_t>(config.getInt("seq_len", 5));
+    const size_t dModel = static_cast<size_t>(config.getInt("d_model", 16));
+    const size_t layers = static_cast<size_t>(config.getInt("layers", 1));
+    const size_t heads = static_cast<size_t>(config.getInt("heads", 1));
+    const int batchSize = config.getInt("batch_size", 50);
+
+    const std::string positional = config.getString("positional", "sinusoidal");
+    PositionalEncodingType posEncoding = PositionalEncodingType::Sinusoidal;
+    if (positional == "learned") posEncoding = PositionalEncodingType::Learned;
+    else if (positional == "rotary") posEncoding = PositionalEncodingType::Rotary;
+    else if (positional != "sinusoidal") throw std::invalid_argument("Unknown positional encoding: " + positional);
+
+    const std::string attention = config.getString("attention", "softmax");
+    AttentionType attentionType = AttentionType::Softmax;
+    if (attention == "linear") attentionType = AttentionType::Linear;
+    else if (attention != "softmax") throw std::invalid_argument("Unknown attention type: " + attention);
+
+    // 与 AttentionMainWindow::createNetwork 相同：d_k = d_model, d_ff = 2 * d_model
+    AttentionNetwork network(seqLen, dModel, dModel, 2 * dModel, layers, heads, posEncoding, attentionType);
+
+    TrainingRun run;
+    run.description = "Attention sort, L=" + std::to_string(seqLen) + ", D=" + std::to_string(dModel) +
+                      ", " + std::to_string(layers) + " layer(s), " + std::to_string(heads) + " head(s), " +
+                      attention;
+    run.samplesPerEpoch = static_cast<size_t>(batchSize);
+    run.tokensPerSample = seqLen;
+
+    // data_workers > 0：样本由生成线程预取（与 GUI 相同）；0：在训练线程内逐个生成。
+    // 样本只由 seed 与编号决定并按编号取出，结果可由 seed 复现，与生成线程数无关
+    const int dataWorkers = config.getInt("data_workers", 0);
+    using SortSample = std::pair<Tensor, Tensor>;
+    std::unique_ptr<DataPipeline<SortSample>> pipeline;
+    if (dataWorkers > 0) {
+        pipeline = std::make_unique<DataPipeline<SortSample>>(
+            [seqLen](size_t, PhiloxRng& workerGen) {
+                SortSample sample;
+                makeSortSample(seqLen, workerGen, sample.first, sample.second);
+                return sample;
+            },
+            static_cast<size_t>(dataWorkers), static_cast<size_t>(config.getInt("prefetch", 2 * batchSize)),
+            gen());
+    }
+
+    const double learningRate = config.getDouble("learning_rate", 0.01);
+    SortSample sample;
+    runEpochs(config.getInt("epochs", 1000), config.getInt("log_every", 100), run, [&]() {
+        double epochLoss = 0.0;
+        for (int b = 0; b < batchSize; ++b) {
+            if (pipeline) {
+                pipeline->nextInOrder(sample);
+            } else {
+                makeSortSample(seqLen, gen, sample.first, sample.second);
+            }
+            network.forward(sample.first);
+            epochLoss += network.backward(sample.second, learningRate);
+        }
+        return epochLoss / batchSize;
+    });
+    if (pipeline) {
+        std::cout << "Data pipeline: " << pipeline->numWorkers() << " worker(s), "
+                  << pipeline->stats().consumerStalls << " stall(s) waiting for samples" << std::endl;
+    }
+    return run;
+}
+
+static void writeLossCurve(const std::string& path, const std::vector<LossPoint>& curve) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot write loss curve: " + path);
+    }
+    file << "epoch,loss\n" << std::setprecision(10);
+    for (const LossPoint& point : curve) {
+        file << point.epoch << "," << point.loss << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <config> [key=value ...]" << std::endl;
+        return 2;
+    }
+
+    try {
+        Config config = loadConfig(argv[1]);
+        for (int i = 2; i < argc; ++i) {
+            if (!parseAssignment(argv[i], config)) {
+                throw std::runtime_error(std::string("Expected key=value, got: ") + argv[i]);
+            }
+        }
+
+        // seed 决定初始权重、合成数据、打乱顺序与生成线程的样本，重复运行逐位一致
+        const uint64_t seed = static_cast<uint64_t>(config.getInt("seed", 42));
+        setGlobalSeed(seed);
+        PhiloxRng gen(seed);
+
+        const std::string model = config.getString("model", "mlp");
+        TrainingRun run;
+        if (model == "mlp") {
+            run = trainMLP(config, gen);
+        } else if (model == "cnn") {
+            run = trainCNN(config, gen);
+        } else if (model == "attention") {
+            run = trainAttention(config, gen);
+        } else {
+            throw std::invalid_argument("Unknown model: " + model + " (expected mlp, cnn or attention)");
+        }
+
+        const std::string lossCsv = config.getString("loss_csv", "");
+        if (!lossCsv.empty()) {
+            writeLossCurve(lossCsv, run.curve);
+        }
+
+        for (const std::string& key : config.unusedKeys()) {
+            std::cerr << "Warning: unused config key '" << key << "'" << std::endl;
+        }
+
+        const double epochs = static_cast<double>(run.curve.size());
+        const double samples = epochs * static_cast<double>(run.samplesPerEpoch);
+        std::cout << "\n" << run.description << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Epochs: " << run.curve.size() << ", samples/epoch: " << run.samplesPerEpoch << std::endl;
+        std::cout << "Time: " << run.seconds << " s" << std::endl;
+        std::cout << "Throughput: " << epochs / run.seconds << " epochs/s, " << samples / run.seconds
+                  << " samples/s";
+        if (run.tokensPerSample > 1) {
+            std::cout << ", " << samples * static_cast<double>(run.tokensPerSample) / run.seconds << " tokens/s";
+        }
+        std::cout << std::endl;
+        if (!run.curve.empty()) {
+            std::cout << std::setprecision(6) << "Final loss: " << run.curve.back().loss << std::endl;
+        }
+        if (run.testSamples > 0) {
+            std::cout << std::setprecision(2) << "Test accuracy: " << 100.0 * run.testAccuracy << "% ("
+                      << run.testSamples << " samples)" << std::endl;
+        }
+        if (!lossCsv.empty()) {
+            std::cout << "Loss curve written to " << lossCsv << std::endl;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}